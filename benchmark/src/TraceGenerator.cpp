@@ -0,0 +1,393 @@
+#include "TraceGenerator.h"
+
+#include "mmpr/mmpr.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#ifdef MMPR_USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace mmpr {
+
+namespace {
+
+constexpr uint32_t ETHERNET_HEADER_LENGTH = 14;
+constexpr uint32_t IPV4_HEADER_LENGTH = 20;
+constexpr uint32_t UDP_HEADER_LENGTH = 8;
+constexpr uint32_t TCP_HEADER_LENGTH = 20;
+// every fifth flow is UDP, like in a typical backbone mix
+constexpr uint32_t UDP_FLOW_INTERVAL = 5;
+
+// Enhanced Packet Block options: epb_flags (inbound), epb_hash (CRC32 digest padded to
+// 8 bytes), epb_dropcount and opt_endofopt
+constexpr uint32_t PACKET_OPTIONS_LENGTH = 8 + 12 + 12 + 4;
+
+void put16(uint8_t* data, uint16_t value) {
+    // network byte order, for the packet headers
+    data[0] = value >> 8;
+    data[1] = value & 0xFF;
+}
+
+void put32(uint8_t* data, uint32_t value) {
+    put16(data, value >> 16);
+    put16(&data[2], value & 0xFFFF);
+}
+
+} // namespace
+
+TraceGenerator::TraceGenerator(Config config)
+    : mConfig(std::move(config)), mRandom(mConfig.seed) {
+    if (mConfig.flows == 0 || mConfig.interfaces == 0 || mConfig.packetRate <= 0) {
+        throw std::runtime_error("TraceGenerator needs at least one flow, one interface "
+                                 "and a positive packet rate");
+    }
+    if (mConfig.sizeDistribution == EMPIRICAL) {
+        std::unique_ptr<FileReader> reader =
+            FileReader::getReader(mConfig.empiricalTrace);
+        reader->open();
+        Packet packet;
+        while (!reader->isExhausted()) {
+            if (reader->readNextPacket(packet)) {
+                mEmpiricalLengths.push_back(packet.length);
+            }
+        }
+        reader->close();
+        if (mEmpiricalLengths.empty()) {
+            throw std::runtime_error("Trace " + mConfig.empiricalTrace +
+                                     " has no packets to sample lengths from");
+        }
+    }
+
+    mFlows.resize(mConfig.flows);
+    for (uint32_t i = 0; i < mConfig.flows; ++i) {
+        Flow& flow = mFlows[i];
+        uint8_t* header = flow.header;
+        memset(header, 0, sizeof(flow.header));
+        const bool udp = i % UDP_FLOW_INTERVAL == 0;
+        // Ethernet, locally administered addresses
+        const uint64_t random = mRandom();
+        header[0] = 0x02;
+        memcpy(&header[1], &random, 5);
+        header[6] = 0x02;
+        memcpy(&header[7], &i, 4);
+        put16(&header[12], 0x0800);
+        // IPv4 from 10.0.0.0/8 to a random address, total length set per packet
+        uint8_t* ip = &header[ETHERNET_HEADER_LENGTH];
+        ip[0] = 0x45;
+        ip[8] = 64;
+        ip[9] = udp ? 17 : 6;
+        put32(&ip[12], 0x0A000000 | (i & 0xFFFFFF));
+        put32(&ip[16], (uint32_t)(random >> 32));
+        // ports
+        uint8_t* transport = &ip[IPV4_HEADER_LENGTH];
+        put16(&transport[0], 1024 + (uint16_t)(mRandom() % 64512));
+        put16(&transport[2], udp ? 53 : 443);
+        if (!udp) {
+            // data offset of 5 words, ACK
+            transport[12] = 0x50;
+            transport[13] = 0x10;
+        }
+        flow.headerLength = ETHERNET_HEADER_LENGTH + IPV4_HEADER_LENGTH +
+                            (udp ? UDP_HEADER_LENGTH : TCP_HEADER_LENGTH);
+    }
+
+    mPayload.resize(65536);
+    for (size_t i = 0; i < mPayload.size(); i += 8) {
+        const uint64_t random = mRandom();
+        memcpy(&mPayload[i], &random, 8);
+    }
+}
+
+uint64_t TraceGenerator::generate(const std::string& filepath) {
+    mFile = fopen(filepath.c_str(), "wb");
+    if (mFile == nullptr) {
+        throw std::runtime_error("Cannot write trace " + filepath + ": " +
+                                 strerror(errno));
+    }
+    setvbuf(mFile, nullptr, _IOFBF, 1 << 20);
+    mWritten = 0;
+
+    std::uniform_int_distribution<uint32_t> flowDistribution(0, mConfig.flows - 1);
+    uint64_t packets = 0;
+    uint64_t timestamp = mConfig.startTime;
+    try {
+        writeFileHeader();
+        while (mWritten < mConfig.size) {
+            writePacket(timestamp, nextPacketLength(), flowDistribution(mRandom));
+            timestamp += nextGap(packets);
+            ++packets;
+        }
+    } catch (...) {
+        fclose(mFile);
+        mFile = nullptr;
+        throw;
+    }
+    if (fclose(mFile) != 0) {
+        mFile = nullptr;
+        throw std::runtime_error("Cannot write trace " + filepath + ": " +
+                                 strerror(errno));
+    }
+    mFile = nullptr;
+
+    if (mConfig.zstd && mConfig.format == PCAPNG) {
+        compress(filepath);
+    }
+    return packets;
+}
+
+void TraceGenerator::writeFileHeader() {
+    const uint32_t snapLength = mConfig.snapLength != 0 ? mConfig.snapLength : 262144;
+    if (mConfig.format == PCAP || mConfig.format == MODIFIED_PCAP) {
+        const uint32_t magicNumber = mConfig.format == PCAP
+                                         ? MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS
+                                         : MMPR_MAGIC_NUMBER_MODIFIED_PCAP;
+        const uint16_t version[2]{2, 4};
+        const uint32_t fields[4]{0, 0, snapLength, 1 /* Ethernet */};
+        write(&magicNumber, 4);
+        write(version, 4);
+        write(fields, 16);
+        return;
+    }
+
+    // Section Header Block without options, section length unknown
+    const uint32_t shb[4]{MMPR_SECTION_HEADER_BLOCK, 28, MMPR_BYTE_ORDER_MAGIC, 1};
+    const int64_t sectionLength = -1;
+    write(shb, 16);
+    write(&sectionLength, 8);
+    write(&shb[1], 4);
+
+    // Interface Description Blocks with nanosecond resolution (if_tsresol 9)
+    for (uint32_t i = 0; i < mConfig.interfaces; ++i) {
+        const uint32_t idb[3]{MMPR_INTERFACE_DESCRIPTION_BLOCK, 32, 1 /* Ethernet */};
+        const uint16_t tsresol[2]{MMPR_BLOCK_OPTION_IDB_TSRESOL, 1};
+        const uint8_t resolution[4]{9, 0, 0, 0};
+        const uint32_t endOfOptions = MMPR_BLOCK_OPTION_END_OF_OPT;
+        write(idb, 12);
+        write(&snapLength, 4);
+        write(tsresol, 4);
+        write(resolution, 4);
+        write(&endOfOptions, 4);
+        write(&idb[1], 4);
+    }
+}
+
+void TraceGenerator::writePacket(uint64_t timestamp,
+                                 uint32_t length,
+                                 uint32_t flowIndex) {
+    const uint32_t captureLength =
+        mConfig.snapLength != 0 ? std::min(length, mConfig.snapLength) : length;
+    const Flow& flow = mFlows[flowIndex];
+    // PcapNG only
+    const uint32_t padding = (4 - captureLength % 4) % 4;
+    const uint32_t blockTotalLength = 32 + captureLength + padding +
+                                      (mConfig.packetOptions ? PACKET_OPTIONS_LENGTH : 0);
+
+    switch (mConfig.format) {
+    case PCAP: {
+        const uint32_t record[4]{(uint32_t)(timestamp / 1000000000),
+                                 (uint32_t)(timestamp % 1000000000 / 1000),
+                                 captureLength, length};
+        write(record, 16);
+        break;
+    }
+    case MODIFIED_PCAP: {
+        const uint32_t record[5]{(uint32_t)(timestamp / 1000000000),
+                                 (uint32_t)(timestamp % 1000000000 / 1000),
+                                 captureLength, length,
+                                 flowIndex % mConfig.interfaces};
+        const uint16_t protocol = 0x0800;
+        const uint8_t packetType[2]{0, 0};
+        write(record, 20);
+        write(&protocol, 2);
+        write(packetType, 2);
+        break;
+    }
+    case PCAPNG: {
+        const uint32_t epb[7]{MMPR_ENHANCED_PACKET_BLOCK,
+                              blockTotalLength,
+                              flowIndex % mConfig.interfaces,
+                              (uint32_t)(timestamp >> 32),
+                              (uint32_t)timestamp,
+                              captureLength,
+                              length};
+        write(epb, 28);
+        break;
+    }
+    }
+
+    // headers of the flow with the lengths of this packet, then random payload
+    uint8_t header[sizeof(Flow::header)];
+    memcpy(header, flow.header, flow.headerLength);
+    uint8_t* ip = &header[ETHERNET_HEADER_LENGTH];
+    put16(&ip[2], (uint16_t)std::min<uint32_t>(
+                      length > ETHERNET_HEADER_LENGTH ? length - ETHERNET_HEADER_LENGTH
+                                                      : 0,
+                      65535));
+    if (ip[9] == 17) {
+        put16(&ip[IPV4_HEADER_LENGTH + 4],
+              (uint16_t)std::min<uint32_t>(
+                  length > ETHERNET_HEADER_LENGTH + IPV4_HEADER_LENGTH
+                      ? length - ETHERNET_HEADER_LENGTH - IPV4_HEADER_LENGTH
+                      : 0,
+                  65535));
+    }
+    const uint32_t headerLength = std::min(captureLength, flow.headerLength);
+    write(header, headerLength);
+    uint32_t remaining = captureLength - headerLength;
+    while (remaining > 0) {
+        const uint32_t chunk = std::min<uint32_t>(remaining, mPayload.size() - 64);
+        write(&mPayload[mRandom() % 64], chunk);
+        remaining -= chunk;
+    }
+
+    if (mConfig.format == PCAPNG) {
+        writePadding(padding);
+        if (mConfig.packetOptions) {
+            const uint16_t flags[2]{MMPR_BLOCK_OPTION_EPB_FLAGS, 4};
+            const uint32_t inbound = 1;
+            const uint16_t hash[2]{MMPR_BLOCK_OPTION_EPB_HASH, 5};
+            uint8_t digest[8]{2 /* CRC32 */};
+            put32(&digest[1], flowIndex * 2654435761u);
+            const uint16_t dropCount[2]{MMPR_BLOCK_OPTION_EPB_DROPCOUNT, 8};
+            const uint64_t dropped = 0;
+            const uint32_t endOfOptions = MMPR_BLOCK_OPTION_END_OF_OPT;
+            write(flags, 4);
+            write(&inbound, 4);
+            write(hash, 4);
+            write(digest, 8);
+            write(dropCount, 4);
+            write(&dropped, 8);
+            write(&endOfOptions, 4);
+        }
+        write(&blockTotalLength, 4);
+    }
+}
+
+uint32_t TraceGenerator::nextPacketLength() {
+    switch (mConfig.sizeDistribution) {
+    case FIXED:
+        return mConfig.packetSize;
+    case IMIX: {
+        const uint64_t choice = mRandom() % 12;
+        return choice < 7 ? 64 : choice < 11 ? 594 : 1518;
+    }
+    case EMPIRICAL:
+        return mEmpiricalLengths[mRandom() % mEmpiricalLengths.size()];
+    }
+    return mConfig.packetSize;
+}
+
+uint64_t TraceGenerator::nextGap(uint64_t packetIndex) {
+    const double meanGap = 1e9 / mConfig.packetRate;
+    switch (mConfig.timestampPattern) {
+    case CONSTANT:
+        // without accumulating the rounding error of the gaps
+        return (uint64_t)((packetIndex + 1) * meanGap) -
+               (uint64_t)(packetIndex * meanGap);
+    case POISSON:
+        return (uint64_t)std::exponential_distribution<double>(1 / meanGap)(mRandom);
+    case BURST: {
+        const uint32_t burstLength = std::max<uint32_t>(mConfig.burstLength, 1);
+        if ((packetIndex + 1) % burstLength != 0) {
+            return 1000;
+        }
+        const double burstGap = burstLength * meanGap - (burstLength - 1) * 1000.0;
+        return burstGap <= 0 ? 1000
+                             : (uint64_t)std::exponential_distribution<double>(
+                                   1 / burstGap)(mRandom);
+    }
+    }
+    return (uint64_t)meanGap;
+}
+
+void TraceGenerator::write(const void* data, size_t length) {
+    if (fwrite(data, 1, length, mFile) != length) {
+        throw std::runtime_error(std::string("Cannot write trace: ") + strerror(errno));
+    }
+    mWritten += length;
+}
+
+void TraceGenerator::writePadding(size_t length) {
+    const uint8_t zeros[4]{};
+    write(zeros, length);
+}
+
+void TraceGenerator::compress(const std::string& filepath) {
+#ifdef MMPR_USE_ZSTD
+    FILE* input = fopen(filepath.c_str(), "rb");
+    FILE* output = fopen((filepath + ".zst").c_str(), "wb");
+    if (input == nullptr || output == nullptr) {
+        if (input != nullptr) {
+            fclose(input);
+        }
+        if (output != nullptr) {
+            fclose(output);
+        }
+        throw std::runtime_error("Cannot compress trace " + filepath + ": " +
+                                 strerror(errno));
+    }
+    fseek(input, 0, SEEK_END);
+    const long inputSize = ftell(input);
+    fseek(input, 0, SEEK_SET);
+
+    // the readers need the content size in the frame header
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, 3);
+    ZSTD_CCtx_setPledgedSrcSize(context, (unsigned long long)inputSize);
+    std::vector<uint8_t> inputBuffer(ZSTD_CStreamInSize());
+    std::vector<uint8_t> outputBuffer(ZSTD_CStreamOutSize());
+    bool failed = false;
+    size_t read;
+    do {
+        read = fread(inputBuffer.data(), 1, inputBuffer.size(), input);
+        const ZSTD_EndDirective mode = read < inputBuffer.size() ? ZSTD_e_end
+                                                                 : ZSTD_e_continue;
+        ZSTD_inBuffer in{inputBuffer.data(), read, 0};
+        size_t remaining;
+        do {
+            ZSTD_outBuffer out{outputBuffer.data(), outputBuffer.size(), 0};
+            remaining = ZSTD_compressStream2(context, &out, &in, mode);
+            if (ZSTD_isError(remaining) ||
+                fwrite(outputBuffer.data(), 1, out.pos, output) != out.pos) {
+                failed = true;
+                break;
+            }
+        } while (mode == ZSTD_e_end ? remaining != 0 : in.pos < in.size);
+    } while (!failed && read == inputBuffer.size());
+
+    ZSTD_freeCCtx(context);
+    fclose(input);
+    if (fclose(output) != 0 || failed) {
+        throw std::runtime_error("Cannot compress trace " + filepath);
+    }
+#else
+    throw std::runtime_error("Cannot compress trace " + filepath +
+                             ", mmpr was built without Zstd");
+#endif
+}
+
+uint64_t TraceGenerator::parseSize(const std::string& size) {
+    size_t end = 0;
+    const uint64_t value = std::stoull(size, &end);
+    if (end == size.size()) {
+        return value;
+    }
+    if (end + 1 == size.size()) {
+        switch (size[end]) {
+        case 'K':
+        case 'k':
+            return value << 10;
+        case 'M':
+        case 'm':
+            return value << 20;
+        case 'G':
+        case 'g':
+            return value << 30;
+        }
+    }
+    throw std::invalid_argument("Invalid size " + size);
+}
+
+} // namespace mmpr
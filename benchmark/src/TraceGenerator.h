@@ -0,0 +1,106 @@
+#ifndef MMPR_TRACEGENERATOR_H
+#define MMPR_TRACEGENERATOR_H
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Writes synthetic traces of a configurable size for benchmarks that do not fit into
+ * the caches. Packets are Ethernet/IPv4 frames of a fixed set of UDP and TCP flows,
+ * the payload is random.
+ */
+class TraceGenerator {
+public:
+    enum Format { PCAP, PCAPNG, MODIFIED_PCAP };
+    enum SizeDistribution {
+        // every packet has Config::packetSize bytes
+        FIXED,
+        // simple IMIX, 64, 594 and 1518 bytes in the ratio 7:4:1
+        IMIX,
+        // lengths sampled from the packets of Config::empiricalTrace
+        EMPIRICAL
+    };
+    enum TimestampPattern {
+        // packets at a fixed interval of 1 / Config::packetRate
+        CONSTANT,
+        // exponentially distributed gaps with a mean of 1 / Config::packetRate
+        POISSON,
+        // bursts of Config::burstLength packets 1 us apart, exponentially distributed
+        // gaps between the bursts keep the mean rate
+        BURST
+    };
+
+    struct Config {
+        Format format{PCAPNG};
+        // the trace ends with the first packet that reaches the size
+        uint64_t size{64 * 1024 * 1024};
+        SizeDistribution sizeDistribution{IMIX};
+        uint32_t packetSize{512};
+        std::string empiricalTrace;
+        // captured lengths are truncated to the snapshot length, 0 is unlimited
+        uint32_t snapLength{0};
+        uint32_t flows{1024};
+        TimestampPattern timestampPattern{CONSTANT};
+        // packets per second
+        double packetRate{1000000};
+        uint32_t burstLength{32};
+        // nanoseconds since 1970-01-01 00:00:00 UTC of the first packet
+        uint64_t startTime{1600000000ull * 1000000000};
+        // PcapNG only, packets are assigned to interfaces by flow
+        uint32_t interfaces{1};
+        // PcapNG only, Enhanced Packet Blocks carry flags, hash and drop count options
+        bool packetOptions{false};
+        // PcapNG only, additionally writes a Zstd compressed copy to <filepath>.zst
+        bool zstd{false};
+        uint64_t seed{1};
+    };
+
+    explicit TraceGenerator(Config config);
+
+    /**
+     * Writes the trace, throws a std::runtime_error if the file cannot be written.
+     *
+     * @return number of packets written
+     */
+    uint64_t generate(const std::string& filepath);
+
+    /**
+     * Parses sizes with an optional K, M or G suffix (powers of 1024).
+     */
+    static uint64_t parseSize(const std::string& size);
+
+private:
+    struct Flow {
+        uint8_t header[54];
+        uint32_t headerLength;
+    };
+
+    void writeFileHeader();
+    void writePacket(uint64_t timestamp, uint32_t length, uint32_t flowIndex);
+    uint32_t nextPacketLength();
+    uint64_t nextGap(uint64_t packetIndex);
+    void write(const void* data, size_t length);
+    void writePadding(size_t length);
+    /**
+     * Compresses filepath into filepath.zst with the content size in the frame header.
+     */
+    static void compress(const std::string& filepath);
+
+    Config mConfig;
+    std::mt19937_64 mRandom;
+    std::vector<Flow> mFlows;
+    std::vector<uint32_t> mEmpiricalLengths;
+    // random bytes the payloads are copied from
+    std::vector<uint8_t> mPayload;
+    FILE* mFile{nullptr};
+    uint64_t mWritten{0};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_TRACEGENERATOR_H
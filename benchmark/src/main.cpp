@@ -1,4 +1,17 @@
 #include <benchmark/benchmark.h>
 
+// defined in throughput_harness.cpp, the large traces are generated by the first
+// benchmark that reads them
+void registerThroughputHarness();
+
 // Run the benchmarks
-BENCHMARK_MAIN();
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    registerThroughputHarness();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
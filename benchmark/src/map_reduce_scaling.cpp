@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+
+#include "mmpr/MapReduceJob.h"
+#include <filesystem>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Scaling of MapReduceJob with the number of worker processes: a job over copies of the
+ * example trace, split into ranges, is planned, mapped by forked workers and reduced.
+ * The speedup over one worker is bounded by the number of cores, the claims and the
+ * fork of every worker.
+ */
+namespace {
+
+// copies of the example trace, each split into ranges of MAP_REDUCE_SPLIT_SIZE bytes
+constexpr size_t MAP_REDUCE_FILES = 8;
+constexpr uint64_t MAP_REDUCE_SPLIT_SIZE = 512 * 1024;
+
+void bmMapReduceWorkers(benchmark::State& state) {
+    const size_t workers = (size_t)state.range(0);
+    const std::filesystem::path directory =
+        std::filesystem::temp_directory_path() /
+        ("mmpr-benchmark-map-reduce-" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> files;
+    for (size_t i = 0; i < MAP_REDUCE_FILES; ++i) {
+        const std::filesystem::path file =
+            directory / ("trace-" + std::to_string(i) + ".pcap");
+        std::filesystem::copy_file("tracefiles/example.pcap", file,
+                                   std::filesystem::copy_options::overwrite_existing);
+        files.push_back(file.string());
+    }
+
+    uint64_t packets{0};
+    for (auto _ : state) {
+        mmpr::MapReduceJob job((directory / "job").string());
+        job.plan(files, MAP_REDUCE_SPLIT_SIZE);
+        job.runWorkers(workers);
+        packets += job.reduce().packets;
+    }
+    state.counters["packets/s"] =
+        benchmark::Counter((double)packets, benchmark::Counter::kIsRate);
+    std::filesystem::remove_all(directory);
+}
+
+} // namespace
+
+BENCHMARK(bmMapReduceWorkers)
+    ->Name("map_reduce/workers")
+    ->RangeMultiplier(2)
+    ->Range(1, 8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,75 @@
+#include <benchmark/benchmark.h>
+
+#include "mmpr/PacketDispatcher.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include <atomic>
+
+#define DISPATCH_PCAP_FILE "tracefiles/example.pcap"
+
+/**
+ * Touches every byte of the packet, stands in for per-packet processing of the workers.
+ */
+static uint64_t checksum(const mmpr::Packet& packet) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < packet.captureLength; ++i) {
+        sum += packet.data[i];
+    }
+    return sum;
+}
+
+static void bmDispatchWorkers(benchmark::State& state) {
+    mmpr::PacketDispatcher::Config config;
+    config.workers = state.range(0);
+
+    uint64_t packets{0};
+    for (auto _ : state) {
+        mmpr::MMPcapReader reader(DISPATCH_PCAP_FILE);
+        reader.open();
+
+        std::atomic<uint64_t> sum{0};
+        std::atomic<uint64_t> packetCount{0};
+        mmpr::PacketDispatcher dispatcher(reader, config);
+        dispatcher.dispatch([&](size_t, const mmpr::Packet* batch, size_t count) {
+            uint64_t batchSum = 0;
+            for (size_t i = 0; i < count; ++i) {
+                batchSum += checksum(batch[i]);
+            }
+            sum.fetch_add(batchSum, std::memory_order_relaxed);
+            packetCount.fetch_add(count, std::memory_order_relaxed);
+        });
+        benchmark::DoNotOptimize(sum.load());
+        packets += packetCount;
+
+        reader.close();
+    }
+    state.counters["packets/s"] =
+        benchmark::Counter((double)packets, benchmark::Counter::kIsRate);
+}
+
+static void bmDispatchSequentialBaseline(benchmark::State& state) {
+    uint64_t packets{0};
+    for (auto _ : state) {
+        mmpr::MMPcapReader reader(DISPATCH_PCAP_FILE);
+        reader.open();
+
+        uint64_t sum{0};
+        mmpr::Packet packet;
+        while (reader.readNextPacket(packet)) {
+            sum += checksum(packet);
+            ++packets;
+        }
+        benchmark::DoNotOptimize(sum);
+
+        reader.close();
+    }
+    state.counters["packets/s"] =
+        benchmark::Counter((double)packets, benchmark::Counter::kIsRate);
+}
+
+BENCHMARK(bmDispatchSequentialBaseline)->Name("mmpr dispatch (sequential baseline)");
+BENCHMARK(bmDispatchWorkers)
+    ->Name("mmpr dispatch (workers)")
+    ->RangeMultiplier(2)
+    ->Range(1, 32)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -1,22 +1,22 @@
 #include <benchmark/benchmark.h>
 
+#include "mmpr/forEachPacket.h"
 #include "mmpr/pcap/MMPcapReader.h"
 #include "mmpr/pcapng/MMPcapNgReader.h"
 #include "mmpr/pcapng/ZstdPcapNgReader.h"
 #include <PcapFileDevice.h>
 #include <pcap.h>
 
-#define SAMPLE_PCAPNG_FILE tracefiles / pcapng - example.pcapng
-#define SAMPLE_PCAP_FILE tracefiles / example.pcap
-#define Q(x) #x
-#define QUOTE(x) Q(x)
-#define ZST(file) QUOTE(file.zst)
-#define ZSTD(file) QUOTE(file.zstd)
+#define SAMPLE_PCAPNG_FILE "tracefiles/pcapng-example.pcapng"
+#define SAMPLE_PCAP_FILE "tracefiles/example.pcap"
+#define MANY_INTERFACES_PCAPNG_FILE "tracefiles/many_interfaces-1.pcapng"
+#define ZST(file) file ".zst"
+#define ZSTD(file) file ".zstd"
 
 static void bmMmprPcap(benchmark::State& state) {
     mmpr::Packet packet;
     for (auto _ : state) {
-        mmpr::MMPcapReader reader(QUOTE(SAMPLE_PCAP_FILE));
+        mmpr::MMPcapReader reader(SAMPLE_PCAP_FILE);
         reader.open();
 
         uint64_t packetCount{0};
@@ -34,7 +34,7 @@ static void bmMmprPcap(benchmark::State& state) {
 static void bmMmprPcapNG(benchmark::State& state) {
     mmpr::Packet packet;
     for (auto _ : state) {
-        mmpr::MMPcapNgReader reader(QUOTE(SAMPLE_PCAPNG_FILE));
+        mmpr::MMPcapNgReader reader(SAMPLE_PCAPNG_FILE);
         reader.open();
 
         uint64_t packetCount{0};
@@ -67,10 +67,149 @@ static void bmMmprPcapNGZst(benchmark::State& state) {
     benchmark::DoNotOptimize(packet);
 }
 
+static void bmMmprPcapRange(benchmark::State& state) {
+    mmpr::Packet last;
+    for (auto _ : state) {
+        mmpr::MMPcapReader reader(SAMPLE_PCAP_FILE);
+        reader.open();
+
+        uint64_t packetCount{0};
+        for (const mmpr::Packet& packet : reader.packets()) {
+            last = packet;
+            ++packetCount;
+        }
+
+        reader.close();
+    }
+    benchmark::DoNotOptimize(last);
+}
+
+static void bmMmprPcapNGRange(benchmark::State& state) {
+    mmpr::Packet last;
+    for (auto _ : state) {
+        mmpr::MMPcapNgReader reader(SAMPLE_PCAPNG_FILE);
+        reader.open();
+
+        uint64_t packetCount{0};
+        for (const mmpr::Packet& packet : reader.packets()) {
+            last = packet;
+            ++packetCount;
+        }
+
+        reader.close();
+    }
+    benchmark::DoNotOptimize(last);
+}
+
+/**
+ * Reads all packets through the virtual FileReader interface, one indirect call per
+ * packet.
+ */
+static void bmMmprVirtualLoop(benchmark::State& state, const char* filepath) {
+    uint64_t bytes{0};
+    for (auto _ : state) {
+        auto reader = mmpr::FileReader::getReader(filepath);
+        reader->open();
+
+        mmpr::Packet packet;
+        while (reader->readNextPacket(packet)) {
+            bytes += packet.captureLength;
+        }
+
+        reader->close();
+    }
+    benchmark::DoNotOptimize(bytes);
+}
+
+/**
+ * Reads all packets with forEachPacket, the reader type is resolved once and the
+ * lambda is inlined into the parse loop.
+ */
+static void bmMmprForEachPacket(benchmark::State& state, const char* filepath) {
+    uint64_t bytes{0};
+    for (auto _ : state) {
+        auto reader = mmpr::FileReader::getReader(filepath);
+        reader->open();
+
+        mmpr::forEachPacket(*reader, [&](const mmpr::Packet& packet) {
+            bytes += packet.captureLength;
+        });
+
+        reader->close();
+    }
+    benchmark::DoNotOptimize(bytes);
+}
+
+/**
+ * Reads all packets of a trace whose Enhanced Packet Blocks have options. The packet
+ * loop only reads the fixed fields and jumps by the block total length, decoding the
+ * options of every packet shows what walking them costs.
+ */
+static void bmMmprPcapNGOptions(benchmark::State& state, bool decodeOptions) {
+    uint64_t bytes{0};
+    mmpr::PacketOptions options;
+    for (auto _ : state) {
+        mmpr::MMPcapNgReader reader(SAMPLE_PCAPNG_FILE);
+        reader.open();
+
+        mmpr::Packet packet;
+        while (reader.readNextPacket(packet)) {
+            bytes += packet.captureLength;
+            if (decodeOptions) {
+                mmpr::PcapNgReader::readPacketOptions(packet, options);
+            }
+        }
+
+        reader.close();
+    }
+    benchmark::DoNotOptimize(bytes);
+    benchmark::DoNotOptimize(options);
+}
+
+/**
+ * Opens a trace with many Interface Description Blocks and walks all of its blocks, the
+ * metadata is kept as views into the trace and never copied.
+ */
+static void bmMmprPcapNGBlocks(benchmark::State& state) {
+    uint64_t blocks{0};
+    for (auto _ : state) {
+        mmpr::MMPcapNgReader reader(MANY_INTERFACES_PCAPNG_FILE);
+        reader.open();
+
+        while (!reader.isExhausted()) {
+            reader.readBlock();
+            ++blocks;
+        }
+
+        reader.close();
+    }
+    benchmark::DoNotOptimize(blocks);
+}
+
+/**
+ * Reads all packets with forEachPacket at a validation level, the difference to NONE is
+ * the overhead of the bounds checks.
+ */
+static void bmMmprValidation(benchmark::State& state, mmpr::ValidationLevel level) {
+    uint64_t bytes{0};
+    for (auto _ : state) {
+        mmpr::MMPcapNgReader reader(SAMPLE_PCAPNG_FILE);
+        reader.setValidationLevel(level);
+        reader.open();
+
+        mmpr::forEachPacket(reader, [&](const mmpr::Packet& packet) {
+            bytes += packet.captureLength;
+        });
+
+        reader.close();
+    }
+    benchmark::DoNotOptimize(bytes);
+}
+
 static void bmPcapPlusPlusPcap(benchmark::State& state) {
     pcpp::RawPacket packet;
     for (auto _ : state) {
-        pcpp::PcapFileReaderDevice reader(QUOTE(SAMPLE_PCAP_FILE));
+        pcpp::PcapFileReaderDevice reader(SAMPLE_PCAP_FILE);
         reader.open();
 
         uint64_t packetCount{0};
@@ -86,7 +225,7 @@ static void bmPcapPlusPlusPcap(benchmark::State& state) {
 static void bmPcapPlusPlusPcapNG(benchmark::State& state) {
     pcpp::RawPacket packet;
     for (auto _ : state) {
-        pcpp::PcapNgFileReaderDevice reader(QUOTE(SAMPLE_PCAPNG_FILE));
+        pcpp::PcapNgFileReaderDevice reader(SAMPLE_PCAPNG_FILE);
         reader.open();
 
         uint64_t packetCount{0};
@@ -119,7 +258,7 @@ static void bmLibpcapPcap(benchmark::State& state) {
     const std::uint8_t* packet;
     for (auto _ : state) {
         char errBuf[PCAP_ERRBUF_SIZE];
-        pcap_t* pcapHandle = pcap_open_offline(QUOTE(SAMPLE_PCAP_FILE), errBuf);
+        pcap_t* pcapHandle = pcap_open_offline(SAMPLE_PCAP_FILE, errBuf);
 
         uint64_t packetCount{0};
         pcap_pkthdr header;
@@ -136,7 +275,7 @@ static void bmLibpcapPcapNG(benchmark::State& state) {
     const std::uint8_t* packet;
     for (auto _ : state) {
         char errBuf[PCAP_ERRBUF_SIZE];
-        pcap_t* pcapHandle = pcap_open_offline(QUOTE(SAMPLE_PCAPNG_FILE), errBuf);
+        pcap_t* pcapHandle = pcap_open_offline(SAMPLE_PCAPNG_FILE, errBuf);
 
         uint64_t packetCount{0};
         pcap_pkthdr header;
@@ -152,6 +291,27 @@ static void bmLibpcapPcapNG(benchmark::State& state) {
 BENCHMARK(bmMmprPcap)->Name("mmpr (pcap)");
 BENCHMARK(bmMmprPcapNG)->Name("mmpr (pcapng)");
 BENCHMARK(bmMmprPcapNGZst)->Name("mmpr (pcapng.zst)");
+BENCHMARK(bmMmprPcapRange)->Name("mmpr range loop (pcap)");
+BENCHMARK(bmMmprPcapNGRange)->Name("mmpr range loop (pcapng)");
+BENCHMARK_CAPTURE(bmMmprVirtualLoop, pcap, SAMPLE_PCAP_FILE)
+    ->Name("mmpr virtual loop (pcap)");
+BENCHMARK_CAPTURE(bmMmprForEachPacket, pcap, SAMPLE_PCAP_FILE)
+    ->Name("mmpr forEachPacket (pcap)");
+BENCHMARK_CAPTURE(bmMmprVirtualLoop, pcapng, SAMPLE_PCAPNG_FILE)
+    ->Name("mmpr virtual loop (pcapng)");
+BENCHMARK_CAPTURE(bmMmprForEachPacket, pcapng, SAMPLE_PCAPNG_FILE)
+    ->Name("mmpr forEachPacket (pcapng)");
+BENCHMARK_CAPTURE(bmMmprPcapNGOptions, skipped, false)
+    ->Name("mmpr EPB options skipped (pcapng)");
+BENCHMARK_CAPTURE(bmMmprPcapNGOptions, decoded, true)
+    ->Name("mmpr EPB options decoded (pcapng)");
+BENCHMARK(bmMmprPcapNGBlocks)->Name("mmpr blocks with metadata views (pcapng)");
+BENCHMARK_CAPTURE(bmMmprValidation, none, mmpr::ValidationLevel::NONE)
+    ->Name("mmpr validation none (pcapng)");
+BENCHMARK_CAPTURE(bmMmprValidation, cheap, mmpr::ValidationLevel::CHEAP)
+    ->Name("mmpr validation cheap (pcapng)");
+BENCHMARK_CAPTURE(bmMmprValidation, full, mmpr::ValidationLevel::FULL)
+    ->Name("mmpr validation full (pcapng)");
 BENCHMARK(bmPcapPlusPlusPcap)->Name("PcapPlusPlus (pcap)");
 BENCHMARK(bmPcapPlusPlusPcapNG)->Name("PcapPlusPlus (pcapng)");
 BENCHMARK(bmPcapPlusPlusPcapNGZstd)->Name("PcapPlusPlus (pcapng.zstd)");
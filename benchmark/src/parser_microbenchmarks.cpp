@@ -0,0 +1,323 @@
+#include <benchmark/benchmark.h>
+
+#include "mmpr/ByteOrder.h"
+#include "mmpr/mmpr.h"
+#include "mmpr/pcap/PcapParser.h"
+#include "mmpr/pcapng/PcapNgBlockOptionParser.h"
+#include "mmpr/pcapng/PcapNgBlockParser.h"
+#include "util.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * Microbenchmarks of the parser functions on synthetic in-memory blocks, without file
+ * access or the reader loop. The shapes vary in capture length, option count and
+ * if_tsresol. Compared against benchmark/baseline/parser_microbenchmarks.json by
+ * benchmark/tools/compare_baseline.py.
+ */
+namespace {
+
+using BlockParser = mmpr::PcapNgBlockParser<mmpr::NativeByteOrder>;
+using OptionParser = mmpr::PcapNgBlockOptionParser<mmpr::NativeByteOrder>;
+using PcapParser = mmpr::PcapParser<mmpr::NativeByteOrder>;
+
+// blocks per buffer, the benchmarks cycle through them like the packet loop through a
+// trace
+constexpr size_t BLOCK_COUNT = 256;
+
+void append(std::vector<uint8_t>& buffer, const void* data, size_t length) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    buffer.insert(buffer.end(), bytes, bytes + length);
+}
+
+void append16(std::vector<uint8_t>& buffer, uint16_t value) {
+    append(buffer, &value, sizeof(value));
+}
+
+void append32(std::vector<uint8_t>& buffer, uint32_t value) {
+    append(buffer, &value, sizeof(value));
+}
+
+void appendOption(std::vector<uint8_t>& buffer, uint16_t type, const void* value,
+                  uint16_t length) {
+    append16(buffer, type);
+    append16(buffer, length);
+    append(buffer, value, length);
+    buffer.resize(buffer.size() + (4 - length % 4) % 4, 0);
+}
+
+/**
+ * Appends an Enhanced Packet Block, the options cycle through epb_flags, epb_hash,
+ * epb_dropcount and epb_packetid.
+ */
+void appendEPB(std::vector<uint8_t>& buffer, uint32_t captureLength,
+               uint32_t optionCount, uint64_t timestamp) {
+    const size_t start = buffer.size();
+    append32(buffer, MMPR_ENHANCED_PACKET_BLOCK);
+    append32(buffer, 0);
+    append32(buffer, 0);
+    append32(buffer, (uint32_t)(timestamp >> 32));
+    append32(buffer, (uint32_t)timestamp);
+    append32(buffer, captureLength);
+    append32(buffer, captureLength);
+    buffer.resize(buffer.size() + captureLength + (4 - captureLength % 4) % 4, 0xAB);
+
+    const uint32_t flags = 1;
+    const uint8_t hash[5] = {2, 0xDE, 0xAD, 0xBE, 0xEF};
+    const uint64_t count = 42;
+    for (uint32_t i = 0; i < optionCount; ++i) {
+        switch (i % 4) {
+        case 0:
+            appendOption(buffer, MMPR_BLOCK_OPTION_EPB_FLAGS, &flags, sizeof(flags));
+            break;
+        case 1:
+            appendOption(buffer, MMPR_BLOCK_OPTION_EPB_HASH, hash, sizeof(hash));
+            break;
+        case 2:
+            appendOption(buffer, MMPR_BLOCK_OPTION_EPB_DROPCOUNT, &count, sizeof(count));
+            break;
+        case 3:
+            appendOption(buffer, MMPR_BLOCK_OPTION_EPB_PACKETID, &count, sizeof(count));
+            break;
+        }
+    }
+    if (optionCount > 0) {
+        appendOption(buffer, MMPR_BLOCK_OPTION_END_OF_OPT, nullptr, 0);
+    }
+
+    const uint32_t blockTotalLength = (uint32_t)(buffer.size() - start + 4);
+    std::memcpy(&buffer[start + 4], &blockTotalLength, sizeof(blockTotalLength));
+    append32(buffer, blockTotalLength);
+}
+
+/**
+ * Appends an Interface Description Block, the options cycle through if_tsresol,
+ * if_name, if_description, if_os, if_filter and if_tsoffset.
+ */
+void appendIDB(std::vector<uint8_t>& buffer, uint32_t optionCount, uint8_t tsresol) {
+    const size_t start = buffer.size();
+    append32(buffer, MMPR_INTERFACE_DESCRIPTION_BLOCK);
+    append32(buffer, 0);
+    append16(buffer, 1);
+    append16(buffer, 0);
+    append32(buffer, 262144);
+
+    const std::string name = "enp1s0f0";
+    const std::string description = "100G uplink, port 0";
+    const std::string os = "Linux 6.1.0";
+    const std::string filter = std::string(1, '\0') + "tcp or udp";
+    const int64_t tsoffset = 0;
+    for (uint32_t i = 0; i < optionCount; ++i) {
+        switch (i % 6) {
+        case 0:
+            appendOption(buffer, MMPR_BLOCK_OPTION_IDB_TSRESOL, &tsresol, 1);
+            break;
+        case 1:
+            appendOption(buffer, MMPR_BLOCK_OPTION_IDB_NAME, name.data(),
+                         (uint16_t)name.size());
+            break;
+        case 2:
+            appendOption(buffer, MMPR_BLOCK_OPTION_IDB_DESCRIPTION, description.data(),
+                         (uint16_t)description.size());
+            break;
+        case 3:
+            appendOption(buffer, MMPR_BLOCK_OPTION_IDB_OS, os.data(),
+                         (uint16_t)os.size());
+            break;
+        case 4:
+            appendOption(buffer, MMPR_BLOCK_OPTION_IDB_FILTER, filter.data(),
+                         (uint16_t)filter.size());
+            break;
+        case 5:
+            appendOption(buffer, MMPR_BLOCK_OPTION_IDB_TSOFFSET, &tsoffset,
+                         sizeof(tsoffset));
+            break;
+        }
+    }
+    if (optionCount > 0) {
+        appendOption(buffer, MMPR_BLOCK_OPTION_END_OF_OPT, nullptr, 0);
+    }
+
+    const uint32_t blockTotalLength = (uint32_t)(buffer.size() - start + 4);
+    std::memcpy(&buffer[start + 4], &blockTotalLength, sizeof(blockTotalLength));
+    append32(buffer, blockTotalLength);
+}
+
+/**
+ * @return offsets of the blocks in the buffer
+ */
+std::vector<size_t> blockOffsets(const std::vector<uint8_t>& buffer) {
+    std::vector<size_t> offsets;
+    size_t offset = 0;
+    while (offset < buffer.size()) {
+        offsets.push_back(offset);
+        uint32_t blockTotalLength;
+        std::memcpy(&blockTotalLength, &buffer[offset + 4], sizeof(blockTotalLength));
+        offset += blockTotalLength;
+    }
+    return offsets;
+}
+
+void bmReadEPB(benchmark::State& state) {
+    std::vector<uint8_t> buffer;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        appendEPB(buffer, (uint32_t)state.range(0), (uint32_t)state.range(1), i);
+    }
+    const std::vector<size_t> offsets = blockOffsets(buffer);
+
+    mmpr::EnhancedPacketBlock epb;
+    size_t index = 0;
+    for (auto _ : state) {
+        BlockParser::readEPB(&buffer[offsets[index]], epb);
+        benchmark::DoNotOptimize(epb);
+        index = (index + 1) % offsets.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void bmReadEPBOptions(benchmark::State& state) {
+    std::vector<uint8_t> buffer;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        appendEPB(buffer, (uint32_t)state.range(0), (uint32_t)state.range(1), i);
+    }
+    const std::vector<size_t> offsets = blockOffsets(buffer);
+
+    size_t index = 0;
+    for (auto _ : state) {
+        mmpr::PacketOptions options;
+        BlockParser::readEPBOptions(&buffer[offsets[index]], options);
+        benchmark::DoNotOptimize(options);
+        index = (index + 1) % offsets.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void bmReadEPBOption(benchmark::State& state) {
+    std::vector<uint8_t> buffer;
+    appendEPB(buffer, 64, (uint32_t)state.range(0), 0);
+    // offsets of the options, without opt_endofopt
+    std::vector<size_t> offsets;
+    size_t offset = 28 + 64;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        offsets.push_back(offset);
+        mmpr::Option option;
+        OptionParser::readOption(buffer.data(), option, offset);
+        offset += option.totalLength();
+    }
+
+    for (auto _ : state) {
+        for (size_t optionOffset : offsets) {
+            mmpr::Option option;
+            OptionParser::readEPBOption(buffer.data(), option, optionOffset);
+            benchmark::DoNotOptimize(option);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void bmReadIDB(benchmark::State& state) {
+    std::vector<uint8_t> buffer;
+    for (size_t i = 0; i < BLOCK_COUNT; ++i) {
+        appendIDB(buffer, (uint32_t)state.range(0), (uint8_t)state.range(1));
+    }
+    const std::vector<size_t> offsets = blockOffsets(buffer);
+
+    size_t index = 0;
+    for (auto _ : state) {
+        mmpr::InterfaceDescriptionBlock idb;
+        BlockParser::readIDB(&buffer[offsets[index]], idb);
+        benchmark::DoNotOptimize(idb);
+        index = (index + 1) % offsets.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void bmReadPacketRecord(benchmark::State& state) {
+    const uint32_t captureLength = (uint32_t)state.range(0);
+    std::vector<uint8_t> buffer;
+    std::vector<size_t> offsets;
+    for (uint32_t i = 0; i < BLOCK_COUNT; ++i) {
+        offsets.push_back(buffer.size());
+        append32(buffer, 1600000000 + i);
+        append32(buffer, i * 1000);
+        append32(buffer, captureLength);
+        append32(buffer, captureLength);
+        buffer.resize(buffer.size() + captureLength, 0xAB);
+    }
+
+    mmpr::PacketRecord record;
+    size_t index = 0;
+    for (auto _ : state) {
+        PcapParser::readPacketRecord(&buffer[offsets[index]], record);
+        benchmark::DoNotOptimize(record);
+        index = (index + 1) % offsets.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void bmCalculateTimestamps(benchmark::State& state) {
+    const uint8_t tsresol = (uint8_t)state.range(0);
+    const mmpr::TimestampConverter converter(tsresol, 0);
+    // ticks of the interface resolution since 2020-09-13, resolutions too fine for
+    // that in 64 bits start later after 1970
+    const double ticksPerSecond = (tsresol & 0x80) ? std::ldexp(1.0, tsresol & 0x7F)
+                                                   : std::pow(10.0, tsresol);
+    const auto start = (uint64_t)std::min(1600000000.0 * ticksPerSecond, 9.0e18);
+    std::vector<uint64_t> timestamps;
+    for (uint64_t i = 0; i < BLOCK_COUNT; ++i) {
+        timestamps.push_back(start + i * 7919);
+    }
+
+    mmpr::Packet packet;
+    size_t index = 0;
+    for (auto _ : state) {
+        const uint64_t timestamp = timestamps[index];
+        mmpr::util::calculateTimestamps(converter, (uint32_t)(timestamp >> 32),
+                                        (uint32_t)timestamp, packet);
+        benchmark::DoNotOptimize(packet);
+        index = (index + 1) % timestamps.size();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(bmReadEPB)
+    ->Name("parser/PcapNgBlockParser::readEPB")
+    ->ArgNames({"caplen", "options"})
+    ->ArgsProduct({{64, 594, 1518, 9000}, {0, 4}});
+BENCHMARK(bmReadEPBOptions)
+    ->Name("parser/PcapNgBlockParser::readEPBOptions")
+    ->ArgNames({"caplen", "options"})
+    ->ArgsProduct({{64, 1518}, {1, 4, 16}});
+BENCHMARK(bmReadEPBOption)
+    ->Name("parser/PcapNgBlockOptionParser::readEPBOption")
+    ->ArgNames({"options"})
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16);
+BENCHMARK(bmReadIDB)
+    ->Name("parser/PcapNgBlockParser::readIDB")
+    ->ArgNames({"options", "tsresol"})
+    ->Args({0, 6})
+    ->Args({1, 6})
+    ->Args({1, 9})
+    ->Args({6, 9})
+    ->Args({12, 9});
+BENCHMARK(bmReadPacketRecord)
+    ->Name("parser/PcapParser::readPacketRecord")
+    ->ArgNames({"caplen"})
+    ->Arg(64)
+    ->Arg(1518)
+    ->Arg(9000);
+// 10^-6, 10^-9, 10^-12 (reciprocal multiplication) and 2^-20
+BENCHMARK(bmCalculateTimestamps)
+    ->Name("parser/util::calculateTimestamps")
+    ->ArgNames({"tsresol"})
+    ->Arg(6)
+    ->Arg(9)
+    ->Arg(12)
+    ->Arg(0x80 | 20);
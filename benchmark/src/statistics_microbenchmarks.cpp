@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+
+#include "mmpr/HeavyHitters.h"
+#include "mmpr/HyperLogLog.h"
+#include "mmpr/LogLinearHistogram.h"
+#include "mmpr/PacketHistograms.h"
+#include "util.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+/**
+ * Cost of recording into the statistics histograms and sketches per value and per
+ * packet, on pre-generated values so that the random number generator is not measured.
+ */
+namespace {
+
+// values per buffer, small enough to stay in the L1 cache
+constexpr size_t VALUE_COUNT = 1024;
+
+void bmRecordValue(benchmark::State& state) {
+    // spread over the given number of bits, i.e. over that many powers of two
+    const int bits = (int)state.range(0);
+    std::mt19937_64 random(42);
+    std::vector<uint64_t> values;
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        values.push_back(random() >> (64 - bits));
+    }
+
+    mmpr::LogLinearHistogram histogram;
+    size_t index = 0;
+    for (auto _ : state) {
+        histogram.record(values[index]);
+        index = (index + 1) % VALUE_COUNT;
+    }
+    benchmark::DoNotOptimize(histogram);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void bmRecordPacket(benchmark::State& state) {
+    const int interfaces = (int)state.range(0);
+    std::mt19937_64 random(42);
+    std::vector<mmpr::Packet> packets(VALUE_COUNT);
+    uint64_t timestamp = 1600000000000000000;
+    for (auto& packet : packets) {
+        timestamp += random() % 100000;
+        packet.timestamp = timestamp;
+        packet.length = 64 + random() % 1455;
+        packet.captureLength = packet.length;
+        packet.interfaceIndex = (int)(random() % interfaces);
+    }
+
+    mmpr::PacketHistograms histograms;
+    size_t index = 0;
+    for (auto _ : state) {
+        histograms.record(packets[index]);
+        index = (index + 1) % VALUE_COUNT;
+        if (index == 0) {
+            // the timestamps start over
+            histograms.startTrace();
+        }
+    }
+    benchmark::DoNotOptimize(histograms);
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Hashes of keys drawn with a probability proportional to 1 / (rank + 1), i.e. a few
+ * heavy keys and a long tail like the sources of a trace.
+ */
+std::vector<uint64_t> skewedHashes(uint64_t keys) {
+    std::mt19937_64 random(42);
+    std::vector<double> weights;
+    for (uint64_t key = 0; key < keys; ++key) {
+        weights.push_back(1.0 / (key + 1));
+    }
+    std::discrete_distribution<uint64_t> distribution(weights.begin(), weights.end());
+    std::vector<uint64_t> hashes;
+    for (size_t i = 0; i < VALUE_COUNT; ++i) {
+        hashes.push_back(mmpr::util::mix64(distribution(random)));
+    }
+    return hashes;
+}
+
+void bmAddHeavyHitter(benchmark::State& state) {
+    const std::vector<uint64_t> hashes = skewedHashes((uint64_t)state.range(1));
+    mmpr::HeavyHitters heavyHitters((size_t)state.range(0));
+    mmpr::HeavyHitters::Key key{};
+    size_t index = 0;
+    for (auto _ : state) {
+        const uint64_t hash = hashes[index];
+        memcpy(key.data(), &hash, sizeof(hash));
+        heavyHitters.add(key, hash, 1);
+        index = (index + 1) % VALUE_COUNT;
+    }
+    benchmark::DoNotOptimize(heavyHitters);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void bmAddHyperLogLog(benchmark::State& state) {
+    const std::vector<uint64_t> hashes = skewedHashes(1000000);
+    mmpr::HyperLogLog sketch;
+    size_t index = 0;
+    for (auto _ : state) {
+        sketch.add(hashes[index]);
+        index = (index + 1) % VALUE_COUNT;
+    }
+    benchmark::DoNotOptimize(sketch);
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(bmRecordValue)
+    ->Name("statistics/LogLinearHistogram::record")
+    ->ArgNames({"bits"})
+    ->Arg(11)
+    ->Arg(40);
+BENCHMARK(bmRecordPacket)
+    ->Name("statistics/PacketHistograms::record")
+    ->ArgNames({"interfaces"})
+    ->Arg(1)
+    ->Arg(8);
+BENCHMARK(bmAddHeavyHitter)
+    ->Name("statistics/HeavyHitters::add")
+    ->ArgNames({"capacity", "keys"})
+    ->ArgsProduct({{64, 256}, {1000, 1000000}});
+BENCHMARK(bmAddHyperLogLog)->Name("statistics/HyperLogLog::add");
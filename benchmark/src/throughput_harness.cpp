@@ -0,0 +1,352 @@
+#include <benchmark/benchmark.h>
+
+#include "TraceGenerator.h"
+#include "mmpr/forEachPacket.h"
+#include "mmpr/modified_pcap/MMModifiedPcapReader.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include "mmpr/pcapng/ZstdPcapNgReader.h"
+#include <PcapFileDevice.h>
+#include <cstdlib>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <pcap.h>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * End-to-end throughput harness. Every reader (mmpr, libpcap and PcapPlusPlus) reads
+ * every input it supports, once with the trace in the page cache (warm) and once with
+ * the page cache evicted before each iteration (cold). Besides the time, the runs
+ * report packets/s, bytes/s, peak RSS, page faults and CPU time as counters, which
+ * end up in the JSON output of --benchmark_format=json.
+ *
+ * The inputs are the small trace files and generated traces large enough not to fit
+ * into the caches. A trace is written to MMPR_BENCHMARK_TRACE_DIR (a temporary directory
+ * by default) by the first benchmark that reads it and reused by later runs.
+ * MMPR_BENCHMARK_TRACE_SIZE sets their size (default 1G), 0 skips them.
+ */
+namespace {
+
+enum InputFormat { PCAP, MODIFIED_PCAP, PCAPNG, PCAPNG_ZSTD };
+
+struct Input {
+    std::string name;
+    // path of the trace, generated traces are written on the first call
+    std::function<std::string()> filepath;
+    InputFormat format;
+};
+
+struct ReadResult {
+    uint64_t packets{0};
+    // captured bytes, comparable between compressed and uncompressed traces
+    uint64_t bytes{0};
+};
+
+using ReadTrace = ReadResult (*)(const std::string& filepath);
+
+template <typename Reader>
+ReadResult readMmpr(const std::string& filepath) {
+    ReadResult result;
+    Reader reader(filepath);
+    reader.open();
+    result.packets = mmpr::forEachPacket(reader, [&](const mmpr::Packet& packet) {
+        result.bytes += packet.captureLength;
+    });
+    reader.close();
+    return result;
+}
+
+ReadResult readLibpcap(const std::string& filepath) {
+    ReadResult result;
+    char errBuf[PCAP_ERRBUF_SIZE];
+    pcap_t* pcapHandle = pcap_open_offline(filepath.c_str(), errBuf);
+    if (pcapHandle == nullptr) {
+        throw std::runtime_error("libpcap failed to open " + filepath + ": " + errBuf);
+    }
+    pcap_pkthdr header;
+    while (pcap_next(pcapHandle, &header) != nullptr) {
+        ++result.packets;
+        result.bytes += header.caplen;
+    }
+    pcap_close(pcapHandle);
+    return result;
+}
+
+template <typename Device>
+ReadResult readPcapPlusPlus(const std::string& filepath) {
+    ReadResult result;
+    pcpp::RawPacket packet;
+    Device reader(filepath.c_str());
+    if (!reader.open()) {
+        throw std::runtime_error("PcapPlusPlus failed to open " + filepath);
+    }
+    while (reader.getNextPacket(packet)) {
+        ++result.packets;
+        result.bytes += packet.getRawDataLen();
+    }
+    reader.close();
+    return result;
+}
+
+/**
+ * Drops the clean pages of the file from the page cache. Dirty pages, e.g. of a trace
+ * generated just before, are written back first since the kernel keeps them otherwise.
+ */
+void evictFromPageCache(const std::string& filepath) {
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open " + filepath +
+                                 " for page cache eviction");
+    }
+    ::fdatasync(fd);
+    int error = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+    if (error != 0) {
+        throw std::runtime_error("posix_fadvise(POSIX_FADV_DONTNEED) failed for " +
+                                 filepath);
+    }
+}
+
+/**
+ * Resets the peak RSS of the process to its current RSS (Linux 4.0 and later), so the
+ * peak reported by readPeakRss() covers a single benchmark. Best effort, the peak
+ * stays the process lifetime maximum where this is not supported.
+ */
+void resetPeakRss() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+/**
+ * @return peak RSS in bytes, VmHWM of /proc/self/status or else ru_maxrss
+ */
+uint64_t readPeakRss() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stoull(line.substr(6)) * 1024;
+        }
+    }
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_maxrss * 1024;
+}
+
+/**
+ * Process-wide resource usage, includes the threads of the Zstd decompression pool.
+ */
+struct Usage {
+    double userSeconds{0};
+    double systemSeconds{0};
+    uint64_t majorFaults{0};
+    uint64_t minorFaults{0};
+
+    static Usage now() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        Usage result;
+        result.userSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+        result.systemSeconds = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+        result.majorFaults = usage.ru_majflt;
+        result.minorFaults = usage.ru_minflt;
+        return result;
+    }
+
+    Usage& operator+=(const Usage& other) {
+        userSeconds += other.userSeconds;
+        systemSeconds += other.systemSeconds;
+        majorFaults += other.majorFaults;
+        minorFaults += other.minorFaults;
+        return *this;
+    }
+
+    Usage operator-(const Usage& other) const {
+        Usage result;
+        result.userSeconds = userSeconds - other.userSeconds;
+        result.systemSeconds = systemSeconds - other.systemSeconds;
+        result.majorFaults = majorFaults - other.majorFaults;
+        result.minorFaults = minorFaults - other.minorFaults;
+        return result;
+    }
+};
+
+void bmThroughput(benchmark::State& state, ReadTrace read, const Input& input,
+                  bool cold) {
+    const std::string filepath = input.filepath();
+    if (!cold) {
+        // the first iteration should not pay for reading the trace from disk
+        read(filepath);
+    }
+    resetPeakRss();
+
+    ReadResult total;
+    // resource usage of the page cache evictions, which is not part of the runs
+    Usage eviction;
+    const Usage start = Usage::now();
+    for (auto _ : state) {
+        if (cold) {
+            state.PauseTiming();
+            const Usage beforeEviction = Usage::now();
+            evictFromPageCache(filepath);
+            eviction += Usage::now() - beforeEviction;
+            state.ResumeTiming();
+        }
+        const ReadResult result = read(filepath);
+        total.packets += result.packets;
+        total.bytes += result.bytes;
+    }
+    const Usage usage = Usage::now() - start - eviction;
+
+    state.SetBytesProcessed((int64_t)total.bytes);
+    state.counters["packets"] =
+        benchmark::Counter((double)total.packets, benchmark::Counter::kIsRate);
+    state.counters["peak_rss"] =
+        benchmark::Counter((double)readPeakRss(), benchmark::Counter::kDefaults,
+                           benchmark::Counter::kIs1024);
+    state.counters["major_faults"] = benchmark::Counter(
+        (double)usage.majorFaults, benchmark::Counter::kAvgIterations);
+    state.counters["minor_faults"] = benchmark::Counter(
+        (double)usage.minorFaults, benchmark::Counter::kAvgIterations);
+    state.counters["user_seconds"] =
+        benchmark::Counter(usage.userSeconds, benchmark::Counter::kAvgIterations);
+    state.counters["system_seconds"] =
+        benchmark::Counter(usage.systemSeconds, benchmark::Counter::kAvgIterations);
+    state.counters["cpu_seconds"] = benchmark::Counter(
+        usage.userSeconds + usage.systemSeconds, benchmark::Counter::kAvgIterations);
+}
+
+/**
+ * @return readers able to read the format, by name
+ */
+std::vector<std::pair<std::string, ReadTrace>> readersOf(InputFormat format) {
+    switch (format) {
+    case PCAP:
+        return {{"mmpr", readMmpr<mmpr::MMPcapReader>},
+                {"libpcap", readLibpcap},
+                {"PcapPlusPlus", readPcapPlusPlus<pcpp::PcapFileReaderDevice>}};
+    case MODIFIED_PCAP:
+        return {{"mmpr", readMmpr<mmpr::MMModifiedPcapReader>},
+                {"libpcap", readLibpcap},
+                {"PcapPlusPlus", readPcapPlusPlus<pcpp::PcapFileReaderDevice>}};
+    case PCAPNG:
+        return {{"mmpr", readMmpr<mmpr::MMPcapNgReader>},
+                {"libpcap", readLibpcap},
+                {"PcapPlusPlus", readPcapPlusPlus<pcpp::PcapNgFileReaderDevice>}};
+    case PCAPNG_ZSTD:
+        // libpcap does not decompress
+        return {{"mmpr", readMmpr<mmpr::ZstdPcapNgReader>},
+                {"PcapPlusPlus", readPcapPlusPlus<pcpp::PcapNgFileReaderDevice>}};
+    }
+    return {};
+}
+
+/**
+ * @return path of the generated trace, written if it does not exist yet
+ */
+std::string generateTrace(const std::filesystem::path& directory,
+                          const std::string& name,
+                          const mmpr::TraceGenerator::Config& config) {
+    std::filesystem::create_directories(directory);
+    const std::string extension =
+        config.format == mmpr::TraceGenerator::PCAPNG ? ".pcapng" : ".pcap";
+    const std::filesystem::path filepath =
+        directory / (name + "-" + std::to_string(config.size) + extension);
+    const bool missing =
+        !std::filesystem::exists(filepath) ||
+        (config.zstd && !std::filesystem::exists(filepath.string() + ".zst"));
+    if (missing) {
+        std::cerr << "Generating " << filepath.string() << std::endl;
+        mmpr::TraceGenerator(config).generate(filepath.string());
+    }
+    return filepath.string();
+}
+
+std::vector<Input> generatedInputs() {
+    const char* sizeVariable = std::getenv("MMPR_BENCHMARK_TRACE_SIZE");
+    const uint64_t size =
+        mmpr::TraceGenerator::parseSize(sizeVariable != nullptr ? sizeVariable : "1G");
+    if (size == 0) {
+        return {};
+    }
+    const char* directoryVariable = std::getenv("MMPR_BENCHMARK_TRACE_DIR");
+    const std::filesystem::path directory =
+        directoryVariable != nullptr
+            ? std::filesystem::path(directoryVariable)
+            : std::filesystem::temp_directory_path() / "mmpr-benchmark-traces";
+    const auto generated = [&directory](const std::string& name,
+                                        const mmpr::TraceGenerator::Config& config,
+                                        const std::string& suffix = "") {
+        return [directory, name, config, suffix] {
+            return generateTrace(directory, name, config) + suffix;
+        };
+    };
+
+    std::vector<Input> inputs;
+    mmpr::TraceGenerator::Config config;
+    config.size = size;
+    config.format = mmpr::TraceGenerator::PCAP;
+    inputs.push_back({"generated imix pcap", generated("imix", config), PCAP});
+    config.format = mmpr::TraceGenerator::MODIFIED_PCAP;
+    inputs.push_back({"generated imix modified pcap", generated("imix-modified", config),
+                      MODIFIED_PCAP});
+    config.format = mmpr::TraceGenerator::PCAPNG;
+#ifdef MMPR_USE_ZSTD
+    // one generation writes both
+    config.zstd = true;
+#endif
+    inputs.push_back({"generated imix pcapng", generated("imix", config), PCAPNG});
+#ifdef MMPR_USE_ZSTD
+    inputs.push_back({"generated imix pcapng.zst", generated("imix", config, ".zst"),
+                      PCAPNG_ZSTD});
+#endif
+    config.zstd = false;
+    config.interfaces = 8;
+    config.packetOptions = true;
+    inputs.push_back({"generated imix pcapng, 8 interfaces, options",
+                      generated("imix-8if-options", config), PCAPNG});
+    return inputs;
+}
+
+} // namespace
+
+void registerThroughputHarness() {
+    const auto file = [](const std::string& filepath) {
+        return [filepath] { return filepath; };
+    };
+    std::vector<Input> inputs{
+        {"example pcap", file("tracefiles/example.pcap"), PCAP},
+        {"big-endian modified pcap", file("tracefiles/big-endian-modified.pcap"),
+         MODIFIED_PCAP},
+        {"example pcapng", file("tracefiles/pcapng-example.pcapng"), PCAPNG},
+#ifdef MMPR_USE_ZSTD
+        {"example pcapng.zst", file("tracefiles/pcapng-example.pcapng.zst"),
+         PCAPNG_ZSTD},
+#endif
+    };
+    for (const Input& input : generatedInputs()) {
+        inputs.push_back(input);
+    }
+
+    for (const Input& input : inputs) {
+        for (const auto& [readerName, read] : readersOf(input.format)) {
+            for (bool cold : {false, true}) {
+                const std::string name = "throughput/" + readerName + "/" + input.name +
+                                         "/" + (cold ? "cold" : "warm");
+                // real time and process CPU time, cold runs wait for the disk and the
+                // Zstd reader decompresses on pool threads
+                benchmark::RegisterBenchmark(name.c_str(), bmThroughput, read, input,
+                                             cold)
+                    ->UseRealTime()
+                    ->MeasureProcessCPUTime()
+                    ->Unit(benchmark::kMillisecond);
+            }
+        }
+    }
+}
@@ -0,0 +1,126 @@
+#include "TraceGenerator.h"
+
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " [options] <output file>\n"
+         << "  --format pcap|pcapng|modified-pcap   (default pcapng)\n"
+         << "  --size <bytes>[K|M|G]                (default 64M)\n"
+         << "  --sizes fixed:<bytes>|imix|empirical:<trace>   (default imix)\n"
+         << "  --snap-length <bytes>                (default unlimited)\n"
+         << "  --flows <count>                      (default 1024)\n"
+         << "  --timestamps constant|poisson|burst  (default constant)\n"
+         << "  --rate <packets per second>          (default 1000000)\n"
+         << "  --burst-length <packets>             (default 32)\n"
+         << "  --interfaces <count>                 (pcapng, default 1)\n"
+         << "  --options                            (pcapng, EPB options)\n"
+         << "  --zstd                               (pcapng, also writes <file>.zst)\n"
+         << "  --seed <number>                      (default 1)\n";
+}
+
+mmpr::TraceGenerator::Config parseArguments(int argc, char** argv, string& output) {
+    mmpr::TraceGenerator::Config config;
+    for (int i = 1; i < argc; ++i) {
+        const string argument = argv[i];
+        if (argument == "--options") {
+            config.packetOptions = true;
+            continue;
+        }
+        if (argument == "--zstd") {
+            config.zstd = true;
+            continue;
+        }
+        if (argument.rfind("--", 0) != 0) {
+            output = argument;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw invalid_argument("Missing value of " + argument);
+        }
+        const string value = argv[++i];
+        if (argument == "--format") {
+            if (value == "pcap") {
+                config.format = mmpr::TraceGenerator::PCAP;
+            } else if (value == "pcapng") {
+                config.format = mmpr::TraceGenerator::PCAPNG;
+            } else if (value == "modified-pcap") {
+                config.format = mmpr::TraceGenerator::MODIFIED_PCAP;
+            } else {
+                throw invalid_argument("Unknown format " + value);
+            }
+        } else if (argument == "--size") {
+            config.size = mmpr::TraceGenerator::parseSize(value);
+        } else if (argument == "--sizes") {
+            if (value == "imix") {
+                config.sizeDistribution = mmpr::TraceGenerator::IMIX;
+            } else if (value.rfind("fixed:", 0) == 0) {
+                config.sizeDistribution = mmpr::TraceGenerator::FIXED;
+                config.packetSize = stoul(value.substr(6));
+            } else if (value.rfind("empirical:", 0) == 0) {
+                config.sizeDistribution = mmpr::TraceGenerator::EMPIRICAL;
+                config.empiricalTrace = value.substr(10);
+            } else {
+                throw invalid_argument("Unknown packet size distribution " + value);
+            }
+        } else if (argument == "--snap-length") {
+            config.snapLength = stoul(value);
+        } else if (argument == "--flows") {
+            config.flows = stoul(value);
+        } else if (argument == "--timestamps") {
+            if (value == "constant") {
+                config.timestampPattern = mmpr::TraceGenerator::CONSTANT;
+            } else if (value == "poisson") {
+                config.timestampPattern = mmpr::TraceGenerator::POISSON;
+            } else if (value == "burst") {
+                config.timestampPattern = mmpr::TraceGenerator::BURST;
+            } else {
+                throw invalid_argument("Unknown timestamp pattern " + value);
+            }
+        } else if (argument == "--rate") {
+            config.packetRate = stod(value);
+        } else if (argument == "--burst-length") {
+            config.burstLength = stoul(value);
+        } else if (argument == "--interfaces") {
+            config.interfaces = stoul(value);
+        } else if (argument == "--seed") {
+            config.seed = stoull(value);
+        } else {
+            throw invalid_argument("Unknown option " + argument);
+        }
+    }
+    return config;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    string output;
+    mmpr::TraceGenerator::Config config;
+    try {
+        config = parseArguments(argc, argv, output);
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (output.empty()) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        mmpr::TraceGenerator generator(config);
+        const uint64_t packets = generator.generate(output);
+        cout << "Wrote " << packets << " packets to " << output << endl;
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
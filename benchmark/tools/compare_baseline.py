@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+"""
+Compares Google Benchmark JSON output against a stored baseline and fails if a benchmark
+got slower than the threshold allows.
+
+    mmpr_benchmark --benchmark_filter='^parser/' --benchmark_repetitions=5 \\
+        --benchmark_out=current.json --benchmark_out_format=json
+    compare_baseline.py benchmark/baseline/parser_microbenchmarks.json current.json
+
+With repetitions, the median aggregate is compared, otherwise the median of the runs of
+a benchmark. Exits with 1 on a regression or a benchmark missing from the current run,
+with 2 on invalid input.
+"""
+
+import argparse
+import json
+import re
+import statistics
+import sys
+
+TIME_UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_times(path, metric):
+    """Returns the time of every benchmark in nanoseconds, by name."""
+    with open(path) as file:
+        report = json.load(file)
+
+    medians = {}
+    runs = {}
+    for benchmark in report.get("benchmarks", []):
+        if benchmark.get("error_occurred"):
+            continue
+        scale = TIME_UNITS[benchmark.get("time_unit", "ns")]
+        name = benchmark.get("run_name", benchmark["name"])
+        if benchmark.get("run_type") == "aggregate":
+            if benchmark.get("aggregate_name") == "median":
+                medians[name] = benchmark[metric] * scale
+        else:
+            runs.setdefault(name, []).append(benchmark[metric] * scale)
+
+    times = {name: statistics.median(values) for name, values in runs.items()}
+    times.update(medians)
+    return times
+
+
+def format_time(nanoseconds):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if nanoseconds >= scale:
+            return "%.3g %s" % (nanoseconds / scale, unit)
+    return "%.3g ns" % nanoseconds
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("baseline", help="stored Google Benchmark JSON")
+    parser.add_argument("current", help="Google Benchmark JSON of the current build")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed relative slowdown (default 0.10)")
+    parser.add_argument("--metric", choices=("cpu_time", "real_time"),
+                        default="cpu_time", help="compared time (default cpu_time)")
+    parser.add_argument("--filter", default="",
+                        help="only compare benchmarks matching this regex")
+    parser.add_argument("--allow-missing", action="store_true",
+                        help="do not fail on baseline benchmarks missing from the run")
+    args = parser.parse_args()
+
+    try:
+        baseline = load_times(args.baseline, args.metric)
+        current = load_times(args.current, args.metric)
+    except (OSError, ValueError, KeyError) as e:
+        print("Error: %s" % e, file=sys.stderr)
+        return 2
+    pattern = re.compile(args.filter)
+
+    regressions = 0
+    missing = 0
+    width = max([len(name) for name in baseline] + [9])
+    print("%-*s %12s %12s %9s" % (width, "Benchmark", "Baseline", "Current", "Change"))
+    for name in sorted(baseline):
+        if not pattern.search(name):
+            continue
+        if name not in current:
+            missing += 1
+            print("%-*s %12s %12s %9s  MISSING"
+                  % (width, name, format_time(baseline[name]), "-", "-"))
+            continue
+        change = current[name] / baseline[name] - 1 if baseline[name] > 0 else 0
+        status = ""
+        if change > args.threshold:
+            regressions += 1
+            status = "  REGRESSION"
+        elif change < -args.threshold:
+            status = "  improved"
+        print("%-*s %12s %12s %+8.1f%%%s"
+              % (width, name, format_time(baseline[name]), format_time(current[name]),
+                 change * 100, status))
+    for name in sorted(set(current) - set(baseline)):
+        if pattern.search(name):
+            print("%-*s %12s %12s %9s  NEW" % (width, name, "-",
+                                                format_time(current[name]), "-"))
+
+    print("\n%d regression(s) beyond %.0f%%, %d missing"
+          % (regressions, args.threshold * 100, missing))
+    if regressions > 0 or (missing > 0 and not args.allow_missing):
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,139 @@
+#include "mmpr/MapReduceJob.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+void printUsage(const char* program) {
+    cerr << "Usage: " << program << " <command> [options]\n"
+         << "  run --dir <job> [--workers <n>] [--split <bytes>[K|M|G]] <file>...\n"
+         << "      plans, maps with local worker processes and merges\n"
+         << "  plan --dir <job> [--split <bytes>[K|M|G]] <file>...\n"
+         << "  work --dir <job> [--claim-timeout <seconds>]\n"
+         << "      maps items until all are claimed, on any host\n"
+         << "  merge --dir <job>    merges the summaries of all items\n";
+}
+
+uint64_t parseSize(const string& size) {
+    size_t position;
+    uint64_t value = stoull(size, &position);
+    const string suffix = size.substr(position);
+    if (suffix == "K") {
+        value <<= 10;
+    } else if (suffix == "M") {
+        value <<= 20;
+    } else if (suffix == "G") {
+        value <<= 30;
+    } else if (!suffix.empty()) {
+        throw invalid_argument("Invalid size " + size);
+    }
+    return value;
+}
+
+void printSummary(const mmpr::TraceSummary& summary) {
+    cout << "Packets: " << summary.packets << endl;
+    cout << "Bytes: " << summary.bytes << endl;
+    cout << "Bytes (captured): " << summary.capturedBytes << endl;
+    if (summary.packets > 0) {
+        cout << "First timestamp: " << summary.firstTimestamp << "ns" << endl;
+        cout << "Last timestamp: " << summary.lastTimestamp << "ns" << endl;
+    }
+    cout << "Flows: " << summary.flows.size() << endl;
+    cout << "Packet lengths:" << endl;
+    for (size_t i = 0; i < mmpr::TraceSummary::LENGTH_BUCKETS; ++i) {
+        if (summary.lengthHistogram[i] > 0) {
+            const uint64_t low = i == 0 ? 0 : 1ull << (i - 1);
+            cout << "  [" << low << ", " << (1ull << i)
+                 << "): " << summary.lengthHistogram[i] << endl;
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    const string command = argv[1];
+    string directory;
+    size_t workers = max(1u, thread::hardware_concurrency());
+    uint64_t splitSize = 1ull << 30;
+    uint64_t claimTimeout = 0;
+    vector<string> files;
+    try {
+        for (int i = 2; i < argc; ++i) {
+            const string argument = argv[i];
+            if (argument.rfind("--", 0) != 0) {
+                files.push_back(argument);
+                continue;
+            }
+            if (i + 1 >= argc) {
+                throw invalid_argument("Missing value of " + argument);
+            }
+            const string value = argv[++i];
+            if (argument == "--dir") {
+                directory = value;
+            } else if (argument == "--workers") {
+                workers = max(1ul, stoul(value));
+            } else if (argument == "--split") {
+                splitSize = parseSize(value);
+            } else if (argument == "--claim-timeout") {
+                claimTimeout = stoull(value);
+            } else {
+                throw invalid_argument("Unknown option " + argument);
+            }
+        }
+        if (directory.empty()) {
+            throw invalid_argument("Missing --dir");
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try {
+        mmpr::MapReduceJob job(directory);
+        job.setClaimTimeout(claimTimeout);
+        if (command == "plan" || command == "run") {
+            if (files.empty()) {
+                throw invalid_argument("No input files");
+            }
+            // sort files for deterministic plans
+            sort(files.begin(), files.end());
+            job.plan(files, splitSize);
+            cout << "Planned " << job.getItems().size() << " work items" << endl;
+        }
+        if (command == "work") {
+            cout << "Mapped " << job.work() << " work items" << endl;
+        } else if (command == "run") {
+            auto start = steady_clock::now();
+            job.runWorkers(workers);
+            auto mapped = steady_clock::now();
+            mmpr::TraceSummary summary = job.reduce();
+            auto stop = steady_clock::now();
+            cout << "Map: " << duration_cast<milliseconds>(mapped - start).count()
+                 << "ms with " << workers << " workers" << endl;
+            cout << "Reduce: " << duration_cast<milliseconds>(stop - mapped).count()
+                 << "ms" << endl;
+            printSummary(summary);
+        } else if (command == "merge") {
+            printSummary(job.reduce());
+        } else if (command != "plan") {
+            cerr << "Error: unknown command " << command << endl;
+            printUsage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -1,61 +1,319 @@
+#include "mmpr/PacketHistograms.h"
+#include "mmpr/TrafficSketches.h"
+#include "mmpr/WorkStealingScheduler.h"
 #include "mmpr/pcapng/MMPcapNgReader.h"
 #include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <thread>
 
 using namespace std;
 using namespace std::chrono;
 
+namespace {
+
+// bounds of --threads and --top, the top lists and sketches are allocated per thread
+constexpr size_t MAX_THREADS = 1024;
+constexpr size_t MAX_TOP_SOURCES = 10000;
+
+/**
+ * Metrics of a file or a thread, threads only add to their own accumulator and the
+ * accumulators are summed in thread order at the end.
+ */
+struct Metrics {
+    uint64_t packets{0};
+    uint64_t bytes{0};
+    uint64_t capturedBytes{0};
+    uint64_t fileSize{0};
+    uint64_t files{0};
+    // time spent reading, in nanoseconds
+    uint64_t duration{0};
+
+    Metrics& operator+=(const Metrics& other) {
+        packets += other.packets;
+        bytes += other.bytes;
+        capturedBytes += other.capturedBytes;
+        fileSize += other.fileSize;
+        files += other.files;
+        duration += other.duration;
+        return *this;
+    }
+};
+
+// padded to a cache line, so that the accumulators of the threads do not share one
+struct alignas(64) ThreadMetrics {
+    Metrics metrics;
+    // only with --top, the sketches take about 290 KiB per thread
+    optional<mmpr::TrafficSketches> sketches;
+};
+
+string toJsonString(const string& value) {
+    string json = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if ((unsigned char)c < 0x20) {
+            // control characters, e.g. newlines in file names, are not allowed in JSON
+            // strings
+            char escaped[7];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            json += escaped;
+        } else {
+            json += c;
+        }
+    }
+    return json + '"';
+}
+
+void printThroughput(const Metrics& metrics) {
+    const double seconds = metrics.duration > 0 ? metrics.duration / 1e9 : 1e-9;
+    cout << metrics.packets / seconds << " packets/s, " << metrics.fileSize / seconds
+         << " bytes/s";
+}
+
+void printPercentiles(const char* name, const mmpr::LogLinearHistogram& histogram,
+                      const char* unit) {
+    cout << "  " << name << ":";
+    for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+        cout << " p" << quantile * 100 << " " << histogram.valueAtQuantile(quantile)
+             << unit << ",";
+    }
+    cout << " max " << histogram.getMax() << unit << ", mean " << histogram.getMean()
+         << unit << endl;
+}
+
+void printTopSources(const char* name, const mmpr::HeavyHitters& sources, size_t count,
+                     const char* unit) {
+    cout << "Top sources by " << name << ":" << endl;
+    const auto entries = sources.top();
+    for (size_t i = 0; i < entries.size() && i < count; ++i) {
+        cout << "  " << mmpr::TrafficSketches::formatAddress(entries[i].key) << ": "
+             << entries[i].count << " " << unit << endl;
+    }
+}
+
+void printUsage(const char* program) {
+    cout << "Usage: " << program << " [--json] [--histograms] [--top <count>] "
+         << "[--threads <count>] <file>..." << endl;
+}
+
+/**
+ * Parses a decimal count of at most maximum, stoul() alone accepts signs, leading
+ * whitespace and trailing characters and wraps negative numbers around.
+ */
+size_t parseCount(const string& option, const string& value, size_t maximum) {
+    size_t position = 0;
+    unsigned long count = 0;
+    if (!value.empty() && isdigit((unsigned char)value[0])) {
+        try {
+            count = stoul(value, &position);
+        } catch (const exception&) {
+            position = 0;
+        }
+    }
+    if (position == 0 || position != value.size() || count > maximum) {
+        throw invalid_argument("invalid count for " + option + ": \"" + value +
+                               "\", expected 0 to " + to_string(maximum));
+    }
+    return count;
+}
+
+} // namespace
+
 int main(int argc, char** argv) {
     vector<string> pcapFiles;
+    // prints the reader statistics of every file as a JSON line
+    bool json = false;
+    // prints packet size and inter-arrival time percentiles by interface
+    bool histograms = false;
+    // prints the top sources and distinct sources and flows, 0 disables the sketches
+    size_t topSources = 0;
+    size_t threads = max(1u, thread::hardware_concurrency());
 
-    for (size_t i = 1; i < argc; ++i) {
-        pcapFiles.emplace_back(argv[i]);
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const string argument = argv[i];
+            if (argument == "--json") {
+                json = true;
+            } else if (argument == "--histograms") {
+                histograms = true;
+            } else if (argument == "--top" || argument == "--threads") {
+                if (i + 1 >= argc) {
+                    throw invalid_argument("missing count for " + argument);
+                }
+                if (argument == "--top") {
+                    topSources = parseCount(argument, argv[++i], MAX_TOP_SOURCES);
+                } else {
+                    threads = parseCount(argument, argv[++i], MAX_THREADS);
+                    threads = max<size_t>(1, threads);
+                }
+            } else {
+                pcapFiles.emplace_back(argument);
+            }
+        }
+    } catch (const exception& e) {
+        cout << "Error: " << e.what() << endl;
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
     }
 
     if (pcapFiles.size() <= 0) {
         cout << "Error: you have to provide at least one input file!" << endl;
+        printUsage(argv[0]);
         return EXIT_FAILURE;
     }
 
     // sort files for deterministic results
     std::sort(pcapFiles.begin(), pcapFiles.end());
 
-    // metrics to count
-    uint64_t packets = 0;
-    uint64_t bytes = 0;
-    uint64_t capturedBytes = 0;
-    uint64_t totalFileSize = 0;
+    // larger files are scheduled first
+    vector<uint64_t> fileSizes;
+    for (const auto& pcapFile : pcapFiles) {
+        error_code error;
+        const uint64_t size = filesystem::file_size(pcapFile, error);
+        fileSizes.push_back(error ? 0 : size);
+    }
+
+    // results are stored by file and thread and printed in file order afterwards, the
+    // output does not depend on the schedule
+    vector<Metrics> fileMetrics(pcapFiles.size());
+    vector<string> fileStatistics(pcapFiles.size());
+    // interface indices are only unique within a file, the histograms are kept by file
+    vector<mmpr::PacketHistograms> fileHistograms(pcapFiles.size());
+    vector<ThreadMetrics> threadMetrics;
+    optional<mmpr::WorkStealingScheduler> scheduler;
 
     auto start = high_resolution_clock::now();
 
-    for (const auto& pcapFile : pcapFiles) {
-        std::unique_ptr<mmpr::FileReader> reader = mmpr::FileReader::getReader(pcapFile);
-        reader->open();
-        totalFileSize += reader->getFileSize();
-
-        mmpr::Packet packet;
-        while (!reader->isExhausted()) {
-            if (reader->readNextPacket(packet)) {
-                ++packets;
-                bytes += packet.length;
-                capturedBytes += packet.captureLength;
+    try {
+        threadMetrics.resize(threads);
+        for (auto& metrics : threadMetrics) {
+            if (topSources > 0) {
+                // the top lists keep some spare entries for sources close to the last
+                // place
+                metrics.sketches.emplace(max<size_t>(64, 2 * topSources));
             }
         }
+        scheduler.emplace(threads);
+        scheduler->run(fileSizes, [&](size_t file, size_t thread) {
+            auto fileStart = high_resolution_clock::now();
+            std::unique_ptr<mmpr::FileReader> reader =
+                mmpr::FileReader::getReader(pcapFiles[file]);
+            reader->setStatisticsEnabled(json);
+            reader->open();
 
-        reader->close();
+            Metrics metrics;
+            metrics.files = 1;
+            metrics.fileSize = reader->getFileSize();
+            mmpr::PacketHistograms& packetHistograms = fileHistograms[file];
+            optional<mmpr::TrafficSketches>& sketches = threadMetrics[thread].sketches;
+            mmpr::Packet packet;
+            while (!reader->isExhausted()) {
+                if (reader->readNextPacket(packet)) {
+                    ++metrics.packets;
+                    metrics.bytes += packet.length;
+                    metrics.capturedBytes += packet.captureLength;
+                    if (histograms) {
+                        packetHistograms.record(packet);
+                    }
+                    if (sketches) {
+                        sketches->record(packet, reader->getDataLinkType(packet));
+                    }
+                }
+            }
+
+            if (json) {
+                fileStatistics[file] = reader->getStatistics().toJson();
+            }
+            reader->close();
+            metrics.duration =
+                duration_cast<nanoseconds>(high_resolution_clock::now() - fileStart)
+                    .count();
+            fileMetrics[file] = metrics;
+            threadMetrics[thread].metrics += metrics;
+        });
+    } catch (const exception& e) {
+        cerr << "Error: " << e.what() << endl;
+        return EXIT_FAILURE;
     }
 
     auto stop = high_resolution_clock::now();
     uint64_t duration = duration_cast<nanoseconds>(stop - start).count();
 
+    Metrics total;
+    optional<mmpr::TrafficSketches> totalSketches;
+    if (topSources > 0) {
+        totalSketches.emplace(max<size_t>(64, 2 * topSources));
+    }
+    for (const auto& metrics : threadMetrics) {
+        total += metrics.metrics;
+        if (totalSketches) {
+            totalSketches->merge(*metrics.sketches);
+        }
+    }
+
+    if (json) {
+        for (size_t i = 0; i < pcapFiles.size(); ++i) {
+            cout << "{\"file\":" << toJsonString(pcapFiles[i])
+                 << ",\"statistics\":" << fileStatistics[i] << "}" << endl;
+        }
+    }
+
     cout << "Time elapsed: " << duration << "ns" << endl;
-    cout << "Packets: " << packets << endl;
-    cout << "Bytes: " << bytes << endl;
-    cout << "Bytes (captured): " << capturedBytes << endl;
+    cout << "Packets: " << total.packets << endl;
+    cout << "Bytes: " << total.bytes << endl;
+    cout << "Bytes (captured): " << total.capturedBytes << endl;
 
-    cout << (double)packets * 1000000000 / duration << " packets/s" << endl;
-    cout << (double)totalFileSize * 1000000000 / duration << " bytes/s" << endl;
+    cout << (double)total.packets * 1000000000 / duration << " packets/s" << endl;
+    cout << (double)total.fileSize * 1000000000 / duration << " bytes/s" << endl;
+
+    cout << endl;
+    for (size_t i = 0; i < threadMetrics.size(); ++i) {
+        const Metrics& metrics = threadMetrics[i].metrics;
+        cout << "Thread " << i << ": " << metrics.files << " files ("
+             << scheduler->getStolenTasks()[i] << " stolen), " << metrics.packets
+             << " packets, ";
+        printThroughput(metrics);
+        cout << endl;
+    }
+    for (size_t i = 0; i < pcapFiles.size(); ++i) {
+        cout << "File " << pcapFiles[i] << ": " << fileMetrics[i].packets << " packets, ";
+        printThroughput(fileMetrics[i]);
+        cout << endl;
+    }
+
+    for (size_t file = 0; histograms && file < pcapFiles.size(); ++file) {
+        const auto& interfaces = fileHistograms[file].getInterfaces();
+        for (size_t i = 0; i < interfaces.size(); ++i) {
+            const uint64_t count = interfaces[i].length.getCount();
+            if (count == 0) {
+                continue;
+            }
+            cout << endl;
+            cout << "File " << pcapFiles[file] << ", interface " << i << ": " << count
+                 << " packets" << endl;
+            printPercentiles("Length", interfaces[i].length, "B");
+            printPercentiles("Captured length", interfaces[i].captureLength, "B");
+            printPercentiles("Inter-arrival time", interfaces[i].interArrival, "ns");
+        }
+    }
+
+    if (totalSketches) {
+        cout << endl;
+        const auto& sources = totalSketches->getDistinctSources();
+        const auto& flows = totalSketches->getDistinctFlows();
+        cout << "Distinct sources: ~" << (uint64_t)sources.estimate() << endl;
+        cout << "Distinct flows: ~" << (uint64_t)flows.estimate() << endl;
+        printTopSources("bytes", totalSketches->getSourcesByBytes(), topSources, "bytes");
+        printTopSources("packets", totalSketches->getSourcesByPackets(), topSources,
+                        "packets");
+    }
 
     return 0;
 }
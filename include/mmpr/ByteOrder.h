@@ -0,0 +1,40 @@
+#ifndef MMPR_BYTEORDER_H
+#define MMPR_BYTEORDER_H
+
+#include <cstdint>
+
+namespace mmpr {
+/**
+ * Byte order policies the parsers are specialised on. The byte order of a file (or of a
+ * pcapng section) is determined once from its magic number, afterwards every field is
+ * read through the matching policy without any runtime check.
+ *
+ * NativeByteOrder reads fields exactly like the parsers always did, SwappedByteOrder
+ * reverses the bytes of every field for captures written on a host of the opposite
+ * endianness.
+ */
+struct NativeByteOrder {
+    static constexpr bool SWAPPED = false;
+
+    static uint16_t read16(const uint8_t* data) { return *(const uint16_t*)data; }
+    static uint32_t read32(const uint8_t* data) { return *(const uint32_t*)data; }
+    static uint64_t read64(const uint8_t* data) { return *(const uint64_t*)data; }
+};
+
+struct SwappedByteOrder {
+    static constexpr bool SWAPPED = true;
+
+    static uint16_t read16(const uint8_t* data) {
+        return __builtin_bswap16(*(const uint16_t*)data);
+    }
+    static uint32_t read32(const uint8_t* data) {
+        return __builtin_bswap32(*(const uint32_t*)data);
+    }
+    static uint64_t read64(const uint8_t* data) {
+        return __builtin_bswap64(*(const uint64_t*)data);
+    }
+};
+
+} // namespace mmpr
+
+#endif // MMPR_BYTEORDER_H
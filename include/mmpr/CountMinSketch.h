@@ -0,0 +1,70 @@
+#ifndef MMPR_COUNTMINSKETCH_H
+#define MMPR_COUNTMINSKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Count-Min sketch of weights by key hash, e.g. bytes by source address.
+ *
+ * DEPTH rows of width counters each, the counter of a key in row i is derived from its
+ * 64-bit hash by double hashing. Estimates never undercount and overcount by at most
+ * e / width of the total weight with a probability of 1 - e^-DEPTH. The footprint is
+ * fixed when constructed, DEPTH * width * 8 bytes.
+ *
+ * The rows are updated independently with a fixed trip count, merge() adds the counters
+ * of a sketch of the same width and compiles to packed additions.
+ */
+class CountMinSketch {
+public:
+    static constexpr size_t DEPTH = 4;
+
+    /**
+     * @param width counters per row, has to be a power of two
+     */
+    explicit CountMinSketch(size_t width = 4096);
+
+    /**
+     * Adds weight to the key and returns the new estimate of the key.
+     */
+    uint64_t add(uint64_t hash, uint64_t weight) {
+        uint64_t estimate = UINT64_MAX;
+        for (size_t row = 0; row < DEPTH; ++row) {
+            uint64_t& counter = mCounters[row * mWidth + column(hash, row)];
+            counter += weight;
+            estimate = counter < estimate ? counter : estimate;
+        }
+        return estimate;
+    }
+
+    uint64_t estimate(uint64_t hash) const;
+
+    /**
+     * Throws a std::invalid_argument if the widths differ.
+     */
+    void merge(const CountMinSketch& other);
+
+    size_t getWidth() const { return mWidth; }
+
+    bool operator==(const CountMinSketch& other) const {
+        return mWidth == other.mWidth && mCounters == other.mCounters;
+    }
+
+private:
+    size_t column(uint64_t hash, size_t row) const {
+        const auto low = (uint32_t)hash;
+        // odd, so that the columns of the rows differ
+        const auto high = (uint32_t)(hash >> 32) | 1;
+        return (low + row * high) & (mWidth - 1);
+    }
+
+    size_t mWidth;
+    std::vector<uint64_t> mCounters;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_COUNTMINSKETCH_H
@@ -0,0 +1,104 @@
+#ifndef MMPR_DECOMPRESSEDTRACECACHE_H
+#define MMPR_DECOMPRESSEDTRACECACHE_H
+
+#include "mmpr/ZstdDecompressionPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace mmpr {
+
+/**
+ * Keeps decompressed copies of zstd compressed traces, so reading the same compressed
+ * file again maps the cached copy through MMPcapNgReader instead of decompressing it.
+ * Entries are keyed by the absolute path, modification time and size of the compressed
+ * file, a modified file is decompressed again. Once the decompressed bytes exceed the
+ * budget, the least recently used traces are evicted.
+ *
+ * The copies live either in memfds private to the process, or as files in a scratch
+ * directory. A directory is shared by all processes using it, a directory on a tmpfs
+ * (e.g. /dev/shm) keeps the copies in memory as well. In a directory the modification
+ * time of a copy marks its last use, it is updated on every hit.
+ *
+ *     auto cache = std::make_shared<mmpr::DecompressedTraceCache>(config);
+ *     auto reader = mmpr::FileReader::getCachedReader(filepath, cache);
+ *
+ * Readers keep their own descriptor of the copy, evicting it does not affect readers
+ * which are still open. The cache is thread-safe.
+ */
+class DecompressedTraceCache {
+public:
+    struct Config {
+        // scratch directory for the copies, created if missing, the copies are kept in
+        // memfds of this process if empty
+        std::string directory;
+        // decompressed bytes kept in the cache
+        size_t byteBudget{size_t(4) * 1024 * 1024 * 1024};
+    };
+
+    struct Stats {
+        // lookups served from a cached copy
+        uint64_t hits{0};
+        // lookups which decompressed the trace into the cache
+        uint64_t misses{0};
+        // copies removed to stay within the byte budget
+        uint64_t evictions{0};
+        // traces larger than the budget or without a known decompressed size
+        uint64_t uncacheable{0};
+    };
+
+    /**
+     * @param pool decompression contexts and buffers used on misses, a private pool is
+     *             created if none is given
+     */
+    explicit DecompressedTraceCache(
+        const Config& config, std::shared_ptr<ZstdDecompressionPool> pool = nullptr);
+    ~DecompressedTraceCache();
+
+    DecompressedTraceCache(const DecompressedTraceCache&) = delete;
+    DecompressedTraceCache& operator=(const DecompressedTraceCache&) = delete;
+
+    /**
+     * Looks up the decompressed copy of a zstd compressed file, decompressing it into
+     * the cache on a miss.
+     *
+     * @return a new read-only descriptor of the copy, which the caller has to close, or
+     *         -1 if the trace cannot be cached
+     */
+    int acquire(const std::string& filepath);
+
+    /**
+     * Decompression pool used on misses, readers for uncacheable traces use it as well.
+     */
+    const std::shared_ptr<ZstdDecompressionPool>& getPool() const { return mPool; }
+
+    Stats getStats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        int fileDescriptor{-1};
+        size_t size{0};
+    };
+
+    int acquireFromMemory(const std::string& key, const std::string& filepath);
+    int acquireFromDirectory(const std::string& key, const std::string& filepath);
+    void evictFromDirectory(size_t required);
+
+    Config mConfig;
+    std::shared_ptr<ZstdDecompressionPool> mPool;
+    mutable std::mutex mMutex;
+    // memfd entries, most recently used first
+    std::list<Entry> mEntries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> mIndex;
+    size_t mCachedBytes{0};
+    Stats mStats{};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_DECOMPRESSEDTRACECACHE_H
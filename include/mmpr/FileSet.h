@@ -0,0 +1,64 @@
+#ifndef MMPR_FILESET_H
+#define MMPR_FILESET_H
+
+#include "mmpr/mmpr.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * The regular files of a directory, for reading very large sets of traces. Opening a file
+ * with FileReader::getReader(filepath) costs a handful of metadata system calls; for
+ * hundreds of thousands of small captures these dominate the startup. The file set lists
+ * the directory with getdents64 on a single directory descriptor. A reader is created
+ * with one openat() relative to it and one pread() of the magic number, and then maps the
+ * already opened file:
+ *
+ *     mmpr::FileSet files("captures/");
+ *     for (size_t i = 0; i < files.size(); ++i) {
+ *         auto reader = files.getReader(i);
+ *         ...
+ *     }
+ *
+ * Files are not opened before getReader(), the file set holds only the directory
+ * descriptor. Names are sorted, so the order does not depend on the file system.
+ */
+class FileSet {
+public:
+    /**
+     * Lists the regular files of a directory (symbolic links are followed), not
+     * recursing into subdirectories.
+     */
+    explicit FileSet(const std::string& directory);
+    ~FileSet();
+
+    FileSet(const FileSet&) = delete;
+    FileSet& operator=(const FileSet&) = delete;
+
+    size_t size() const { return mNames.size(); }
+    const std::vector<std::string>& getNames() const { return mNames; }
+    /**
+     * Path of the file at index, the directory joined with its name.
+     */
+    std::string getPath(size_t index) const;
+
+    /**
+     * Opens the file at index and creates the reader for its format.
+     *
+     * @param pool shared decompression contexts and buffers for compressed files
+     */
+    std::unique_ptr<FileReader>
+    getReader(size_t index,
+              const std::shared_ptr<ZstdDecompressionPool>& pool = nullptr) const;
+
+private:
+    std::string mDirectory;
+    int mDirectoryDescriptor{-1};
+    std::vector<std::string> mNames;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_FILESET_H
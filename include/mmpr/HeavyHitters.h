@@ -0,0 +1,97 @@
+#ifndef MMPR_HEAVYHITTERS_H
+#define MMPR_HEAVYHITTERS_H
+
+#include "mmpr/CountMinSketch.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Top-K keys by weight, e.g. the sources sending the most bytes, in bounded memory.
+ *
+ * Weights are counted in a Count-Min sketch. A Space-Saving style table holds the K keys
+ * with the largest estimates: a key missing from the full table replaces the entry with
+ * the smallest count once its estimate exceeds it. Keys below that count, i.e. nearly
+ * all keys of a long tail, only update the sketch. The counts are Count-Min estimates,
+ * never below the true weight.
+ *
+ * The table is a binary min-heap by count with an open-addressing index by hash, so
+ * updates of keys in the table and replacements take O(log K). merge() adds the
+ * sketches and keeps the K keys of both tables with the largest merged estimates.
+ */
+class HeavyHitters {
+public:
+    // 16 bytes, e.g. an IPv6 or IPv4-mapped address
+    using Key = std::array<uint8_t, 16>;
+
+    struct Entry {
+        Key key{};
+        uint64_t count{0};
+    };
+
+    /**
+     * @param capacity number of keys K kept in the table
+     * @param width counters per row of the Count-Min sketch, a power of two
+     */
+    explicit HeavyHitters(size_t capacity = 64, size_t width = 4096);
+
+    /**
+     * @param hash well mixed 64-bit hash of key
+     */
+    void add(const Key& key, uint64_t hash, uint64_t weight) {
+        const uint64_t estimate = mSketch.add(hash, weight);
+        if (mHeap.size() == mCapacity && estimate <= mHeap[0].count) {
+            // keys in the table always exceed the smallest count, since their estimate
+            // grew by weight
+            return;
+        }
+        update(key, hash, estimate);
+    }
+
+    /**
+     * Throws a std::invalid_argument if capacities or sketch widths differ.
+     */
+    void merge(const HeavyHitters& other);
+
+    /**
+     * Entries of the table by descending count, ties by key.
+     */
+    std::vector<Entry> top() const;
+
+    /**
+     * Count-Min estimate of any key.
+     */
+    uint64_t estimate(uint64_t hash) const { return mSketch.estimate(hash); }
+
+    size_t getCapacity() const { return mCapacity; }
+
+private:
+    struct HeapEntry {
+        Key key;
+        uint64_t hash;
+        uint64_t count;
+        // position in mIndex
+        size_t slot;
+    };
+
+    void update(const Key& key, uint64_t hash, uint64_t estimate);
+    size_t findSlot(const Key& key, uint64_t hash) const;
+    void insertSlot(size_t position);
+    void eraseSlot(size_t slot);
+    void siftDown(size_t position);
+    void swapEntries(size_t a, size_t b);
+
+    size_t mCapacity;
+    CountMinSketch mSketch;
+    std::vector<HeapEntry> mHeap;
+    // heap position + 1 by hash with linear probing, 0 for empty slots, at least twice
+    // the capacity
+    std::vector<uint32_t> mIndex;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_HEAVYHITTERS_H
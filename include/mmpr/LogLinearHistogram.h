@@ -0,0 +1,79 @@
+#ifndef MMPR_LOGLINEARHISTOGRAM_H
+#define MMPR_LOGLINEARHISTOGRAM_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace mmpr {
+
+/**
+ * Log-linear (HDR-style) histogram of unsigned 64-bit values with a fixed footprint.
+ *
+ * Values below 2^(SUB_BUCKET_BITS + 1) get a bucket each. Above, every power of two is
+ * split into 2^SUB_BUCKET_BITS equally wide buckets, so the width of a bucket is at most
+ * 1/16th of its lower bound and percentiles are accurate to within 6.25% over the whole
+ * range. The bucket index is computed from the bit width of the value without branches
+ * or loops, record() is a count leading zeros, two shifts, three additions and two
+ * conditional moves. The number of values is not counted separately, getCount() adds
+ * up the buckets.
+ *
+ * merge() adds the counts of another histogram and is associative and commutative, so
+ * threads record into their own histogram which are merged afterwards.
+ */
+class LogLinearHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+    static constexpr size_t BUCKETS = (65 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    void record(uint64_t value) {
+        ++mCounts[bucketIndex(value)];
+        mSum += value;
+        mMin = value < mMin ? value : mMin;
+        mMax = value > mMax ? value : mMax;
+    }
+
+    void merge(const LogLinearHistogram& other);
+
+    /**
+     * Value at or below which the given fraction of the recorded values lie, i.e. the
+     * highest value of the bucket holding that rank capped at the maximum. 0 without
+     * values.
+     *
+     * @param quantile between 0 and 1, e.g. 0.99 for the 99th percentile
+     */
+    uint64_t valueAtQuantile(double quantile) const;
+
+    /**
+     * Number of recorded values, the sum of all buckets.
+     */
+    uint64_t getCount() const;
+    uint64_t getSum() const { return mSum; }
+    // UINT64_MAX and 0 without values
+    uint64_t getMin() const { return mMin; }
+    uint64_t getMax() const { return mMax; }
+    double getMean() const;
+    const std::array<uint64_t, BUCKETS>& getCounts() const { return mCounts; }
+
+    static size_t bucketIndex(uint64_t value) {
+        // setting bit SUB_BUCKET_BITS keeps the shift at 0 for the linear buckets
+        const unsigned width = 64 - __builtin_clzll(value | SUB_BUCKETS);
+        const unsigned shift = width - SUB_BUCKET_BITS - 1;
+        return ((size_t)shift << SUB_BUCKET_BITS) + (size_t)(value >> shift);
+    }
+    static uint64_t bucketLowerBound(size_t index);
+    static uint64_t bucketUpperBound(size_t index);
+
+    bool operator==(const LogLinearHistogram& other) const;
+
+private:
+    std::array<uint64_t, BUCKETS> mCounts{};
+    uint64_t mSum{0};
+    uint64_t mMin{UINT64_MAX};
+    uint64_t mMax{0};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_LOGLINEARHISTOGRAM_H
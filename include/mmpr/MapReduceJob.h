@@ -0,0 +1,126 @@
+#ifndef MMPR_MAPREDUCEJOB_H
+#define MMPR_MAPREDUCEJOB_H
+
+#include "mmpr/TraceSummary.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Spreads the summary of many traces over worker processes, also on several hosts that
+ * share the job directory.
+ *
+ * plan() splits the input into work items and writes them to <directory>/plan. Pcap
+ * files larger than the split size are split into byte ranges (MMPcapReader::setRange()).
+ * PcapNG, modified Pcap and compressed files are single items, since their packets
+ * depend on blocks before them or cannot be located without reading from the start.
+ *
+ * Workers claim an item by creating <directory>/<item>.claim exclusively, map it into a
+ * TraceSummary and write it to <directory>/<item>.summary. Any number of workers can
+ * process the same job, larger items are claimed first. reduce() merges the partial
+ * summaries in item order.
+ *
+ * A claim holds the host and process id of its worker. A worker whose map step fails
+ * removes its claim before it rethrows. Claims of dead workers on the same host, and
+ * claims older than the claim timeout without a summary, e.g. of a host that went down,
+ * are taken over by the next worker.
+ *
+ * Ranges start at a heuristically found record (see MMPcapReader::setRange()), so
+ * workers also write the offsets of the first record read and of where they stopped to
+ * <directory>/<item>.extent. reduce() verifies that every range starts where the
+ * previous range of the file stopped and re-maps it from there if not.
+ */
+class MapReduceJob {
+public:
+    struct WorkItem {
+        std::string filepath;
+        uint64_t begin{0};
+        // end of the byte range, UINT64_MAX for the whole file
+        uint64_t end{UINT64_MAX};
+
+        bool isRange() const { return begin != 0 || end != UINT64_MAX; }
+    };
+
+    /**
+     * File offsets of the first packet record a range read and of the record where
+     * reading stopped, the first one starting at or after the end of the range.
+     */
+    struct ReadExtent {
+        uint64_t first{0};
+        uint64_t end{0};
+    };
+
+    explicit MapReduceJob(std::string directory);
+
+    /**
+     * Creates the job directory if needed, removes claims and summaries of a previous
+     * job and writes the plan.
+     *
+     * @param splitSize bytes per range of a Pcap file, 0 disables splitting
+     */
+    void plan(const std::vector<std::string>& files, uint64_t splitSize);
+
+    /**
+     * Work items of the plan, read from the job directory on the first call.
+     */
+    const std::vector<WorkItem>& getItems();
+
+    /**
+     * Claims older than this without a summary are taken over, 0 (the default) keeps
+     * claims of other hosts forever. Has to exceed the time the largest item takes,
+     * otherwise items are mapped twice, which wastes time but gives the same summary.
+     */
+    void setClaimTimeout(uint64_t seconds) { mClaimTimeout = seconds; }
+
+    /**
+     * Claims and maps items until every item is claimed.
+     *
+     * @return number of items mapped by this call
+     */
+    size_t work();
+
+    /**
+     * Forks worker processes that run work() and waits for them. Throws a
+     * std::runtime_error if a worker failed.
+     */
+    void runWorkers(size_t workers);
+
+    /**
+     * Merges the summaries of all items, throws a std::runtime_error if one is missing.
+     * Ranges that did not start where the previous range of their file stopped are
+     * re-mapped from that offset, and their summaries replaced.
+     */
+    TraceSummary reduce();
+
+    /**
+     * @return number of ranges the last reduce() re-mapped
+     */
+    size_t getRemappedItems() const { return mRemappedItems; }
+
+    /**
+     * Reads the packets of a work item into a summary.
+     *
+     * @param extent set to the offsets read for ranges, if not null
+     * @param synchronize false if the begin of the range is known to be the offset of a
+     * packet record
+     */
+    static TraceSummary map(const WorkItem& item, ReadExtent* extent = nullptr,
+                            bool synchronize = true);
+
+private:
+    std::string itemPath(size_t item, const char* extension) const;
+    bool claim(const std::string& claimPath) const;
+    bool isStale(const std::string& claimPath) const;
+
+    std::string mDirectory;
+    std::vector<WorkItem> mItems;
+    bool mItemsLoaded{false};
+    size_t mRemappedItems{0};
+    uint64_t mClaimTimeout{0};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_MAPREDUCEJOB_H
@@ -0,0 +1,176 @@
+#ifndef MMPR_PACKETDISPATCHER_H
+#define MMPR_PACKETDISPATCHER_H
+
+#include "mmpr/SPSCRingBuffer.h"
+#include "mmpr/mmpr.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * 5-tuple of a flow in canonical order: the endpoint with the smaller address and port
+ * comes first, so both directions of a flow have the same key. IPv4 addresses are
+ * stored as IPv4-mapped IPv6 addresses (::ffff:a.b.c.d). Ports are 0 for fragments and
+ * protocols without ports. Unlike PacketDispatcher::flowHash(), different flows never
+ * share a key.
+ */
+struct FlowKey {
+    std::array<uint8_t, 16> lowAddress{};
+    std::array<uint8_t, 16> highAddress{};
+    uint16_t lowPort{0};
+    uint16_t highPort{0};
+    uint8_t protocol{0};
+
+    bool operator==(const FlowKey& other) const {
+        return lowAddress == other.lowAddress && highAddress == other.highAddress &&
+               lowPort == other.lowPort && highPort == other.highPort &&
+               protocol == other.protocol;
+    }
+    bool operator<(const FlowKey& other) const;
+
+    struct Hash {
+        size_t operator()(const FlowKey& key) const;
+    };
+};
+
+/**
+ * Fixed-size batch of packet descriptors. The descriptors point into the reader's memory,
+ * packet data is never copied.
+ */
+struct PacketBatch {
+    explicit PacketBatch(size_t capacity) : packets(capacity) {}
+
+    std::vector<Packet> packets;
+    size_t size{0};
+};
+
+/**
+ * Reads packets from a single FileReader on the calling thread and distributes them to N
+ * worker threads. Packets are assigned to workers by a symmetric hash over their 5-tuple,
+ * so both directions of a flow are always processed by the same worker.
+ *
+ * Every worker owns a fixed set of batches which circulate over two single-producer
+ * single-consumer rings: filled batches travel from the reader to the worker, processed
+ * batches travel back. Backpressure is therefore bounded and well defined: once all
+ * batches of a worker are in flight, the reader waits for that worker to return one.
+ *
+ * End of stream: after the reader is exhausted, all partially filled batches are
+ * flushed, the workers drain their rings and dispatch() returns once every worker has
+ * finished. Exceptions thrown by the reader or by a worker stop the pipeline and are
+ * re-thrown from dispatch().
+ *
+ * The reader has to stay open until dispatch() returns, as the packet data still points
+ * into its memory.
+ */
+class PacketDispatcher {
+public:
+    struct Config {
+        // number of worker threads
+        size_t workers{1};
+        // number of packets per batch
+        size_t batchSize{64};
+        // number of batches per worker, has to be a power of two
+        size_t batchesPerWorker{64};
+        // CPU to pin worker i to is workerCpus[i % workerCpus.size()], empty disables
+        // pinning of workers
+        std::vector<int> workerCpus;
+        // CPU to pin the reading (calling) thread to for the duration of dispatch(), -1
+        // disables pinning
+        int readerCpu{-1};
+        // assign packets by the epb_hash the capture device wrote into the pcapng trace
+        // (e.g. the RSS hash of the NIC) and only hash the 5-tuple of packets without
+        // one. Both directions of a flow only stay together if the device hash is
+        // symmetric.
+        bool useCaptureHash{false};
+    };
+
+    using BatchFunction =
+        std::function<void(size_t worker, const Packet* packets, size_t count)>;
+
+    PacketDispatcher(FileReader& reader, const Config& config);
+    ~PacketDispatcher();
+
+    /**
+     * Reads all remaining packets and hands them to the workers. Blocks until every
+     * packet has been processed.
+     *
+     * @param fn called on the worker threads for every batch of packets
+     */
+    void dispatch(const BatchFunction& fn);
+
+    /**
+     * Convenience wrapper around dispatch() calling fn(worker, packet) for each packet.
+     * The per-packet call is inlined into the batch loop.
+     */
+    template <typename F>
+    void run(F&& fn) {
+        dispatch([&fn](size_t worker, const Packet* packets, size_t count) {
+            for (size_t i = 0; i < count; ++i) {
+                fn(worker, packets[i]);
+            }
+        });
+    }
+
+    /**
+     * Computes a symmetric hash over the packet's 5-tuple (IP addresses, ports and
+     * protocol), i.e. both directions of a flow get the same hash. Ports are ignored for
+     * fragmented packets so that all fragments of a datagram hash alike. Non-IP packets
+     * hash to 0.
+     *
+     * @param packet packet to hash
+     * @param linkType data link type of the interface the packet was captured on
+     * @return symmetric flow hash
+     */
+    static uint32_t flowHash(const Packet& packet, uint16_t linkType);
+
+    /**
+     * Extracts the canonical 5-tuple of an IPv4 or IPv6 packet, with the same rules
+     * for fragments and IPv6 extension headers as flowHash().
+     *
+     * @return false for non-IP packets, key is left unchanged then
+     */
+    static bool flowKey(const Packet& packet, uint16_t linkType, FlowKey& key);
+
+    /**
+     * Extracts the source address of an IPv4 or IPv6 packet, IPv4 addresses as
+     * IPv4-mapped IPv6 addresses (::ffff:a.b.c.d).
+     *
+     * @return false for non-IP packets, address is left unchanged then
+     */
+    static bool sourceAddress(const Packet& packet, uint16_t linkType,
+                              std::array<uint8_t, 16>& address);
+
+    /**
+     * Maps a 32 bit hash onto [0, workers) with a multiplication instead of a modulo.
+     */
+    static size_t selectWorker(uint32_t hash, size_t workers) {
+        return (size_t)(((uint64_t)hash * workers) >> 32);
+    }
+
+private:
+    struct WorkerQueue {
+        explicit WorkerQueue(size_t batches) : filled(batches), free(batches) {}
+
+        SPSCRingBuffer<PacketBatch*> filled;
+        SPSCRingBuffer<PacketBatch*> free;
+        std::atomic<bool> finished{false};
+        std::vector<std::unique_ptr<PacketBatch>> batches;
+    };
+
+    void work(size_t worker, const BatchFunction& fn);
+    bool acquireBatch(size_t worker, PacketBatch*& batch);
+
+    FileReader& mReader;
+    Config mConfig;
+    std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+    std::atomic<bool> mAborted{false};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_PACKETDISPATCHER_H
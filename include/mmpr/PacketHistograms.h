@@ -0,0 +1,74 @@
+#ifndef MMPR_PACKETHISTOGRAMS_H
+#define MMPR_PACKETHISTOGRAMS_H
+
+#include "mmpr/LogLinearHistogram.h"
+#include "mmpr/mmpr.h"
+#include <cstdint>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Packet size and inter-arrival time distributions by interface, e.g. to size buffers or
+ * to find microbursts.
+ *
+ * Packets of Pcap traces, which have no interfaces, are counted as interface 0. The
+ * inter-arrival time is the difference to the previous packet of the same interface in
+ * nanoseconds, packets with a timestamp before their predecessor count as 0.
+ * startTrace() has to be called between traces, as the first packet of a trace has no
+ * predecessor.
+ */
+class PacketHistograms {
+public:
+    struct Interface {
+        LogLinearHistogram captureLength;
+        LogLinearHistogram length;
+        LogLinearHistogram interArrival;
+        // timestamp of the previous packet, UINT64_MAX before the first one
+        uint64_t lastTimestamp{UINT64_MAX};
+
+        bool operator==(const Interface& other) const {
+            return captureLength == other.captureLength && length == other.length &&
+                   interArrival == other.interArrival;
+        }
+    };
+
+    void record(const Packet& packet) {
+        const size_t index = packet.interfaceIndex < 0 ? 0 : packet.interfaceIndex;
+        if (index >= mInterfaces.size()) {
+            mInterfaces.resize(index + 1);
+        }
+        Interface& interface = mInterfaces[index];
+        interface.captureLength.record(packet.captureLength);
+        interface.length.record(packet.length);
+        if (interface.lastTimestamp != UINT64_MAX) {
+            const uint64_t last = interface.lastTimestamp;
+            const uint64_t timestamp = packet.timestamp;
+            interface.interArrival.record(timestamp > last ? timestamp - last : 0);
+        }
+        interface.lastTimestamp = packet.timestamp;
+    }
+
+    /**
+     * Forgets the previous packet of every interface.
+     */
+    void startTrace();
+
+    /**
+     * Adds the histograms of other interface by interface.
+     */
+    void merge(const PacketHistograms& other);
+
+    const std::vector<Interface>& getInterfaces() const { return mInterfaces; }
+
+    bool operator==(const PacketHistograms& other) const {
+        return mInterfaces == other.mInterfaces;
+    }
+
+private:
+    std::vector<Interface> mInterfaces;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_PACKETHISTOGRAMS_H
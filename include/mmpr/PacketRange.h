@@ -0,0 +1,217 @@
+#ifndef MMPR_PACKETRANGE_H
+#define MMPR_PACKETRANGE_H
+
+#include "mmpr/ByteOrder.h"
+#include "mmpr/mmpr.h"
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#if defined(__cpp_lib_ranges)
+#include <ranges>
+#endif
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define MMPR_HAS_COROUTINES 1
+#endif
+
+namespace mmpr {
+namespace detail {
+
+/**
+ * Reads the next packet through the byte order specific parser of a concrete reader,
+ * the byte order check is a single well predicted branch per packet.
+ */
+template <typename Reader>
+inline bool readNextPacketDirect(Reader& reader, Packet& packet) {
+    if (reader.isSwapped()) {
+        return reader.template readNextPacket<SwappedByteOrder>(packet);
+    }
+    return reader.template readNextPacket<NativeByteOrder>(packet);
+}
+
+/**
+ * Readers only known by their interface are read through the virtual call.
+ */
+inline bool readNextPacketDirect(FileReader& reader, Packet& packet) {
+    return reader.readNextPacket(packet);
+}
+
+} // namespace detail
+
+/**
+ * Single pass range over the remaining packets of an opened reader:
+ *
+ *     for (const mmpr::Packet& packet : reader.packets()) { ... }
+ *
+ * For the concrete reader types the iterator calls the inlined parser directly, ranges
+ * over a FileReader& (e.g. from FileReader::getReader) fall back to the virtual
+ * readNextPacket(). The current packet lives in the iterator and is overwritten by
+ * every increment, copy it to keep it. In C++20 the range models std::ranges::view and
+ * composes with std::views::filter, std::views::take, ...
+ */
+template <typename Reader>
+class PacketRange {
+public:
+    struct Sentinel {};
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Packet;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Packet*;
+        using reference = const Packet&;
+
+        Iterator() = default;
+        explicit Iterator(Reader* reader) : mReader(reader) { ++*this; }
+
+        reference operator*() const { return mPacket; }
+        pointer operator->() const { return &mPacket; }
+
+        Iterator& operator++() {
+            mValid = detail::readNextPacketDirect(*mReader, mPacket);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const Iterator& it, Sentinel) { return !it.mValid; }
+        friend bool operator!=(const Iterator& it, Sentinel) { return it.mValid; }
+#if __cplusplus < 202002L
+        // generated from the operators above in C++20
+        friend bool operator==(Sentinel, const Iterator& it) { return !it.mValid; }
+        friend bool operator!=(Sentinel, const Iterator& it) { return it.mValid; }
+#endif
+
+    private:
+        Reader* mReader{nullptr};
+        Packet mPacket{};
+        bool mValid{false};
+    };
+
+    PacketRange() = default;
+    explicit PacketRange(Reader& reader) : mReader(&reader) {}
+
+    /**
+     * Reads the first packet, every call continues where the previous iteration
+     * stopped.
+     */
+    Iterator begin() const { return Iterator(mReader); }
+    Sentinel end() const { return {}; }
+
+private:
+    Reader* mReader{nullptr};
+};
+
+inline PacketRange<FileReader> FileReader::packets() {
+    return PacketRange<FileReader>(*this);
+}
+
+#ifdef MMPR_HAS_COROUTINES
+/**
+ * Coroutine generator over the packets of a reader, for code that wants to hand out
+ * packets lazily from its own coroutines. The range from packets() is the cheaper way
+ * to iterate, the generator allocates a coroutine frame per reader.
+ */
+class PacketGenerator {
+public:
+    struct promise_type {
+        const Packet* current{nullptr};
+        std::exception_ptr exception;
+
+        PacketGenerator get_return_object() {
+            return PacketGenerator(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        std::suspend_always yield_value(const Packet& packet) noexcept {
+            current = &packet;
+            return {};
+        }
+        void return_void() noexcept {}
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    struct Sentinel {};
+
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Packet;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Packet*;
+        using reference = const Packet&;
+
+        Iterator() = default;
+        explicit Iterator(std::coroutine_handle<promise_type> handle) : mHandle(handle) {}
+
+        reference operator*() const { return *mHandle.promise().current; }
+        pointer operator->() const { return mHandle.promise().current; }
+        Iterator& operator++() {
+            resume(mHandle);
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+
+        friend bool operator==(const Iterator& it, Sentinel) { return it.mHandle.done(); }
+
+    private:
+        std::coroutine_handle<promise_type> mHandle;
+    };
+
+    PacketGenerator(PacketGenerator&& other) noexcept
+        : mHandle(std::exchange(other.mHandle, nullptr)) {}
+    PacketGenerator& operator=(PacketGenerator&& other) noexcept {
+        std::swap(mHandle, other.mHandle);
+        return *this;
+    }
+    ~PacketGenerator() {
+        if (mHandle) {
+            mHandle.destroy();
+        }
+    }
+
+    Iterator begin() {
+        resume(mHandle);
+        return Iterator(mHandle);
+    }
+    Sentinel end() const { return {}; }
+
+private:
+    explicit PacketGenerator(std::coroutine_handle<promise_type> handle)
+        : mHandle(handle) {}
+
+    static void resume(std::coroutine_handle<promise_type> handle) {
+        handle.resume();
+        if (handle.promise().exception) {
+            std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+        }
+    }
+
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+/**
+ * Lazily yields the remaining packets of an opened reader.
+ */
+template <typename Reader>
+inline PacketGenerator generatePackets(Reader& reader) {
+    Packet packet;
+    while (detail::readNextPacketDirect(reader, packet)) {
+        co_yield packet;
+    }
+}
+#endif
+
+} // namespace mmpr
+
+#if defined(__cpp_lib_ranges)
+template <typename Reader>
+inline constexpr bool std::ranges::enable_borrowed_range<mmpr::PacketRange<Reader>> =
+    true;
+template <typename Reader>
+inline constexpr bool std::ranges::enable_view<mmpr::PacketRange<Reader>> = true;
+#endif
+
+#endif // MMPR_PACKETRANGE_H
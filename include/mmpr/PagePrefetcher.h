@@ -0,0 +1,105 @@
+#ifndef MMPR_PAGEPREFETCHER_H
+#define MMPR_PAGEPREFETCHER_H
+
+#include "mmpr/mmpr.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Counters of a PagePrefetcher, can be read while it is running.
+ */
+struct PrefetchStats {
+    // bytes handed to the kernel for prefetching
+    uint64_t bytesPrefetched{0};
+    // pages that were not resident before the prefetcher loaded them ahead of the
+    // parser, each of them would have been a major fault on the parsing thread (an
+    // estimate for the asynchronous methods, which may still be in flight)
+    uint64_t faultsAvoided{0};
+    // number of times the parser was already past the prefetched region
+    uint64_t parserOvertook{0};
+};
+
+/**
+ * Keeps a window of a memory mapped trace file resident ahead of the parser, so reading a
+ * trace that is not in the page cache does not stall the parsing thread on major page
+ * faults. The prefetching runs on a helper thread, which follows the offset the parsing
+ * thread publishes with advance():
+ *
+ *     mmpr::PagePrefetcher prefetcher(reader);
+ *     while (reader.readNextPacket(packet)) {
+ *         prefetcher.advance(reader.getCurrentOffset());
+ *         ...
+ *     }
+ *
+ * advance() is a single relaxed atomic store. The prefetcher needs a reader that maps
+ * its file (FileReader::getMappedMemory()), the reader has to stay open until the
+ * prefetcher is stopped or destroyed.
+ */
+class PagePrefetcher {
+public:
+    enum Method {
+        // madvise(MADV_POPULATE_READ), also maps the pages into the reader's page tables
+        // and therefore avoids minor faults as well. Falls back to MADV_WILLNEED on
+        // kernels older than 5.14.
+        POPULATE_READ,
+        // madvise(MADV_WILLNEED), asynchronous read into the page cache
+        WILLNEED,
+        // readahead(2) on a duplicate of the reader's descriptor of the mapped file
+        // (FileReader::getMappedFileDescriptor()), MADV_WILLNEED without one
+        READAHEAD
+    };
+
+    struct Config {
+        // bytes kept resident ahead of the parser
+        size_t window{64 * 1024 * 1024};
+        // bytes prefetched per system call, rounded up to whole pages
+        size_t chunkSize{2 * 1024 * 1024};
+        Method method{POPULATE_READ};
+    };
+
+    explicit PagePrefetcher(const FileReader& reader);
+    PagePrefetcher(const FileReader& reader, const Config& config);
+    ~PagePrefetcher();
+
+    PagePrefetcher(const PagePrefetcher&) = delete;
+    PagePrefetcher& operator=(const PagePrefetcher&) = delete;
+
+    /**
+     * Publishes the current offset of the parser, called from the parsing thread.
+     */
+    void advance(size_t offset) {
+        mParserOffset.store(offset, std::memory_order_relaxed);
+    }
+
+    /**
+     * Stops and joins the helper thread, called by the destructor.
+     */
+    void stop();
+
+    PrefetchStats getStats() const;
+
+private:
+    void run();
+    void prefetch(size_t offset, size_t length);
+
+    const uint8_t* mData{nullptr};
+    size_t mFileSize{0};
+    Config mConfig;
+    int mFileDescriptor{-1};
+    std::atomic<size_t> mParserOffset{0};
+    std::atomic<bool> mStopped{false};
+    std::atomic<uint64_t> mBytesPrefetched{0};
+    std::atomic<uint64_t> mFaultsAvoided{0};
+    std::atomic<uint64_t> mParserOvertook{0};
+    // mincore() result buffer, only used by the helper thread
+    std::vector<unsigned char> mResidency;
+    std::thread mThread;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_PAGEPREFETCHER_H
@@ -0,0 +1,99 @@
+#ifndef MMPR_PROFILER_H
+#define MMPR_PROFILER_H
+
+/**
+ * Cycle timers of the hot paths, compiled in with the CMake option MMPR_PROFILE. Every
+ * MMPR_PROFILE_SCOPE(section) adds the cycles until the end of its scope to a histogram
+ * of the calling thread, which the readers print to stderr in close() (or
+ * MMPR_PROFILE_DUMP()). Without the option, both macros compile to nothing.
+ */
+#if MMPR_PROFILE
+
+#include <cstdint>
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+namespace mmpr {
+namespace profile {
+
+enum Section : uint8_t {
+    // PcapNgBlockParser::readEPB()
+    EPB_HEADER,
+    // TimestampConverter::toNanoseconds(), also of util::calculateTimestamps()
+    TIMESTAMP,
+    // option walks of the block parser
+    OPTIONS,
+    // Zstd decompression of a trace
+    DECOMPRESSION,
+    SECTION_COUNT
+};
+
+// bucket i counts durations in [2^i, 2^(i+1)) cycles, 0 and 1 cycle go to bucket 0
+constexpr int BUCKETS = 64;
+
+struct Histogram {
+    uint64_t count;
+    uint64_t cycles;
+    uint64_t buckets[BUCKETS];
+};
+
+struct ThreadProfile {
+    Histogram sections[SECTION_COUNT];
+};
+
+// zero-initialized without a constructor, accessing it needs no initialization guard
+inline thread_local ThreadProfile threadProfile{};
+
+/**
+ * Time stamp counter on x86, nanoseconds of the steady clock elsewhere.
+ */
+inline uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+}
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Section section) : mSection(section), mStart(now()) {}
+    ~ScopedTimer() {
+        const uint64_t cycles = now() - mStart;
+        Histogram& histogram = threadProfile.sections[mSection];
+        ++histogram.count;
+        histogram.cycles += cycles;
+        ++histogram.buckets[63 - __builtin_clzll(cycles | 1)];
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Section mSection;
+    uint64_t mStart;
+};
+
+/**
+ * Prints the histograms of the calling thread and clears them.
+ */
+void dump(FILE* file);
+
+} // namespace profile
+} // namespace mmpr
+
+#define MMPR_PROFILE_SCOPE(section)                                                      \
+    ::mmpr::profile::ScopedTimer mmprProfileTimer(::mmpr::profile::section)
+#define MMPR_PROFILE_DUMP() ::mmpr::profile::dump(stderr)
+#else
+#define MMPR_PROFILE_SCOPE(section) while (0)
+#define MMPR_PROFILE_DUMP() while (0)
+#endif
+
+#endif // MMPR_PROFILER_H
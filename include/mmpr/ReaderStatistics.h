@@ -0,0 +1,44 @@
+#ifndef MMPR_READERSTATISTICS_H
+#define MMPR_READERSTATISTICS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace mmpr {
+
+/**
+ * Counters of a reader since its last open(), see FileReader::setStatisticsEnabled().
+ */
+struct ReaderStatistics {
+    uint64_t packets{0};
+    // captured bytes of the delivered packets
+    uint64_t capturedBytes{0};
+    // original (on the wire) bytes of the delivered packets
+    uint64_t bytes{0};
+    // PcapNG blocks seen by block type, Pcap records are not counted
+    std::map<uint32_t, uint64_t> blocks;
+    // bytes of unsupported block types and of ranges skipped in recovery mode
+    uint64_t skippedBytes{0};
+    // time spent decompressing in open() and parsing in readNextPacket()
+    uint64_t decompressionNanoseconds{0};
+    uint64_t parsingNanoseconds{0};
+    // page faults of the calling thread since open() (getrusage(RUSAGE_THREAD))
+    uint64_t majorPageFaults{0};
+    uint64_t minorPageFaults{0};
+    // mapped bytes of the file and how many of them are resident (mincore()), 0 for
+    // readers that do not map the file
+    uint64_t mappedBytes{0};
+    uint64_t residentBytes{0};
+
+    /**
+     * Single line JSON object, block types are named like in the PcapNG specification
+     * ("enhanced_packet", ...), unknown types by their hexadecimal value.
+     */
+    std::string toJson() const;
+    static std::string blockTypeName(uint32_t blockType);
+};
+
+} // namespace mmpr
+
+#endif // MMPR_READERSTATISTICS_H
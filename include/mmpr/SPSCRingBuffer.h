@@ -0,0 +1,86 @@
+#ifndef MMPR_SPSCRINGBUFFER_H
+#define MMPR_SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define MMPR_CACHE_LINE_SIZE 64
+
+namespace mmpr {
+/**
+ * Bounded, lock-free ring buffer for exactly one producer and one consumer thread.
+ *
+ * Head and tail live on separate cache lines, and each side keeps a private copy of the
+ * other side's index, so the shared cache lines are only touched when the ring looks
+ * full (producer) or empty (consumer).
+ */
+template <typename T>
+class SPSCRingBuffer {
+public:
+    /**
+     * @param capacity number of slots, has to be a power of two
+     */
+    explicit SPSCRingBuffer(size_t capacity) : mSlots(capacity), mMask(capacity - 1) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("SPSCRingBuffer capacity has to be a power of two "
+                                        "greater than one, but got " +
+                                        std::to_string(capacity));
+        }
+    }
+
+    SPSCRingBuffer(const SPSCRingBuffer&) = delete;
+    SPSCRingBuffer& operator=(const SPSCRingBuffer&) = delete;
+
+    /**
+     * Producer side. Returns false without blocking if the ring is full.
+     */
+    bool tryPush(const T& value) {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mCachedTail == mSlots.size()) {
+            mCachedTail = mTail.load(std::memory_order_acquire);
+            if (head - mCachedTail == mSlots.size()) {
+                return false;
+            }
+        }
+        mSlots[head & mMask] = value;
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer side. Returns false without blocking if the ring is empty.
+     */
+    bool tryPop(T& value) {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail == mCachedHead) {
+            mCachedHead = mHead.load(std::memory_order_acquire);
+            if (tail == mCachedHead) {
+                return false;
+            }
+        }
+        value = mSlots[tail & mMask];
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mSlots.size(); }
+
+private:
+    std::vector<T> mSlots;
+    const size_t mMask;
+
+    // written by the producer
+    alignas(MMPR_CACHE_LINE_SIZE) std::atomic<size_t> mHead{0};
+    size_t mCachedTail{0};
+
+    // written by the consumer
+    alignas(MMPR_CACHE_LINE_SIZE) std::atomic<size_t> mTail{0};
+    size_t mCachedHead{0};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_SPSCRINGBUFFER_H
@@ -0,0 +1,71 @@
+#ifndef MMPR_TRACESUMMARY_H
+#define MMPR_TRACESUMMARY_H
+
+#include "mmpr/PacketDispatcher.h"
+#include "mmpr/mmpr.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace mmpr {
+
+/**
+ * Mergeable summary of the packets of traces or byte ranges of traces: counters, a
+ * packet length histogram and per-flow counters. merge() is associative and commutative,
+ * so partial summaries of workers combine to the same result however the input was
+ * split and in whichever order they are merged.
+ *
+ * The binary encoding (serialize()) is a magic number and version followed by LEB128
+ * varints, flows are sorted by key and IPv4 addresses take 4 bytes. It does not depend
+ * on the byte order of the host.
+ */
+struct TraceSummary {
+    struct FlowCounters {
+        uint64_t packets{0};
+        uint64_t bytes{0};
+
+        bool operator==(const FlowCounters& other) const {
+            return packets == other.packets && bytes == other.bytes;
+        }
+    };
+
+    // bucket i counts packets whose original length has a bit width of i, i.e. lies in
+    // [2^(i-1), 2^i)
+    static constexpr size_t LENGTH_BUCKETS = 33;
+
+    uint64_t packets{0};
+    uint64_t bytes{0};
+    uint64_t capturedBytes{0};
+    // nanoseconds since 1970-01-01 00:00:00 UTC, UINT64_MAX and 0 without packets
+    uint64_t firstTimestamp{UINT64_MAX};
+    uint64_t lastTimestamp{0};
+    std::array<uint64_t, LENGTH_BUCKETS> lengthHistogram{};
+    // by the canonical 5-tuple of PacketDispatcher::flowKey(), non-IP packets are
+    // counted under the all zero key
+    std::unordered_map<FlowKey, FlowCounters, FlowKey::Hash> flows;
+
+    /**
+     * @param linkType data link type of the interface the packet was captured on
+     */
+    void add(const Packet& packet, uint16_t linkType);
+    void merge(const TraceSummary& other);
+
+    std::string serialize() const;
+    /**
+     * Throws a std::runtime_error if data is not a complete summary of this version.
+     */
+    static TraceSummary deserialize(const std::string& data);
+    /**
+     * Writes the serialized summary to a temporary file which is renamed to filepath, so
+     * readers never see a partially written summary.
+     */
+    void writeFile(const std::string& filepath) const;
+    static TraceSummary readFile(const std::string& filepath);
+
+    bool operator==(const TraceSummary& other) const;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_TRACESUMMARY_H
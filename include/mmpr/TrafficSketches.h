@@ -0,0 +1,54 @@
+#ifndef MMPR_TRAFFICSKETCHES_H
+#define MMPR_TRAFFICSKETCHES_H
+
+#include "mmpr/HeavyHitters.h"
+#include "mmpr/HyperLogLog.h"
+#include "mmpr/mmpr.h"
+#include <cstdint>
+#include <string>
+
+namespace mmpr {
+
+/**
+ * Bounded-memory traffic statistics of IP packets: the top sources by bytes and by
+ * packets and the number of distinct sources and flows. The footprint does not grow
+ * with the number of packets, sources or flows, about 290 KiB with the defaults.
+ *
+ * Sources are IP source addresses, flows are identified by the symmetric 5-tuple hash
+ * of PacketDispatcher::flowHash(). Non-IP packets are not counted. Threads record into
+ * their own instance, merge() combines them.
+ */
+class TrafficSketches {
+public:
+    /**
+     * @param topSources number of sources kept in the top lists
+     */
+    explicit TrafficSketches(size_t topSources = 64);
+
+    /**
+     * @param linkType data link type of the interface the packet was captured on
+     */
+    void record(const Packet& packet, uint16_t linkType);
+
+    void merge(const TrafficSketches& other);
+
+    const HeavyHitters& getSourcesByBytes() const { return mSourcesByBytes; }
+    const HeavyHitters& getSourcesByPackets() const { return mSourcesByPackets; }
+    const HyperLogLog& getDistinctSources() const { return mDistinctSources; }
+    const HyperLogLog& getDistinctFlows() const { return mDistinctFlows; }
+
+    /**
+     * Formats an address of the top lists, IPv4-mapped addresses in dotted decimal.
+     */
+    static std::string formatAddress(const HeavyHitters::Key& address);
+
+private:
+    HeavyHitters mSourcesByBytes;
+    HeavyHitters mSourcesByPackets;
+    HyperLogLog mDistinctSources;
+    HyperLogLog mDistinctFlows;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_TRAFFICSKETCHES_H
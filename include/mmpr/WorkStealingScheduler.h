@@ -0,0 +1,74 @@
+#ifndef MMPR_WORKSTEALINGSCHEDULER_H
+#define MMPR_WORKSTEALINGSCHEDULER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Runs independent tasks of known weight, e.g. trace files by size, on N threads.
+ *
+ * The tasks are sorted by weight, heaviest first, and dealt round-robin onto one deque
+ * per thread, so every thread starts with one of the heaviest tasks. A thread takes the
+ * tasks of its own deque front to back. Once it is empty, the thread steals the front
+ * task, i.e. the heaviest remaining one, of the deque with the most remaining weight.
+ * Large tasks therefore never end up last behind a straggler. Tasks are coarse, the
+ * deques are guarded by a mutex each.
+ *
+ * The calling thread works as thread 0. If a task throws, the remaining tasks are
+ * skipped and the first exception is re-thrown from run().
+ */
+class WorkStealingScheduler {
+public:
+    using TaskFunction = std::function<void(size_t task, size_t thread)>;
+
+    /**
+     * @param threads number of threads, at least 1
+     */
+    explicit WorkStealingScheduler(size_t threads);
+
+    /**
+     * Calls fn once for every task and blocks until all tasks are done.
+     *
+     * @param weights weight of every task, the task index is the position in weights
+     * @param fn called with the task index and the index of the executing thread
+     */
+    void run(const std::vector<uint64_t>& weights, const TaskFunction& fn);
+
+    size_t getThreads() const { return mThreads; }
+
+    /**
+     * @return number of tasks each thread stole from others in the last run()
+     */
+    const std::vector<uint64_t>& getStolenTasks() const { return mStolenTasks; }
+
+private:
+    struct TaskDeque {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+        uint64_t weight{0};
+    };
+
+    void work(size_t thread, const TaskFunction& fn);
+    bool take(size_t thread, size_t& task);
+    bool steal(size_t thread, size_t& task);
+
+    size_t mThreads;
+    const std::vector<uint64_t>* mWeights{nullptr};
+    std::vector<std::unique_ptr<TaskDeque>> mDeques;
+    std::vector<uint64_t> mStolenTasks;
+    std::atomic<bool> mAborted{false};
+    std::mutex mExceptionMutex;
+    std::exception_ptr mException;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_WORKSTEALINGSCHEDULER_H
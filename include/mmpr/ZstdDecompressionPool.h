@@ -0,0 +1,85 @@
+#ifndef MMPR_ZSTDDECOMPRESSIONPOOL_H
+#define MMPR_ZSTDDECOMPRESSIONPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Reusable decompression state for many compressed trace files. Decompressing a file
+ * with a fresh context into freshly allocated memory costs a context setup plus the
+ * zeroing of every page of the buffers, which dominates for thousands of small rotated
+ * captures. The pool keeps ZSTD_DCtx objects and grow-only buffers (anonymous mappings,
+ * advised to use transparent huge pages) and hands them out again for the next file.
+ *
+ * The pool is thread-safe, readers sharing it may decompress concurrently. A decompressed
+ * buffer belongs to its reader until it is released, every open reader holds one buffer.
+ * Readers share a pool by being created with the same instance, e.g. through
+ * FileReader::getReader(filepath, pool).
+ */
+class ZstdDecompressionPool {
+public:
+    struct Stats {
+        // files decompressed through the pool
+        uint64_t decompressions{0};
+        // buffers mapped (new or grown), decompressions without are served from the pool
+        uint64_t bufferAllocations{0};
+        // ZSTD_DCtx objects created
+        uint64_t contextAllocations{0};
+        uint64_t bytesDecompressed{0};
+    };
+
+    ZstdDecompressionPool() = default;
+    ~ZstdDecompressionPool();
+
+    ZstdDecompressionPool(const ZstdDecompressionPool&) = delete;
+    ZstdDecompressionPool& operator=(const ZstdDecompressionPool&) = delete;
+
+    /**
+     * Decompresses a single-frame zstd file into a pooled buffer.
+     *
+     * @param decompressedSize set to the size of the decompressed data
+     * @return the decompressed data, has to be handed back with release()
+     */
+    const uint8_t* decompress(const std::string& filepath, size_t& decompressedSize);
+    /**
+     * Like decompress(filepath, decompressedSize) for an already opened file, which is
+     * read with pread() and not closed. filepath is only used for messages.
+     */
+    const uint8_t* decompress(int fileDescriptor,
+                              const std::string& filepath,
+                              size_t& decompressedSize);
+
+    /**
+     * Returns a buffer from decompress() to the pool.
+     */
+    void release(const uint8_t* data);
+
+    Stats getStats() const;
+
+private:
+    struct Buffer {
+        uint8_t* data{nullptr};
+        size_t capacity{0};
+    };
+
+    Buffer acquireBuffer(size_t size);
+    void releaseBuffer(const Buffer& buffer);
+    void* acquireContext();
+    void releaseContext(void* context);
+
+    mutable std::mutex mMutex;
+    std::vector<Buffer> mFreeBuffers;
+    std::vector<Buffer> mUsedBuffers;
+    // ZSTD_DCtx*, kept opaque to not expose zstd.h
+    std::vector<void*> mFreeContexts;
+    Stats mStats{};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_ZSTDDECOMPRESSIONPOOL_H
@@ -5,15 +5,22 @@
 
 namespace mmpr {
 
-class ZstdDecompressor {
+/**
+ * Deprecated, use ZstdDecompressionPool, which reuses contexts and buffers across files.
+ * Kept for existing callers as a wrapper that decompresses through a pool of its own.
+ */
+class [[deprecated("use mmpr::ZstdDecompressionPool")]] ZstdDecompressor {
 public:
+    /**
+     * Decompresses a single-frame zstd file.
+     *
+     * @param decompressedSize set to the size of the decompressed data
+     * @param mmap ignored, the file is always read through the pool
+     * @return the decompressed data, allocated with malloc() and owned by the caller
+     */
     static void* decompressFileInMemory(const std::string& filename,
                                         size_t& decompressedSize,
                                         bool mmap = false);
-
-private:
-    static void* decompressFileMMAP(const std::string& fname, size_t& decompressedSize);
-    static void* decompressFileFRead(const std::string& fname, size_t& decompressedSize);
 };
 
 } // namespace mmpr
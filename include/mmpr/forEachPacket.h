@@ -0,0 +1,99 @@
+#ifndef MMPR_FOREACHPACKET_H
+#define MMPR_FOREACHPACKET_H
+
+#include "mmpr/ByteOrder.h"
+#include "mmpr/mmpr.h"
+#include "mmpr/modified_pcap/MMModifiedPcapReader.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng/PcapNgReader.h"
+#include <type_traits>
+
+namespace mmpr {
+namespace detail {
+
+/**
+ * Calls fn for a single packet, callables returning void never stop the loop.
+ */
+template <typename F>
+inline bool invokePacketFunction(F& fn, const Packet& packet) {
+    if constexpr (std::is_void_v<std::invoke_result_t<F&, const Packet&>>) {
+        fn(packet);
+        return true;
+    } else {
+        return static_cast<bool>(fn(packet));
+    }
+}
+
+/**
+ * Runs the inlined loop as long as the reader stays in the given byte order.
+ *
+ * @return true if the loop has to be continued in the other byte order (a new pcapng
+ *         section), false if the reader is drained or fn asked to stop
+ */
+template <typename ByteOrder, typename Reader, typename F>
+inline bool forEachPacketInOrder(Reader& reader, F& fn, size_t& count) {
+    Packet packet;
+    while (reader.isSwapped() == ByteOrder::SWAPPED) {
+        if (!reader.template readNextPacket<ByteOrder>(packet)) {
+            return false;
+        }
+        ++count;
+        if (!invokePacketFunction(fn, packet)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Reader, typename F>
+inline size_t forEachPacketOf(Reader& reader, F& fn) {
+    size_t count{0};
+    bool proceed{true};
+    while (proceed) {
+        proceed = reader.isSwapped()
+                      ? forEachPacketInOrder<SwappedByteOrder>(reader, fn, count)
+                      : forEachPacketInOrder<NativeByteOrder>(reader, fn, count);
+    }
+    return count;
+}
+
+} // namespace detail
+
+/**
+ * Calls fn for every remaining packet of the opened reader. The concrete reader type is
+ * determined once, afterwards the packets are parsed by a loop without virtual calls,
+ * which lets the compiler inline fn into the parsing. Readers of unknown types fall back
+ * to calling readNextPacket() virtually, subclasses of the built-in readers must not
+ * override readNextPacket().
+ *
+ * fn is called with a const Packet&. If it returns a bool, returning false stops the
+ * iteration after the current packet.
+ *
+ * @return number of packets passed to fn
+ */
+template <typename F>
+inline size_t forEachPacket(FileReader& reader, F&& fn) {
+    if (auto* pcapReader = dynamic_cast<MMPcapReader*>(&reader)) {
+        return detail::forEachPacketOf(*pcapReader, fn);
+    }
+    if (auto* pcapNgReader = dynamic_cast<PcapNgReader*>(&reader)) {
+        return detail::forEachPacketOf(*pcapNgReader, fn);
+    }
+    if (auto* modifiedPcapReader = dynamic_cast<MMModifiedPcapReader*>(&reader)) {
+        return detail::forEachPacketOf(*modifiedPcapReader, fn);
+    }
+
+    size_t count{0};
+    Packet packet;
+    while (reader.readNextPacket(packet)) {
+        ++count;
+        if (!detail::invokePacketFunction(fn, packet)) {
+            break;
+        }
+    }
+    return count;
+}
+
+} // namespace mmpr
+
+#endif // MMPR_FOREACHPACKET_H
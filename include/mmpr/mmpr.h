@@ -4,10 +4,13 @@
 #include "mmpr/modified_pcap.h"
 #include "mmpr/pcap.h"
 #include "mmpr/pcapng.h"
+#include "mmpr/ReaderStatistics.h"
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 #include <vector>
 
 #if DEBUG
@@ -23,6 +26,8 @@
 #define MMPR_WARN_1(msg, val) fprintf(stderr, msg, val)
 #define MMPR_UNUSED(x) (void)(x)
 
+// deprecated compile-time fallback, the page size of the running system is
+// FileReader::getPageSize()
 #define MMPR_PAGE_SIZE 4096
 
 #define MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS 0xA1B2C3D4
@@ -30,16 +35,48 @@
 #define MMPR_MAGIC_NUMBER_PCAPNG 0x0A0D0D0A
 #define MMPR_MAGIC_NUMBER_ZSTD 0xFD2FB528
 #define MMPR_MAGIC_NUMBER_MODIFIED_PCAP 0xA1B2CD34
+// magic numbers as read on a host with the opposite endianness of the writer
+#define MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS_SWAPPED 0xD4C3B2A1
+#define MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS_SWAPPED 0x4D3CB2A1
+#define MMPR_MAGIC_NUMBER_MODIFIED_PCAP_SWAPPED 0x34CDB2A1
 
 namespace mmpr {
 
 struct Packet {
+    // nanoseconds since 1970-01-01 00:00:00 UTC
+    uint64_t timestamp{0};
     uint32_t timestampSeconds{0};
     uint32_t timestampMicroseconds{0};
     uint32_t captureLength{0};
     uint32_t length{0};
     int interfaceIndex{-1};
+    // byte order of optionsBlock
+    bool optionsSwapped{false};
     const uint8_t* data{nullptr};
+    // Enhanced Packet Block of the packet if the block has options, nullptr otherwise,
+    // decoded on demand by PcapNgReader::readPacketOptions()
+    const uint8_t* optionsBlock{nullptr};
+
+    /**
+     * Sets the nanosecond timestamp and derives seconds and microseconds from it (the
+     * divisions by constants compile to multiplications).
+     */
+    void setTimestamp(uint64_t nanoseconds) {
+        timestamp = nanoseconds;
+        timestampSeconds = (uint32_t)(nanoseconds / 1000000000);
+        timestampMicroseconds = (uint32_t)(nanoseconds % 1000000000 / 1000);
+    }
+};
+
+/**
+ * Byte range of a trace a reader in recovery mode skipped, because it did not hold
+ * valid records.
+ */
+struct SkippedRange {
+    size_t offset{0};
+    size_t length{0};
+    // description of the first invalid record of the range
+    std::string reason;
 };
 
 struct TraceInterface {
@@ -56,14 +93,63 @@ struct TraceInterface {
     std::optional<std::string> os;
 };
 
+template <typename Reader>
+class PacketRange;
+class ZstdDecompressionPool;
+class DecompressedTraceCache;
+
 class FileReader {
 protected:
     FileReader(const std::string& filepath);
+    /**
+     * For readers of an already opened file, takes ownership of fileDescriptor (also if
+     * the constructor throws). filepath is only used for getFilepath() and messages.
+     */
+    FileReader(const std::string& filepath, int fileDescriptor);
+
+    /**
+     * Opens the file for open(), by duplicating the descriptor passed to the constructor
+     * or by its path.
+     *
+     * @return the new descriptor, negative with errno set on failure
+     */
+    int openFile() const;
+
+    /**
+     * Zeroes the statistics at the start of open(), if they are enabled.
+     */
+    void resetStatistics();
+    /**
+     * Records the bytes [start, end) skipped in recovery mode, as part of the last range
+     * if that ends at start, and counts them in the statistics.
+     */
+    void recordSkippedRange(std::vector<SkippedRange>& ranges,
+                            size_t start,
+                            size_t end,
+                            const std::string& reason);
+    /**
+     * Calls read(packet) and accounts the packet and the time spent in it, for the
+     * readNextPacket() of readers with statistics enabled.
+     */
+    template <typename Read>
+    bool readNextPacketCounted(Packet& packet, Read read);
 
     std::string mFilepath;
+    // descriptor passed to the constructor, -1 if the file is opened by its path
+    int mSourceDescriptor{-1};
+    // nullptr unless statistics are enabled, checked once per packet
+    std::unique_ptr<ReaderStatistics> mStatistics;
+
+private:
+    // page faults of the calling thread when the reader was opened
+    uint64_t mMajorPageFaultsAtOpen{0};
+    uint64_t mMinorPageFaultsAtOpen{0};
 
 public:
-    virtual ~FileReader() = default;
+    virtual ~FileReader();
+
+    FileReader(const FileReader&) = delete;
+    FileReader& operator=(const FileReader&) = delete;
 
     virtual void open() = 0;
     virtual void close() = 0;
@@ -73,12 +159,103 @@ public:
     virtual std::string getFilepath() const = 0;
     virtual size_t getCurrentOffset() const = 0;
     virtual uint16_t getDataLinkType() const = 0;
+    /**
+     * Link type of a packet just read, which differs between the interfaces of a
+     * PcapNG trace.
+     */
+    virtual uint16_t getDataLinkType(const Packet& /*packet*/) const {
+        return getDataLinkType();
+    }
     virtual std::vector<TraceInterface> getTraceInterfaces() const = 0;
     virtual TraceInterface getTraceInterface(size_t id) const = 0;
+    /**
+     * Start of the memory mapped file while the reader is open, nullptr if the reader
+     * does not map the file (e.g. decompressed traces).
+     */
+    virtual const uint8_t* getMappedMemory() const { return nullptr; }
+    /**
+     * Descriptor of the file behind getMappedMemory() while the reader is open, -1 if
+     * the reader does not map a file. Owned by the reader.
+     */
+    virtual int getMappedFileDescriptor() const { return -1; }
+    /**
+     * Page size of the system, the granularity of mappings, madvise() and mincore().
+     */
+    static size_t getPageSize();
+
+    /**
+     * Enables counting packets, blocks and time for getStatistics(). Counting starts
+     * with this call and every open() starts over from zero, so enabling before open()
+     * covers the whole trace. Disabling drops the counts. Readers with statistics take
+     * a slower path through readNextPacket() that reads the clock twice per packet,
+     * others are not affected.
+     */
+    void setStatisticsEnabled(bool enabled);
+    /**
+     * Statistics since open(), all zero if they are not enabled. Page faults and
+     * resident bytes are measured by the call, so it has to be made by the reading
+     * thread before close().
+     */
+    ReaderStatistics getStatistics() const;
+
+    /**
+     * Range over the remaining packets, read through the virtual readNextPacket(). The
+     * concrete readers return a range that calls their parser directly.
+     */
+    PacketRange<FileReader> packets();
 
     static std::unique_ptr<FileReader> getReader(const std::string& filepath);
+    /**
+     * Like getReader(filepath), compressed files are decompressed with the contexts and
+     * buffers of the given pool, which is shared by all readers created with it.
+     */
+    static std::unique_ptr<FileReader>
+    getReader(const std::string& filepath,
+              const std::shared_ptr<ZstdDecompressionPool>& pool);
+    /**
+     * Like getReader(filepath), compressed files are read from the decompressed copies
+     * in the cache. The reader for a cached trace is an MMPcapNgReader mapping the copy.
+     */
+    static std::unique_ptr<FileReader>
+    getCachedReader(const std::string& filepath,
+                    const std::shared_ptr<DecompressedTraceCache>& cache);
+    /**
+     * Creates the reader for an already opened file, the format is determined by a
+     * single pread() of the magic number. Takes ownership of fileDescriptor, the file is
+     * not opened again by its path.
+     */
+    static std::unique_ptr<FileReader>
+    getReader(int fileDescriptor,
+              const std::string& filepath,
+              const std::shared_ptr<ZstdDecompressionPool>& pool = nullptr);
 };
 
+template <typename Read>
+inline bool FileReader::readNextPacketCounted(Packet& packet, Read read) {
+    const auto start = std::chrono::steady_clock::now();
+    // accounts the time also if read() throws
+    struct Stopwatch {
+        std::chrono::steady_clock::time_point start;
+        uint64_t& nanoseconds;
+        ~Stopwatch() {
+            nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+        }
+    } stopwatch{start, mStatistics->parsingNanoseconds};
+
+    if (!read(packet)) {
+        return false;
+    }
+    ++mStatistics->packets;
+    mStatistics->capturedBytes += packet.captureLength;
+    mStatistics->bytes += packet.length;
+    return true;
+}
+
 } // namespace mmpr
 
+// needs the complete FileReader, defines FileReader::packets()
+#include "mmpr/PacketRange.h"
+
 #endif // MMPR_MMPR_H
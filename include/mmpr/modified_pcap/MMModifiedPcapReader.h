@@ -2,6 +2,7 @@
 #define MMPR_MMRAWREADER_H
 
 #include "mmpr/mmpr.h"
+#include "mmpr/modified_pcap/ModifiedPcapParser.h"
 #include "mmpr/modified_pcap/ModifiedPcapReader.h"
 #include <sstream>
 #include <stdexcept>
@@ -12,22 +13,99 @@ namespace mmpr {
 class MMModifiedPcapReader : public ModifiedPcapReader {
 public:
     explicit MMModifiedPcapReader(const std::string& filepath);
+    /**
+     * Reads the already opened file, takes ownership of fileDescriptor.
+     */
+    MMModifiedPcapReader(const std::string& filepath, int fileDescriptor);
 
     void open() override;
-    bool isExhausted() const override;
+    bool isExhausted() const override { return mOffset >= mFileSize; }
     bool readNextPacket(Packet& packet) override;
     void close() override;
+    const uint8_t* getMappedMemory() const override { return mMappedMemory; }
+    int getMappedFileDescriptor() const override {
+        return mMappedMemory != nullptr ? mFileDescriptor : -1;
+    }
+
+    /**
+     * Variant of readNextPacket() for a fixed byte order, which has to match
+     * isSwapped(). Defined in the header so forEachPacket() can inline it.
+     */
+    template <typename ByteOrder>
+    bool readNextPacket(Packet& packet);
+    bool isSwapped() const { return mSwapped; }
+    PacketRange<MMModifiedPcapReader> packets() {
+        return PacketRange<MMModifiedPcapReader>(*this);
+    }
 
     size_t getFileSize() const override { return mFileSize; }
     size_t getCurrentOffset() const override { return mOffset; }
 
 private:
+    template <typename ByteOrder>
+    bool readPacket(Packet& packet);
+    /**
+     * readNextPacket() with statistics enabled.
+     */
+    template <typename ByteOrder>
+    bool readNextPacketInstrumented(Packet& packet);
+
     int mFileDescriptor{0};
     size_t mFileSize{0};
     size_t mMappedSize{0};
     const uint8_t* mMappedMemory{nullptr};
     size_t mOffset{0};
+    bool mSwapped{false};
 };
+
+template <typename ByteOrder>
+inline bool MMModifiedPcapReader::readNextPacket(Packet& packet) {
+    if (__builtin_expect(mStatistics != nullptr, 0)) {
+        return readNextPacketInstrumented<ByteOrder>(packet);
+    }
+    return readPacket<ByteOrder>(packet);
+}
+
+template <typename ByteOrder>
+inline bool MMModifiedPcapReader::readPacket(Packet& packet) {
+    // qualified to avoid the virtual call
+    if (MMModifiedPcapReader::isExhausted()) {
+        // nothing more to read
+        return false;
+    }
+
+    // make sure there are enough bytes to read
+    if (mFileSize - mOffset < 24) {
+        throw std::runtime_error(
+            "Expected to read at least one more raw packet record (24 bytes "
+            "at least), but there are only " +
+            std::to_string(mFileSize - mOffset) + " bytes left in the file");
+    }
+
+    ModifiedPcapPacketRecord packetRecord{};
+    ModifiedPcapParser<ByteOrder>::readPacketRecord(&mMappedMemory[mOffset],
+                                                    packetRecord);
+    // ValidationLevel::CHEAP of the PcapNG readers, always on as it is one comparison,
+    // a corrupted or truncated record would make packet.data reach past the file
+    if (packetRecord.captureLength > mFileSize - mOffset - 24) {
+        throw std::runtime_error(
+            "Raw packet record at offset " + std::to_string(mOffset) + " captured " +
+            std::to_string(packetRecord.captureLength) + " bytes, but there are only " +
+            std::to_string(mFileSize - mOffset - 24) + " bytes left in the file");
+    }
+    packet.timestamp = (uint64_t)packetRecord.timestampSeconds * 1000000000 +
+                       (uint64_t)packetRecord.timestampSubSeconds * 1000;
+    packet.timestampSeconds = packetRecord.timestampSeconds;
+    packet.timestampMicroseconds = packetRecord.timestampSubSeconds;
+    packet.captureLength = packetRecord.captureLength;
+    packet.length = packetRecord.length;
+    packet.data = packetRecord.data;
+
+    mOffset += 24 + packetRecord.captureLength;
+
+    return true;
+}
+
 } // namespace mmpr
 
 #endif // MMPR_MMRAWREADER_H
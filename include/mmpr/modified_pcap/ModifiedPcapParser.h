@@ -1,12 +1,18 @@
 #ifndef MMPR_RAWPARSER_H
 #define MMPR_RAWPARSER_H
 
+#include "mmpr/ByteOrder.h"
 #include "mmpr/mmpr.h"
 #include <algorithm>
 #include <sstream>
 #include <stdexcept>
+#include <string>
 
 namespace mmpr {
+/**
+ * @tparam ByteOrder NativeByteOrder or SwappedByteOrder, depending on the magic number
+ */
+template <typename ByteOrder>
 class ModifiedPcapParser {
 public:
     /**
@@ -30,7 +36,7 @@ public:
      *
      */
     static void readFileHeader(const uint8_t* data, ModifiedPcapFileHeader& mpfh) {
-        auto magicNumber = *(uint32_t*)&data[0];
+        auto magicNumber = ByteOrder::read32(&data[0]);
         if (magicNumber != MMPR_MAGIC_NUMBER_MODIFIED_PCAP) {
             std::stringstream sstream;
             sstream << std::hex << magicNumber;
@@ -41,12 +47,12 @@ public:
                                      hex);
         }
 
-        mpfh.majorVersion = *(uint16_t*)&data[4];
-        mpfh.minorVersion = *(uint16_t*)&data[6];
-        mpfh.thiszone = *(int32_t*)&data[8];
-        mpfh.sigfigs = *(uint32_t*)&data[12];
-        mpfh.snapLength = *(uint32_t*)&data[16];
-        mpfh.linkType = *(uint32_t*)&data[20];
+        mpfh.majorVersion = ByteOrder::read16(&data[4]);
+        mpfh.minorVersion = ByteOrder::read16(&data[6]);
+        mpfh.thiszone = (int32_t)ByteOrder::read32(&data[8]);
+        mpfh.sigfigs = ByteOrder::read32(&data[12]);
+        mpfh.snapLength = ByteOrder::read32(&data[16]);
+        mpfh.linkType = ByteOrder::read32(&data[20]);
 
         MMPR_DEBUG_LOG("--- [Modified PCAP File Header %p] ---\n", (void*)data);
         MMPR_DEBUG_LOG_2("[MPFH] Version: %u.%u\n", mpfh.majorVersion, mpfh.minorVersion);
@@ -79,13 +85,13 @@ public:
      *    +---------------------------------------------------------------+
      */
     static void readPacketRecord(const uint8_t* data, ModifiedPcapPacketRecord& mppr) {
-        mppr.timestampSeconds = *(uint32_t*)&data[0];
-        mppr.timestampSubSeconds = *(uint32_t*)&data[4];
-        mppr.captureLength = *(uint32_t*)&data[8];
-        mppr.length = *(uint32_t*)&data[12];
+        mppr.timestampSeconds = ByteOrder::read32(&data[0]);
+        mppr.timestampSubSeconds = ByteOrder::read32(&data[4]);
+        mppr.captureLength = ByteOrder::read32(&data[8]);
+        mppr.length = ByteOrder::read32(&data[12]);
 
-        mppr.interfaceIndex = *(uint32_t*)&data[16];
-        mppr.protocol = *(uint16_t*)&data[20];
+        mppr.interfaceIndex = ByteOrder::read32(&data[16]);
+        mppr.protocol = ByteOrder::read16(&data[20]);
         mppr.packetType = data[22];
         mppr.padding = data[23];
 
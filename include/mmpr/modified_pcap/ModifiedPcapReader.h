@@ -18,6 +18,8 @@ public:
                                      std::filesystem::absolute(filepath).string());
         }
     };
+    ModifiedPcapReader(const std::string& filepath, int fileDescriptor)
+        : FileReader(filepath, fileDescriptor) {}
 
     virtual void open() override = 0;
     virtual bool isExhausted() const override = 0;
@@ -28,6 +30,7 @@ public:
     virtual std::string getFilepath() const override { return mFilepath; }
     virtual size_t getCurrentOffset() const override = 0;
     virtual uint16_t getDataLinkType() const override { return mDataLinkType; };
+    using FileReader::getDataLinkType;
     std::vector<TraceInterface> getTraceInterfaces() const override {
         return std::vector<TraceInterface>();
     }
@@ -2,7 +2,9 @@
 #define MMPR_MMPCAPREADER_H
 
 #include "mmpr/mmpr.h"
+#include "mmpr/pcap/PcapParser.h"
 #include "mmpr/pcap/PcapReader.h"
+#include <cstdint>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -12,23 +14,169 @@ namespace mmpr {
 class MMPcapReader : public PcapReader {
 public:
     explicit MMPcapReader(const std::string& filepath);
+    /**
+     * Reads the already opened file, takes ownership of fileDescriptor.
+     */
+    MMPcapReader(const std::string& filepath, int fileDescriptor);
 
     void open() override;
-    bool isExhausted() const override;
+    bool isExhausted() const override { return mOffset >= mEnd; }
     bool readNextPacket(Packet& packet) override;
     void close() override;
+    const uint8_t* getMappedMemory() const override { return mMappedMemory; }
+    int getMappedFileDescriptor() const override {
+        return mMappedMemory != nullptr ? mFileDescriptor : -1;
+    }
+
+    /**
+     * Variant of readNextPacket() for a fixed byte order, which has to match
+     * isSwapped(). Defined in the header so forEachPacket() can inline it.
+     */
+    template <typename ByteOrder>
+    bool readNextPacket(Packet& packet);
+    bool isSwapped() const { return mSwapped; }
+    PacketRange<MMPcapReader> packets() { return PacketRange<MMPcapReader>(*this); }
 
     size_t getFileSize() const override { return mFileSize; }
     size_t getCurrentOffset() const override { return mOffset; }
 
+    /**
+     * In recovery mode, every packet record is checked for plausibility (timestamp
+     * fraction in range, captured length <= original length, 0 < original length <=
+     * 256 KiB, record within the file) before it is read. On an implausible record,
+     * the reader scans forward for an offset where three plausible records chain up (or
+     * the file ends), records the skipped bytes and keeps reading.
+     */
+    void setRecovery(bool recovery) { mRecovery = recovery; }
+    /**
+     * Byte ranges skipped in recovery mode since open().
+     */
+    const std::vector<SkippedRange>& getSkippedRanges() const { return mSkippedRanges; }
+    /**
+     * Restricts reading to the packet records starting in [begin, end), has to be set
+     * before open().
+     *
+     * With synchronize, the reader starts at the first offset >= begin where eight
+     * plausible records (see setRecovery()) within a year of the first packet of the
+     * file chain up. This is a heuristic: a false chain in the payload of the record
+     * that straddles begin, or real records failing the checks, make consecutive ranges
+     * overlap or leave a gap, without an error. Callers have to verify that
+     * getCurrentOffset() after open() equals the offset where the previous range stopped
+     * (getCurrentOffset() once exhausted), and re-read the range from that offset
+     * without synchronize if not, as MapReduceJob::reduce() does.
+     *
+     * Without synchronize, begin has to be the offset of a packet record.
+     */
+    void setRange(size_t begin, size_t end, bool synchronize = true) {
+        mRangeBegin = begin;
+        mRangeEnd = end;
+        mRangeSynchronize = synchronize;
+    }
+
 private:
+    template <typename ByteOrder>
+    bool readPacket(Packet& packet);
+    template <typename ByteOrder>
+    void readPacketRecord(Packet& packet);
+    /**
+     * readNextPacket() in recovery mode or with statistics enabled.
+     */
+    template <typename ByteOrder>
+    bool readNextPacketInstrumented(Packet& packet);
+    template <typename ByteOrder>
+    bool readNextPacketRecovering(Packet& packet);
+    /**
+     * @return length of the plausible packet record at offset including its header, 0
+     * if the record is implausible
+     */
+    template <typename ByteOrder>
+    size_t plausibleRecordLength(size_t offset) const;
+    /**
+     * @param range stricter check for the start of a range, longer chains of records
+     * close to the first packet of the file
+     * @return first offset >= from where a chain of plausible records starts, the file
+     * size if there is none
+     */
+    template <typename ByteOrder>
+    size_t findRecordChain(size_t from, bool range) const;
+    template <typename ByteOrder>
+    void resynchronize(const std::string& reason);
+
     int mFileDescriptor{0};
     size_t mFileSize{0};
     size_t mMappedSize{0};
     const uint8_t* mMappedMemory{nullptr};
     size_t mOffset{0};
+    // end of the range to read, the file size without a range
+    size_t mEnd{0};
+    size_t mRangeBegin{0};
+    size_t mRangeEnd{SIZE_MAX};
+    bool mRangeSynchronize{true};
+    // seconds of the first packet record
+    uint32_t mFirstSeconds{0};
     FileHeader::TimestampFormat mTimestampFormat{FileHeader::MICROSECONDS};
+    bool mSwapped{false};
+    bool mRecovery{false};
+    std::vector<SkippedRange> mSkippedRanges;
 };
+
+template <typename ByteOrder>
+inline bool MMPcapReader::readNextPacket(Packet& packet) {
+    if (__builtin_expect(mRecovery || mStatistics != nullptr, 0)) {
+        return readNextPacketInstrumented<ByteOrder>(packet);
+    }
+    return readPacket<ByteOrder>(packet);
+}
+
+template <typename ByteOrder>
+inline bool MMPcapReader::readPacket(Packet& packet) {
+    // qualified to avoid the virtual call
+    if (MMPcapReader::isExhausted()) {
+        // nothing more to read
+        return false;
+    }
+
+    // make sure there are enough bytes to read
+    if (mFileSize - mOffset < 16) {
+        throw std::runtime_error("Expected to read at least one more packet record (16 "
+                                 "bytes at least), but there are only " +
+                                 std::to_string(mFileSize - mOffset) +
+                                 " bytes left in the file");
+    }
+    // ValidationLevel::CHEAP of the PcapNG readers, always on as it is one comparison,
+    // a corrupted or truncated record would make packet.data reach past the file
+    const uint32_t captureLength = ByteOrder::read32(&mMappedMemory[mOffset + 8]);
+    if (captureLength > mFileSize - mOffset - 16) {
+        throw std::runtime_error("Packet record at offset " + std::to_string(mOffset) +
+                                 " captured " + std::to_string(captureLength) +
+                                 " bytes, but there are only " +
+                                 std::to_string(mFileSize - mOffset - 16) +
+                                 " bytes left in the file");
+    }
+
+    readPacketRecord<ByteOrder>(packet);
+    return true;
+}
+
+template <typename ByteOrder>
+inline void MMPcapReader::readPacketRecord(Packet& packet) {
+    PacketRecord packetRecord{};
+    PcapParser<ByteOrder>::readPacketRecord(&mMappedMemory[mOffset], packetRecord);
+    packet.timestamp = (uint64_t)packetRecord.timestampSeconds * 1000000000 +
+                       (mTimestampFormat == FileHeader::MICROSECONDS
+                            ? (uint64_t)packetRecord.timestampSubSeconds * 1000
+                            : packetRecord.timestampSubSeconds);
+    packet.timestampSeconds = packetRecord.timestampSeconds;
+    packet.timestampMicroseconds = mTimestampFormat == FileHeader::MICROSECONDS
+                                       ? packetRecord.timestampSubSeconds
+                                       : packetRecord.timestampSubSeconds / 1000;
+    packet.captureLength = packetRecord.captureLength;
+    packet.length = packetRecord.length;
+    packet.data = packetRecord.data;
+
+    mOffset += 16 + packetRecord.captureLength;
+}
+
 } // namespace mmpr
 
 #endif // MMPR_MMPCAPREADER_H
@@ -1,10 +1,18 @@
 #ifndef MMPR_PCAPPARSER_H
 #define MMPR_PCAPPARSER_H
 
+#include "mmpr/ByteOrder.h"
 #include "mmpr/mmpr.h"
 #include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
 
 namespace mmpr {
+/**
+ * @tparam ByteOrder NativeByteOrder or SwappedByteOrder, depending on the magic number
+ */
+template <typename ByteOrder>
 class PcapParser {
 public:
     /**
@@ -27,7 +35,7 @@ public:
      *
      */
     static void readFileHeader(const uint8_t* data, FileHeader& fh) {
-        auto magicNumber = *(const uint32_t*)&data[0];
+        auto magicNumber = ByteOrder::read32(&data[0]);
         if (magicNumber != 0xA1B2C3D4 && magicNumber != 0xA1B23C4D) {
             std::stringstream sstream;
             sstream << std::hex << magicNumber;
@@ -45,12 +53,14 @@ public:
             fh.timestampFormat = FileHeader::NANOSECONDS;
         }
 
-        fh.majorVersion = *(const uint16_t*)&data[4];
-        fh.minorVersion = *(const uint16_t*)&data[6];
+        fh.majorVersion = ByteOrder::read16(&data[4]);
+        fh.minorVersion = ByteOrder::read16(&data[6]);
 
-        fh.snapLength = *(const uint32_t*)&data[16];
-        fh.linkType = *(const uint16_t*)&data[20];
-        fh.fcsSequence = *(const uint16_t*)&data[22];
+        fh.snapLength = ByteOrder::read32(&data[16]);
+        // link type and FCS share one 32 bit field, split it after adjusting byte order
+        const uint32_t linkTypeAndFcs = ByteOrder::read32(&data[20]);
+        fh.linkType = (uint16_t)linkTypeAndFcs;
+        fh.fcsSequence = (uint16_t)(linkTypeAndFcs >> 16);
 
         MMPR_DEBUG_LOG("--- [File Header %p] ---\n", (void*)data);
         MMPR_DEBUG_LOG("[FH] Timestamp Format: %s\n",
@@ -81,10 +91,10 @@ public:
      *    +---------------------------------------------------------------+
      */
     static void readPacketRecord(const uint8_t* data, PacketRecord& pr) {
-        pr.timestampSeconds = *(const uint32_t*)&data[0];
-        pr.timestampSubSeconds = *(const uint32_t*)&data[4];
-        pr.captureLength = *(const uint32_t*)&data[8];
-        pr.length = *(const uint32_t*)&data[12];
+        pr.timestampSeconds = ByteOrder::read32(&data[0]);
+        pr.timestampSubSeconds = ByteOrder::read32(&data[4]);
+        pr.captureLength = ByteOrder::read32(&data[8]);
+        pr.length = ByteOrder::read32(&data[12]);
         if (pr.captureLength > 0) {
             pr.data = &data[16];
         }
@@ -19,6 +19,8 @@ public:
                                      std::filesystem::absolute(filepath).string());
         }
     };
+    PcapReader(const std::string& filepath, int fileDescriptor)
+        : FileReader(filepath, fileDescriptor) {}
 
     virtual void open() = 0;
     virtual bool isExhausted() const = 0;
@@ -29,6 +31,7 @@ public:
     virtual std::string getFilepath() const override { return mFilepath; }
     virtual size_t getCurrentOffset() const = 0;
     virtual uint16_t getDataLinkType() const override { return mDataLinkType; };
+    using FileReader::getDataLinkType;
     std::vector<TraceInterface> getTraceInterfaces() const override {
         return std::vector<TraceInterface>();
     }
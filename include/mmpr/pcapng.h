@@ -1,8 +1,11 @@
 #ifndef MMPR_PCAPNG_H
 #define MMPR_PCAPNG_H
 
+#include "mmpr/Profiler.h"
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <string_view>
 
 /**
  * Header Block Types, cf. https://pcapng.github.io/pcapng/draft-ietf-opsawg-pcapng.txt
@@ -18,6 +21,13 @@
 #define MMPR_CUSTOM_CAN_COPY_BLOCK 0x00000BAD
 #define MMPR_CUSTOM_DO_NOT_COPY_BLOCK 0x40000BAD
 
+/**
+ * Byte-Order Magic of the Section Header Block, as read by a host with the same and the
+ * opposite endianness of the writer
+ */
+#define MMPR_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define MMPR_BYTE_ORDER_MAGIC_SWAPPED 0x4D3C2B1A
+
 /**
  * Block Options
  */
@@ -32,9 +42,50 @@
 #define MMPR_BLOCK_OPTION_IDB_TSRESOL 9
 #define MMPR_BLOCK_OPTION_IDB_FILTER 11
 #define MMPR_BLOCK_OPTION_IDB_OS 12
+#define MMPR_BLOCK_OPTION_IDB_TSOFFSET 14
+
+#define MMPR_BLOCK_OPTION_EPB_FLAGS 2
+#define MMPR_BLOCK_OPTION_EPB_HASH 3
+#define MMPR_BLOCK_OPTION_EPB_DROPCOUNT 4
+#define MMPR_BLOCK_OPTION_EPB_PACKETID 5
+#define MMPR_BLOCK_OPTION_EPB_QUEUE 6
+
+#define MMPR_BLOCK_OPTION_ISB_STARTTIME 2
+#define MMPR_BLOCK_OPTION_ISB_ENDTIME 3
+#define MMPR_BLOCK_OPTION_ISB_IFRECV 4
+#define MMPR_BLOCK_OPTION_ISB_IFDROP 5
+#define MMPR_BLOCK_OPTION_ISB_FILTERACCEPT 6
+#define MMPR_BLOCK_OPTION_ISB_OSDROP 7
+#define MMPR_BLOCK_OPTION_ISB_USRDELIV 8
+
+/**
+ * Name Resolution Block record types
+ */
+#define MMPR_NRB_RECORD_END 0
+#define MMPR_NRB_RECORD_IPV4 1
+#define MMPR_NRB_RECORD_IPV6 2
+#define MMPR_NRB_RECORD_EUI48 3
+#define MMPR_NRB_RECORD_EUI64 4
 
 namespace mmpr {
 
+/**
+ * How much of the structure of a pcapng trace a reader checks before parsing a block.
+ * Every level rejects blocks shorter than the minimum size of their type, so a zero
+ * block total length cannot stall the reader.
+ */
+enum class ValidationLevel : uint8_t {
+    // trust the trace, corrupted lengths make the reader read past the end of a block
+    // or the file
+    NONE,
+    // block total lengths against the remaining bytes and the trailing block total
+    // length, captured packet lengths against the block and the interface's snapshot
+    // length
+    CHEAP,
+    // additionally every option has to lie within its block
+    FULL
+};
+
 struct Option {
     uint16_t type{0};
     uint16_t length{0};
@@ -54,11 +105,12 @@ struct SectionHeaderBlock {
     uint16_t majorVersion{0};
     uint16_t minorVersion{0};
     int64_t sectionLength{0};
+    // options point into the block, they stay valid as long as the trace is mapped
     struct Options {
-        std::string comment;
-        std::string os;
-        std::string hardware;
-        std::string userApplication;
+        std::string_view comment;
+        std::string_view os;
+        std::string_view hardware;
+        std::string_view userApplication;
     } options{};
 };
 
@@ -67,14 +119,108 @@ struct InterfaceDescriptionBlock {
     uint16_t linkType{0};
     uint32_t snapLen{0};
     struct Options {
+        // ticks per second, only exact for resolutions up to 10^-9
         uint32_t timestampResolution{1000000 /* 10^6 */};
-        std::optional<std::string> name;
-        std::optional<std::string> description;
-        std::optional<std::string> filter;
-        std::optional<std::string> os;
+        // raw if_tsresol value
+        uint8_t tsresol{6};
+        // if_tsoffset in seconds
+        int64_t tsoffset{0};
+        // point into the block, they stay valid as long as the trace is mapped
+        std::optional<std::string_view> name;
+        std::optional<std::string_view> description;
+        std::optional<std::string_view> filter;
+        std::optional<std::string_view> os;
     } options{};
 };
 
+/**
+ * Converts raw interface timestamps into nanoseconds since 1970-01-01 00:00:00 UTC
+ * without a division per packet. All constants are derived once from if_tsresol and
+ * if_tsoffset, the conversion is exact (rounding down) for every power-of-10 and
+ * power-of-2 resolution:
+ *
+ * - 10^-k with k <= 9: multiplication by 10^(9-k)
+ * - 2^-k: 128 bit multiplication by 10^9 followed by a right shift of k
+ * - 10^-k with k > 9: multiplication by the 128 bit reciprocal of 10^(k-9), cf. Lemire et
+ *   al., "Faster Remainder by Direct Computation", 2019
+ */
+class TimestampConverter {
+public:
+    TimestampConverter() : TimestampConverter(6, 0) {}
+
+    /**
+     * @param tsresol raw if_tsresol value
+     * @param tsoffset if_tsoffset in seconds
+     */
+    TimestampConverter(uint8_t tsresol, int64_t tsoffset)
+        : mOffset((uint64_t)tsoffset * 1000000000ULL) {
+        const uint8_t exponent = tsresol & 0x7F;
+        if (tsresol & 0x80) {
+            // negative power of 2
+            mMultiplier = 1000000000ULL;
+            mShift = exponent;
+        } else if (exponent <= 9) {
+            // negative power of 10, at most nanoseconds
+            mMultiplier = 1;
+            for (uint8_t i = exponent; i < 9; ++i) {
+                mMultiplier *= 10;
+            }
+        } else if (exponent - 9 <= 19) {
+            // negative power of 10, finer than nanoseconds
+            uint64_t divisor = 1;
+            for (uint8_t i = 9; i < exponent; ++i) {
+                divisor *= 10;
+            }
+            const __uint128_t reciprocal = ~(__uint128_t)0 / divisor + 1;
+            mReciprocalHigh = (uint64_t)(reciprocal >> 64);
+            mReciprocalLow = (uint64_t)reciprocal;
+            mUseReciprocal = true;
+        } else {
+            // divisor exceeds 64 bits, every 64 bit timestamp is below one nanosecond
+            mMultiplier = 0;
+        }
+    }
+
+    uint64_t toNanoseconds(uint64_t timestamp) const {
+        MMPR_PROFILE_SCOPE(TIMESTAMP);
+        if (mUseReciprocal) {
+            const uint64_t low =
+                (uint64_t)(((__uint128_t)mReciprocalLow * timestamp) >> 64);
+            return (uint64_t)(((__uint128_t)mReciprocalHigh * timestamp + low) >> 64) +
+                   mOffset;
+        }
+        return (uint64_t)(((__uint128_t)timestamp * mMultiplier) >> mShift) + mOffset;
+    }
+
+private:
+    uint64_t mMultiplier{1};
+    uint32_t mShift{0};
+    bool mUseReciprocal{false};
+    uint64_t mReciprocalHigh{0};
+    uint64_t mReciprocalLow{0};
+    uint64_t mOffset{0};
+};
+
+/**
+ * Per-interface state needed to interpret packets of an interface, built from its
+ * Interface Description Block.
+ */
+struct InterfaceDescriptor {
+    InterfaceDescriptor() = default;
+    explicit InterfaceDescriptor(const InterfaceDescriptionBlock& idb)
+        : linkType(idb.linkType),
+          snapLength(idb.snapLen),
+          tsresol(idb.options.tsresol),
+          tsoffset(idb.options.tsoffset),
+          timestampConverter(idb.options.tsresol, idb.options.tsoffset) {}
+
+    uint16_t linkType{0};
+    uint32_t snapLength{0};
+    uint8_t tsresol{6};
+    int64_t tsoffset{0};
+    TimestampConverter timestampConverter;
+};
+
 struct EnhancedPacketBlock {
     uint32_t blockTotalLength{0};
     uint32_t interfaceId{0};
@@ -83,6 +229,53 @@ struct EnhancedPacketBlock {
     uint32_t capturePacketLength{0};
     uint32_t originalPacketLength{0};
     const uint8_t* packetData{nullptr};
+    // options are only located, PcapNgBlockParser::readEPBOptions() decodes them
+    bool hasOptions{false};
+};
+
+/**
+ * Options of the Enhanced Packet Block of a packet, decoded on demand by
+ * PcapNgReader::readPacketOptions(). Options the writer did not provide are empty.
+ */
+struct PacketOptions {
+    enum Direction : uint8_t { DIRECTION_UNKNOWN = 0, INBOUND = 1, OUTBOUND = 2 };
+
+    // epb_flags: direction (bits 0-1), reception type (bits 2-4), FCS length (bits 5-8)
+    // and link-layer errors (bits 16-31)
+    std::optional<uint32_t> flags;
+    // epb_hash: algorithm (0 = 2s complement, 1 = XOR, 2 = CRC32, 3 = MD5, 4 = SHA-1,
+    // 5 = Toeplitz) and digest, the digest points into the trace
+    uint8_t hashAlgorithm{0};
+    const uint8_t* hash{nullptr};
+    uint16_t hashLength{0};
+    // epb_dropcount: packets lost since the previous packet of the interface
+    std::optional<uint64_t> dropCount;
+    std::optional<uint64_t> packetId;
+    // epb_queue: receive queue of the interface
+    std::optional<uint32_t> queue;
+
+    Direction direction() const {
+        const uint32_t direction = flags ? *flags & 0x3 : 0;
+        return direction == 3 ? DIRECTION_UNKNOWN : static_cast<Direction>(direction);
+    }
+    /**
+     * First (up to) 4 bytes of the digest as a big-endian number, 0 without a hash.
+     */
+    uint32_t hash32() const {
+        uint32_t value = 0;
+        for (uint16_t i = 0; i < hashLength && i < 4; ++i) {
+            value = value << 8 | hash[i];
+        }
+        return value;
+    }
+};
+
+struct SimplePacketBlock {
+    uint32_t blockTotalLength{0};
+    uint32_t originalPacketLength{0};
+    // not stored in the block, derived from its length and the snapshot length
+    uint32_t capturePacketLength{0};
+    const uint8_t* packetData{nullptr};
 };
 
 struct PacketBlock {
@@ -101,6 +294,41 @@ struct InterfaceStatisticsBlock {
     uint32_t interfaceId{0};
     uint32_t timestampHigh{0};
     uint32_t timestampLow{0};
+    struct Options {
+        // raw timestamps in the resolution of the interface
+        std::optional<uint64_t> startTime;
+        std::optional<uint64_t> endTime;
+        std::optional<uint64_t> ifRecv;
+        std::optional<uint64_t> ifDrop;
+        std::optional<uint64_t> filterAccept;
+        std::optional<uint64_t> osDrop;
+        std::optional<uint64_t> usrDeliv;
+    } options{};
+};
+
+/**
+ * Counters of an Interface Statistics Block with timestamps converted to nanoseconds
+ * since 1970-01-01 00:00:00 UTC. The counters are cumulative since the start of the
+ * capture, counters the writer did not provide are empty.
+ */
+struct InterfaceStatistics {
+    // number of the section, counted from 0, the interface ids start over in every
+    // section
+    uint32_t section{0};
+    uint32_t interfaceId{0};
+    uint64_t timestamp{0};
+    std::optional<uint64_t> startTime;
+    std::optional<uint64_t> endTime;
+    // packets received from the physical interface
+    std::optional<uint64_t> received;
+    // packets dropped by the interface due to lack of resources
+    std::optional<uint64_t> interfaceDropped;
+    // packets accepted by the filter
+    std::optional<uint64_t> filterAccepted;
+    // packets dropped by the operating system
+    std::optional<uint64_t> osDropped;
+    // packets delivered to the user
+    std::optional<uint64_t> userDelivered;
 };
 
 } // namespace mmpr
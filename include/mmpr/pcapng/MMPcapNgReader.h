@@ -7,9 +7,19 @@ namespace mmpr {
 class MMPcapNgReader : public PcapNgReader {
 public:
     explicit MMPcapNgReader(const std::string& filepath);
+    /**
+     * Maps the pcapng data behind an already opened file descriptor instead of the file
+     * at filepath, e.g. a cached decompressed copy of it. Takes ownership of
+     * fileDescriptor.
+     */
+    MMPcapNgReader(const std::string& filepath, int fileDescriptor);
 
     void open() override;
     void close() override;
+    const uint8_t* getMappedMemory() const override { return mData; }
+    int getMappedFileDescriptor() const override {
+        return mData != nullptr ? mFileDescriptor : -1;
+    }
 
 private:
     int mFileDescriptor{0};
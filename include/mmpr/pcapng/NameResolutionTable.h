@@ -0,0 +1,64 @@
+#ifndef MMPR_NAMERESOLUTIONTABLE_H
+#define MMPR_NAMERESOLUTIONTABLE_H
+
+#include "mmpr/pcapng.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Addresses and names of the records of Name Resolution Blocks. The names are not copied,
+ * they point into the trace and stay valid as long as the reader is open. The table is
+ * open addressing with linear probing in a single array, inserting only allocates when
+ * the table grows.
+ */
+class NameResolutionTable {
+public:
+    /**
+     * Record types of the Name Resolution Block, the address length follows from the
+     * type (4, 16, 6 and 8 bytes).
+     */
+    enum AddressType : uint8_t {
+        IPV4 = MMPR_NRB_RECORD_IPV4,
+        IPV6 = MMPR_NRB_RECORD_IPV6,
+        EUI48 = MMPR_NRB_RECORD_EUI48,
+        EUI64 = MMPR_NRB_RECORD_EUI64
+    };
+
+    static size_t addressLength(AddressType type);
+
+    /**
+     * Adds or replaces the name of an address (in network byte order, as in packets).
+     */
+    void insert(AddressType type, const uint8_t* address, std::string_view name);
+
+    /**
+     * @return the name of the address, empty if it is not in the table
+     */
+    std::string_view lookup(AddressType type, const uint8_t* address) const;
+
+    size_t size() const { return mSize; }
+    void clear();
+
+private:
+    struct Slot {
+        uint8_t type{0};
+        uint8_t address[16]{};
+        uint32_t nameLength{0};
+        const char* name{nullptr};
+    };
+
+    size_t findSlot(AddressType type, const uint8_t* address) const;
+    void grow();
+
+    // power of two capacity, empty slots have type 0
+    std::vector<Slot> mSlots;
+    size_t mSize{0};
+};
+
+} // namespace mmpr
+
+#endif // MMPR_NAMERESOLUTIONTABLE_H
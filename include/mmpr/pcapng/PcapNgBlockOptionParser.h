@@ -1,10 +1,12 @@
 #ifndef MMPR_PCAPNGBLOCKOPTIONPARSER_H
 #define MMPR_PCAPNGBLOCKOPTIONPARSER_H
 
+#include "mmpr/ByteOrder.h"
 #include "mmpr/mmpr.h"
 #include <cstddef>
 
 namespace mmpr {
+template <typename ByteOrder>
 class PcapNgBlockOptionParser {
 public:
     static void readOption(const uint8_t* data, Option& option, size_t offset);
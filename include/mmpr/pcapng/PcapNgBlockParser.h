@@ -1,17 +1,179 @@
 #ifndef MMPR_PCAPNGBLOCKPARSER_H
 #define MMPR_PCAPNGBLOCKPARSER_H
 
+#include "mmpr/ByteOrder.h"
 #include "mmpr/mmpr.h"
+#include "mmpr/pcapng/NameResolutionTable.h"
+#include "mmpr/pcapng/PcapNgBlockOptionParser.h"
+#include <stdexcept>
+#include <string>
 
 namespace mmpr {
+/**
+ * Parses the blocks of a pcapng section, all fields are read in the byte order of the
+ * section. Instantiated for NativeByteOrder and SwappedByteOrder.
+ */
+template <typename ByteOrder>
 class PcapNgBlockParser {
 public:
     static void readSHB(const uint8_t* data, SectionHeaderBlock& shb);
     static void readIDB(const uint8_t* data, InterfaceDescriptionBlock& idb);
     static void readEPB(const uint8_t* data, EnhancedPacketBlock& epb);
+    /**
+     * Decodes the options of an Enhanced Packet Block, called on demand so that the
+     * packet loop only has to check whether a block has options.
+     */
+    static void readEPBOptions(const uint8_t* data, PacketOptions& options);
+    static void readSPB(const uint8_t* data, uint32_t snapLength, SimplePacketBlock& spb);
     static void readPB(const uint8_t* data, PacketBlock& pb);
     static void readISB(const uint8_t* data, InterfaceStatisticsBlock& isb);
+    /**
+     * Adds the first name of every record to the table, further names of a record and
+     * the options of the block are skipped.
+     */
+    static void readNRB(const uint8_t* data, NameResolutionTable& table);
+    /**
+     * Checks that the options starting at offset lie within the block, the block total
+     * length has to be validated already.
+     *
+     * @return false if an option exceeds the block
+     */
+    static bool checkOptions(const uint8_t* data, size_t offset);
+
+private:
+    using OptionParser = PcapNgBlockOptionParser<ByteOrder>;
 };
+
+/**
+ * 4.3.  Enhanced Packet Block
+ *
+ *                         1                   2                   3
+ *     0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  0 |                    Block Type = 0x00000006                    |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  4 |                      Block Total Length                       |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  8 |                         Interface ID                          |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * 12 |                        Timestamp (High)                       |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * 16 |                        Timestamp (Low)                        |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * 20 |                    Captured Packet Length                     |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * 24 |                    Original Packet Length                     |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * 28 /                                                               /
+ *    /                          Packet Data                          /
+ *    /              variable length, padded to 32 bits               /
+ *    /                                                               /
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *    /                                                               /
+ *    /                      Options (variable)                       /
+ *    /                                                               /
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *    |                      Block Total Length                       |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * Unlike the other blocks, parsed in the header so the packet loop can inline it.
+ */
+template <typename ByteOrder>
+inline void PcapNgBlockParser<ByteOrder>::readEPB(const uint8_t* data,
+                                                  EnhancedPacketBlock& epb) {
+    MMPR_PROFILE_SCOPE(EPB_HEADER);
+    auto blockType = ByteOrder::read32(&data[0]);
+    MMPR_ASSERT(blockType == MMPR_ENHANCED_PACKET_BLOCK);
+
+    epb.blockTotalLength = ByteOrder::read32(&data[4]);
+    epb.interfaceId = ByteOrder::read32(&data[8]);
+    epb.timestampHigh = ByteOrder::read32(&data[12]);
+    epb.timestampLow = ByteOrder::read32(&data[16]);
+    epb.capturePacketLength = ByteOrder::read32(&data[20]);
+    epb.originalPacketLength = ByteOrder::read32(&data[24]);
+    epb.packetData = &data[28];
+
+    MMPR_DEBUG_LOG("--- [Enhanced Packet Block @%p] ---\n", (void*)data);
+    MMPR_DEBUG_LOG("[EPB] Block Total Length: %u\n", epb.blockTotalLength);
+    MMPR_DEBUG_LOG("[EPB] Interface ID: 0x%08X\n", epb.interfaceId);
+    MMPR_DEBUG_LOG("[EPB] Timestamp (High): %u\n", epb.timestampHigh);
+    MMPR_DEBUG_LOG("[EPB] Timestamp (Low): %u\n", epb.timestampLow);
+    MMPR_DEBUG_LOG("[EPB] Captured Packet Length: %u\n", epb.capturePacketLength);
+    MMPR_DEBUG_LOG("[EPB] Original Packet Length: %u\n", epb.originalPacketLength);
+    MMPR_DEBUG_LOG("[EPB] Packet Data: %p\n", (void*)epb.packetData);
+
+    // packet data is padded to 32 bits, calculate the total size in memory (including
+    // padding)
+    auto packetDataTotalLength =
+        epb.capturePacketLength + (4 - epb.capturePacketLength % 4) % 4;
+    // standard Enhanced Packet Block has size 32 (without packet data or options)
+    epb.hasOptions = epb.blockTotalLength - 32 > packetDataTotalLength;
+
+    // make sure that the block actually ends with block total length
+    auto blockTotalLength = ByteOrder::read32(&data[epb.blockTotalLength - 4]);
+    MMPR_ASSERT(epb.blockTotalLength == blockTotalLength);
+}
+
+/**
+ * 4.4.  Simple Packet Block
+ *
+ *                         1                   2                   3
+ *     0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  0 |                    Block Type = 0x00000003                    |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  4 |                      Block Total Length                       |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  8 |                    Original Packet Length                     |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * 12 /                                                               /
+ *    /                          Packet Data                          /
+ *    /              variable length, padded to 32 bits               /
+ *    /                                                               /
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *    |                      Block Total Length                       |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * The block has no captured length, it is the minimum of the original packet length,
+ * the snapshot length of interface 0 (if not 0 = unlimited) and the space for packet
+ * data in the block. Parsed in the header so the packet loop can inline it.
+ */
+template <typename ByteOrder>
+inline void PcapNgBlockParser<ByteOrder>::readSPB(const uint8_t* data,
+                                                  uint32_t snapLength,
+                                                  SimplePacketBlock& spb) {
+    auto blockType = ByteOrder::read32(&data[0]);
+    MMPR_ASSERT(blockType == MMPR_SIMPLE_PACKET_BLOCK);
+
+    spb.blockTotalLength = ByteOrder::read32(&data[4]);
+    spb.originalPacketLength = ByteOrder::read32(&data[8]);
+    spb.packetData = &data[12];
+
+    // a standard Simple Packet Block has size 16 (without packet data)
+    if (spb.blockTotalLength < 16) {
+        throw std::runtime_error("Simple Packet Block has invalid block total length " +
+                                 std::to_string(spb.blockTotalLength));
+    }
+    uint32_t capturePacketLength = spb.blockTotalLength - 16;
+    if (snapLength != 0 && snapLength < capturePacketLength) {
+        capturePacketLength = snapLength;
+    }
+    if (spb.originalPacketLength < capturePacketLength) {
+        capturePacketLength = spb.originalPacketLength;
+    }
+    spb.capturePacketLength = capturePacketLength;
+
+    MMPR_DEBUG_LOG("--- [Simple Packet Block @%p] ---\n", (void*)data);
+    MMPR_DEBUG_LOG("[SPB] Block Total Length: %u\n", spb.blockTotalLength);
+    MMPR_DEBUG_LOG("[SPB] Original Packet Length: %u\n", spb.originalPacketLength);
+    MMPR_DEBUG_LOG("[SPB] Captured Packet Length: %u\n", spb.capturePacketLength);
+    MMPR_DEBUG_LOG("[SPB] Packet Data: %p\n", (void*)spb.packetData);
+
+    // make sure that the block actually ends with block total length
+    auto blockTotalLength = ByteOrder::read32(&data[spb.blockTotalLength - 4]);
+    MMPR_ASSERT(spb.blockTotalLength == blockTotalLength);
+}
+
 } // namespace mmpr
 
 #endif // MMPR_PCAPNGBLOCKPARSER_H
@@ -1,9 +1,14 @@
 #ifndef MMPR_PCAPNGREADER_H
 #define MMPR_PCAPNGREADER_H
 
+#include "mmpr/ByteOrder.h"
 #include "mmpr/mmpr.h"
+#include "mmpr/pcapng/NameResolutionTable.h"
+#include "mmpr/pcapng/PcapNgBlockParser.h"
 #include <filesystem>
+#include <functional>
 #include <stdexcept>
+#include <string_view>
 
 namespace mmpr {
 
@@ -19,6 +24,8 @@ public:
                                      std::filesystem::absolute(filepath).string());
         }
     };
+    PcapNgReader(const std::string& filepath, int fileDescriptor)
+        : FileReader(filepath, fileDescriptor) {}
 
     virtual void open() = 0;
     virtual void close() = 0;
@@ -27,42 +34,392 @@ public:
     virtual bool readNextPacket(Packet& packet);
     virtual uint32_t readBlock();
 
+    /**
+     * Variant of readNextPacket() for a fixed byte order, which has to match
+     * isSwapped(). Enhanced and Simple Packet Blocks are parsed inline, so
+     * forEachPacket() can inline the whole loop, all other blocks are handled out of
+     * line. Packets of Simple Packet Blocks have no timestamp (0).
+     */
+    template <typename ByteOrder>
+    bool readNextPacket(Packet& packet);
+    bool isSwapped() const { return mSwapped; }
+    /**
+     * Decodes the options of the Enhanced Packet Block a packet was read from. Only
+     * valid while the reader of the packet is open.
+     *
+     * @return false if the block has no options, options is left unchanged then
+     */
+    static bool readPacketOptions(const Packet& packet, PacketOptions& options);
+    PacketRange<PcapNgReader> packets() { return PacketRange<PcapNgReader>(*this); }
+
     virtual size_t getFileSize() const { return mFileSize; };
     virtual std::string getFilepath() const { return mFilepath; }
     virtual size_t getCurrentOffset() const { return mOffset; };
     virtual uint16_t getDataLinkType() const { return mDataLinkType; };
-    virtual std::string getComment() const { return mMetadata.comment; };
-    virtual std::string getOS() const { return mMetadata.os; };
-    virtual std::string getHardware() const { return mMetadata.hardware; };
-    virtual std::string getUserApplication() const { return mMetadata.userApplication; };
-    std::vector<TraceInterface> getTraceInterfaces() const override {
-        return mTraceInterfaces;
-    }
-    TraceInterface getTraceInterface(size_t id) const override {
-        if (id >= mTraceInterfaces.size()) {
-            throw std::out_of_range("Trace interface index " + std::to_string(id) +
+    uint16_t getDataLinkType(const Packet& packet) const override {
+        if (packet.interfaceIndex >= 0 &&
+            (size_t)packet.interfaceIndex < mInterfaceDescriptors.size()) {
+            return mInterfaceDescriptors[packet.interfaceIndex].linkType;
+        }
+        return mDataLinkType;
+    }
+    /**
+     * Metadata of the current section, the strings are copied out of the trace on
+     * request. Empty after close().
+     */
+    virtual std::string getComment() const { return std::string(mMetadata.comment); };
+    virtual std::string getOS() const { return std::string(mMetadata.os); };
+    virtual std::string getHardware() const { return std::string(mMetadata.hardware); };
+    virtual std::string getUserApplication() const {
+        return std::string(mMetadata.userApplication);
+    };
+    /**
+     * Views of the metadata of the current section into the trace, valid while the
+     * reader is open and empty after close().
+     */
+    const SectionHeaderBlock::Options& getMetadata() const { return mMetadata; }
+    std::vector<TraceInterface> getTraceInterfaces() const override;
+    TraceInterface getTraceInterface(size_t id) const override;
+
+    /**
+     * Interfaces of the current section, indexed by Packet::interfaceIndex.
+     */
+    const std::vector<InterfaceDescriptor>& getInterfaceDescriptors() const {
+        return mInterfaceDescriptors;
+    }
+    const InterfaceDescriptor& getInterfaceDescriptor(size_t id) const {
+        if (id >= mInterfaceDescriptors.size()) {
+            throw std::out_of_range("Interface descriptor index " + std::to_string(id) +
                                     " is out of range");
         }
-        return mTraceInterfaces[id];
+        return mInterfaceDescriptors[id];
+    }
+
+    /**
+     * Name of an address (in network byte order) from the Name Resolution Blocks the
+     * reader has passed so far, empty if unknown. The blocks are only recorded while
+     * reading and parsed on the first query after them, readers that never query
+     * names do not parse them. The name stays valid while the reader is open.
+     */
+    std::string_view resolveName(NameResolutionTable::AddressType type,
+                                 const uint8_t* address) {
+        return getNameResolutionTable().lookup(type, address);
+    }
+    /**
+     * Names of all Name Resolution Blocks passed so far.
+     */
+    const NameResolutionTable& getNameResolutionTable();
+    /**
+     * Records the Name Resolution Blocks up to the end of the file without moving the
+     * reader, so names can be resolved before the packets referring to them are read.
+     * Only block headers are read, but that touches most pages of the file.
+     */
+    void scanNameResolutionBlocks();
+
+    /**
+     * Sets how much of the trace structure is checked before parsing, defaults to
+     * ValidationLevel::CHEAP. Invalid blocks throw a std::runtime_error.
+     */
+    void setValidationLevel(ValidationLevel level) {
+        mRequestedValidationLevel = level;
+        updateValidationLevel();
+    }
+    ValidationLevel getValidationLevel() const { return mRequestedValidationLevel; }
+
+    /**
+     * In recovery mode, a block failing validation does not throw while reading
+     * packets. The reader scans forward for the next block whose type is known and
+     * whose leading and trailing block total lengths match (followed by another such
+     * block or the end of the file), records the skipped bytes and keeps reading.
+     *
+     * Invalid blocks are only found by validating them, so recovery mode reads with
+     * ValidationLevel::CHEAP if ValidationLevel::NONE is set.
+     */
+    void setRecovery(bool recovery) {
+        mRecovery = recovery;
+        updateValidationLevel();
     }
+    /**
+     * Byte ranges skipped in recovery mode since open().
+     */
+    const std::vector<SkippedRange>& getSkippedRanges() const { return mSkippedRanges; }
+
+    using InterfaceStatisticsCallback = std::function<void(const InterfaceStatistics&)>;
+    /**
+     * Called for every Interface Statistics Block the reader passes while reading
+     * packets or blocks. Without a callback the statistics blocks are skipped
+     * unparsed.
+     */
+    void setInterfaceStatisticsCallback(InterfaceStatisticsCallback callback) {
+        mInterfaceStatisticsCallback = std::move(callback);
+    }
+    /**
+     * All Interface Statistics Blocks of the file in file order, without moving the
+     * reader. Only block headers, Interface Description Blocks (for the timestamp
+     * resolution) and the statistics blocks are read, packet data is never touched.
+     */
+    std::vector<InterfaceStatistics> readInterfaceStatistics() const;
 
 protected:
+    /**
+     * Forgets the names and sections of a previous open(), called by open() of the
+     * subclasses.
+     */
+    void resetBlockState();
+    /**
+     * Forgets everything that points into the trace: section metadata, interface
+     * options and names. Called by close() of the subclasses, since the memory is
+     * unmapped or handed back to the decompression pool afterwards.
+     */
+    void releaseTraceViews();
+
     size_t mFileSize{0};
     size_t mOffset{0};
     const uint8_t* mData{nullptr};
     uint16_t mDataLinkType{0};
-    std::vector<TraceInterface> mTraceInterfaces;
-
-    struct PcapNgMetadata {
-        std::string comment;
-        std::string os;
-        std::string hardware;
-        std::string userApplication;
-        // TODO support if_tsresol per interface
-        uint32_t timestampResolution{1000000 /* 10^6 */};
-    } mMetadata{};
+    // options of all Interface Description Blocks, materialised into TraceInterfaces
+    // on request
+    std::vector<InterfaceDescriptionBlock::Options> mTraceInterfaces;
+    // interface ids are only valid within a section, reset on every Section Header Block
+    std::vector<InterfaceDescriptor> mInterfaceDescriptors;
+    // byte order of the current section, taken from its Section Header Block
+    bool mSwapped{false};
+
+    SectionHeaderBlock::Options mMetadata{};
+
+private:
+    void updateValidationLevel() {
+        mValidationLevel = mRecovery && mRequestedValidationLevel == ValidationLevel::NONE
+                               ? ValidationLevel::CHEAP
+                               : mRequestedValidationLevel;
+    }
+
+    // level the reader validates with, see setRecovery()
+    ValidationLevel mValidationLevel{ValidationLevel::CHEAP};
+    ValidationLevel mRequestedValidationLevel{ValidationLevel::CHEAP};
+    bool mRecovery{false};
+    std::vector<SkippedRange> mSkippedRanges;
+    // number of Section Header Blocks passed, the current section is mSectionCount - 1
+    uint32_t mSectionCount{0};
+    InterfaceStatisticsCallback mInterfaceStatisticsCallback;
+
+    struct NameResolutionBlockRef {
+        size_t offset;
+        bool swapped;
+    };
+
+    // Name Resolution Blocks not yet parsed into mNameResolutionTable
+    std::vector<NameResolutionBlockRef> mPendingNameResolutionBlocks;
+    // blocks before this offset have already been recorded
+    size_t mNameResolutionRecordedUntil{0};
+    NameResolutionTable mNameResolutionTable;
+
+    void recordNameResolutionBlock(size_t offset, bool swapped) {
+        if (offset >= mNameResolutionRecordedUntil) {
+            mPendingNameResolutionBlocks.push_back({offset, swapped});
+            mNameResolutionRecordedUntil = offset + 1;
+        }
+    }
+
+    template <typename ByteOrder>
+    bool readPacket(Packet& packet);
+    template <typename ByteOrder>
+    bool readNextPacketFromBlocks(Packet& packet);
+    /**
+     * readNextPacket() in recovery mode or with statistics enabled.
+     */
+    bool readNextPacketInstrumented(Packet& packet);
+    bool readNextPacketRecovering(Packet& packet);
+    /**
+     * readPacket() in the byte order of the current section.
+     */
+    bool readPacketOfSection(Packet& packet);
+    /**
+     * Accounts a block passed by the reader in the statistics, which have to be
+     * enabled.
+     */
+    void countBlock(uint32_t blockType, uint32_t blockTotalLength);
+    /**
+     * Moves the reader to the next plausible block boundary after the current offset,
+     * or to the end of the file, and records the skipped range.
+     */
+    void resynchronize(const std::string& reason);
+    bool isBlockBoundary(size_t offset, bool swapped, uint32_t& blockTotalLength) const;
+    /**
+     * Reads type and total length of the block at offset, which has to hold 12 bytes.
+     * The type of a Section Header Block is a palindrome, its byte-order magic sets
+     * swapped for the block and the following blocks of its section.
+     *
+     * @return false for a Section Header Block with an invalid byte-order magic
+     */
+    bool readBlockHeader(size_t offset,
+                         bool& swapped,
+                         uint32_t& blockType,
+                         uint32_t& blockTotalLength) const;
+    /**
+     * Calls visit(offset, blockType, swapped) for the blocks from offset to the end of
+     * the file, reading only their headers. Throws a std::runtime_error for invalid
+     * byte-order magics and block total lengths.
+     *
+     * @param swapped byte order of the section at offset
+     */
+    template <typename Visit>
+    void forEachBlock(size_t offset, bool swapped, Visit visit) const;
+    template <typename ByteOrder>
+    void readEnhancedPacketBlock(Packet& packet);
+    template <typename ByteOrder>
+    void readSimplePacketBlock(Packet& packet);
+    template <typename ByteOrder>
+    uint32_t readBlock();
+
+    /**
+     * Parses the Section Header Block at the current offset and switches to the byte
+     * order of the new section.
+     *
+     * @return block total length of the Section Header Block
+     */
+    uint32_t processSectionHeaderBlock();
+    template <typename ByteOrder>
+    void processInterfaceDescriptionBlock();
+    template <typename ByteOrder>
+    void processInterfaceStatisticsBlock();
+    const InterfaceDescriptor& lookupInterface(uint32_t interfaceId) const;
+
+    /**
+     * Validates the block total length of the block at the current offset according
+     * to the validation level, the block header has to be within the file.
+     *
+     * @return block total length
+     */
+    template <typename ByteOrder>
+    uint32_t checkBlock(uint32_t minimumLength) const;
+    void checkCaptureLength(uint32_t captureLength,
+                            uint32_t blockCapacity,
+                            uint32_t snapLength) const;
+    /**
+     * Validates the options of the block at the current offset for
+     * ValidationLevel::FULL.
+     */
+    template <typename ByteOrder>
+    void checkOptions(size_t optionsOffset) const;
+    [[noreturn]] void throwInvalidBlockLength(uint32_t blockTotalLength,
+                                              uint32_t minimumLength) const;
+    [[noreturn]] void throwInvalidCaptureLength(uint32_t captureLength,
+                                                uint32_t maximumLength) const;
+    static uint32_t minimumBlockLength(uint32_t blockType);
 };
 
+template <typename ByteOrder>
+inline bool PcapNgReader::readNextPacket(Packet& packet) {
+    if (__builtin_expect(mRecovery || mStatistics != nullptr, 0)) {
+        return readNextPacketInstrumented(packet);
+    }
+    return readPacket<ByteOrder>(packet);
+}
+
+template <typename ByteOrder>
+inline bool PcapNgReader::readPacket(Packet& packet) {
+    // fast path, the next block is an Enhanced or Simple Packet Block
+    if (mOffset + 8 <= mFileSize) {
+        const uint32_t blockType = ByteOrder::read32(&mData[mOffset]);
+        if (blockType == MMPR_ENHANCED_PACKET_BLOCK) {
+            readEnhancedPacketBlock<ByteOrder>(packet);
+            return true;
+        }
+        if (blockType == MMPR_SIMPLE_PACKET_BLOCK) {
+            readSimplePacketBlock<ByteOrder>(packet);
+            return true;
+        }
+    }
+    return readNextPacketFromBlocks<ByteOrder>(packet);
+}
+
+template <typename ByteOrder>
+inline void PcapNgReader::readEnhancedPacketBlock(Packet& packet) {
+    // standard Enhanced Packet Block has size 32 (without packet data or options)
+    checkBlock<ByteOrder>(32);
+    EnhancedPacketBlock epb{};
+    PcapNgBlockParser<ByteOrder>::readEPB(&mData[mOffset], epb);
+    const InterfaceDescriptor& interface = lookupInterface(epb.interfaceId);
+    if (mValidationLevel != ValidationLevel::NONE) {
+        checkCaptureLength(epb.capturePacketLength, epb.blockTotalLength - 32,
+                           interface.snapLength);
+        if (mValidationLevel == ValidationLevel::FULL && epb.hasOptions) {
+            checkOptions<ByteOrder>(28 + epb.capturePacketLength +
+                                    (4 - epb.capturePacketLength % 4) % 4);
+        }
+    }
+    const uint64_t timestamp = (uint64_t)epb.timestampHigh << 32 | epb.timestampLow;
+    packet.setTimestamp(interface.timestampConverter.toNanoseconds(timestamp));
+    packet.captureLength = epb.capturePacketLength;
+    packet.length = epb.originalPacketLength;
+    packet.data = epb.packetData;
+    packet.interfaceIndex = epb.interfaceId;
+    packet.optionsBlock = epb.hasOptions ? &mData[mOffset] : nullptr;
+    packet.optionsSwapped = ByteOrder::SWAPPED;
+
+    mOffset += epb.blockTotalLength;
+}
+
+template <typename ByteOrder>
+inline void PcapNgReader::readSimplePacketBlock(Packet& packet) {
+    // Simple Packet Blocks belong to the first interface of the section and carry no
+    // timestamp
+    checkBlock<ByteOrder>(16);
+    const InterfaceDescriptor& interface = lookupInterface(0);
+    SimplePacketBlock spb{};
+    PcapNgBlockParser<ByteOrder>::readSPB(&mData[mOffset], interface.snapLength, spb);
+    packet.setTimestamp(0);
+    packet.captureLength = spb.capturePacketLength;
+    packet.length = spb.originalPacketLength;
+    packet.data = spb.packetData;
+    packet.interfaceIndex = 0;
+    packet.optionsBlock = nullptr;
+    packet.optionsSwapped = false;
+
+    mOffset += spb.blockTotalLength;
+}
+
+inline const InterfaceDescriptor&
+PcapNgReader::lookupInterface(uint32_t interfaceId) const {
+    if (interfaceId >= mInterfaceDescriptors.size()) {
+        throw std::runtime_error(
+            "Packet refers to interface " + std::to_string(interfaceId) + ", but only " +
+            std::to_string(mInterfaceDescriptors.size()) +
+            " interfaces have been described in the current section");
+    }
+    return mInterfaceDescriptors[interfaceId];
+}
+
+template <typename ByteOrder>
+inline uint32_t PcapNgReader::checkBlock(uint32_t minimumLength) const {
+    const uint32_t blockTotalLength = ByteOrder::read32(&mData[mOffset + 4]);
+    // compares that hold for every valid block, the branches are never taken
+    if (__builtin_expect(blockTotalLength < minimumLength, 0)) {
+        throwInvalidBlockLength(blockTotalLength, minimumLength);
+    }
+    if (mValidationLevel != ValidationLevel::NONE &&
+        __builtin_expect(blockTotalLength > mFileSize - mOffset ||
+                             blockTotalLength % 4 != 0 ||
+                             ByteOrder::read32(&mData[mOffset + blockTotalLength - 4]) !=
+                                 blockTotalLength,
+                         0)) {
+        throwInvalidBlockLength(blockTotalLength, minimumLength);
+    }
+    return blockTotalLength;
+}
+
+inline void PcapNgReader::checkCaptureLength(uint32_t captureLength,
+                                             uint32_t blockCapacity,
+                                             uint32_t snapLength) const {
+    // a snapshot length of 0 is unlimited
+    const uint32_t maximumLength =
+        snapLength != 0 && snapLength < blockCapacity ? snapLength : blockCapacity;
+    if (__builtin_expect(captureLength > maximumLength, 0)) {
+        throwInvalidCaptureLength(captureLength, maximumLength);
+    }
+}
+
 } // namespace mmpr
 
 #endif // MMPR_PCAPNGREADER_H
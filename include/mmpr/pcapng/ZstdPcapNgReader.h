@@ -1,16 +1,32 @@
 #ifndef MMPR_ZSTDPCAPNGREADER_H
 #define MMPR_ZSTDPCAPNGREADER_H
 
+#include "mmpr/ZstdDecompressionPool.h"
 #include "mmpr/pcapng/PcapNgReader.h"
+#include <memory>
 
 namespace mmpr {
 
 class ZstdPcapNgReader : public PcapNgReader {
 public:
-    explicit ZstdPcapNgReader(const std::string& filepath);
+    /**
+     * @param pool decompression contexts and buffers shared with other readers, a
+     *             private pool is created if none is given
+     */
+    explicit ZstdPcapNgReader(const std::string& filepath,
+                              std::shared_ptr<ZstdDecompressionPool> pool = nullptr);
+    /**
+     * Decompresses the already opened file, takes ownership of fileDescriptor.
+     */
+    ZstdPcapNgReader(const std::string& filepath,
+                     int fileDescriptor,
+                     std::shared_ptr<ZstdDecompressionPool> pool = nullptr);
 
     void open() override;
     void close() override;
+
+private:
+    std::shared_ptr<ZstdDecompressionPool> mPool;
 };
 
 } // namespace mmpr
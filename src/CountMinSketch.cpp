@@ -0,0 +1,35 @@
+#include "mmpr/CountMinSketch.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace mmpr {
+
+CountMinSketch::CountMinSketch(size_t width) : mWidth(width) {
+    if (width == 0 || (width & (width - 1)) != 0) {
+        throw invalid_argument("Count-Min sketch width has to be a power of two");
+    }
+    mCounters.resize(DEPTH * width);
+}
+
+uint64_t CountMinSketch::estimate(uint64_t hash) const {
+    uint64_t estimate = UINT64_MAX;
+    for (size_t row = 0; row < DEPTH; ++row) {
+        estimate = min(estimate, mCounters[row * mWidth + column(hash, row)]);
+    }
+    return estimate;
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+    if (other.mWidth != mWidth) {
+        throw invalid_argument("Cannot merge Count-Min sketches of widths " +
+                               to_string(mWidth) + " and " + to_string(other.mWidth));
+    }
+    for (size_t i = 0; i < mCounters.size(); ++i) {
+        mCounters[i] += other.mCounters[i];
+    }
+}
+
+} // namespace mmpr
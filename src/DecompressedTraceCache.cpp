@@ -0,0 +1,305 @@
+#ifdef MMPR_USE_ZSTD
+
+#include "mmpr/DecompressedTraceCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zstd.h>
+
+using namespace std;
+
+namespace mmpr {
+namespace {
+
+// largest zstd frame header (ZSTD_FRAMEHEADERSIZE_MAX, only in the static zstd API)
+const size_t FRAME_HEADER_SIZE_MAX = 18;
+const char* const COPY_SUFFIX = ".pcapng";
+
+/**
+ * Decompressed size from the zstd frame header, 0 if the header does not state it.
+ */
+size_t readContentSize(const string& filepath) {
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw runtime_error("Error while reading file " +
+                            filesystem::absolute(filepath).string() + ": " +
+                            strerror(errno));
+    }
+    uint8_t header[FRAME_HEADER_SIZE_MAX];
+    ssize_t length = pread(fd, header, sizeof(header), 0);
+    ::close(fd);
+    if (length <= 0) {
+        return 0;
+    }
+
+    unsigned long long const contentSize = ZSTD_getFrameContentSize(header, length);
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR ||
+        contentSize == ZSTD_CONTENTSIZE_UNKNOWN) {
+        return 0;
+    }
+    return contentSize;
+}
+
+/**
+ * Decompresses filepath and writes the result to fd.
+ */
+void writeDecompressed(ZstdDecompressionPool& pool, const string& filepath, int fd) {
+    size_t size;
+    const uint8_t* data = pool.decompress(filepath, size);
+    size_t written = 0;
+    while (written < size) {
+        ssize_t result = write(fd, &data[written], size - written);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            int error = result < 0 ? errno : EIO;
+            pool.release(data);
+            throw runtime_error("Error while caching decompressed " + filepath + ": " +
+                                strerror(error));
+        }
+        written += result;
+    }
+    pool.release(data);
+}
+
+/**
+ * Opens the file behind a writable descriptor read-only and closes the writable one,
+ * also if it fails. Goes through /proc, so it works for memfds and for files that were
+ * renamed or removed in the meantime.
+ */
+int reopenReadOnly(int fd, const string& filepath) {
+    const string path = "/proc/self/fd/" + to_string(fd);
+    int readOnly = ::open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    const int error = errno;
+    ::close(fd);
+    if (readOnly < 0) {
+        throw runtime_error("Unable to reopen the decompressed copy of " + filepath +
+                            " read-only: " + strerror(error));
+    }
+    return readOnly;
+}
+
+/**
+ * FNV-1a, names the copies in the scratch directory.
+ */
+uint64_t hashKey(const string& key) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (char c : key) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+} // namespace
+
+DecompressedTraceCache::DecompressedTraceCache(
+    const Config& config, std::shared_ptr<ZstdDecompressionPool> pool)
+    : mConfig(config), mPool(std::move(pool)) {
+    if (!mPool) {
+        mPool = std::make_shared<ZstdDecompressionPool>();
+    }
+    if (!mConfig.directory.empty()) {
+        filesystem::create_directories(mConfig.directory);
+    }
+}
+
+DecompressedTraceCache::~DecompressedTraceCache() {
+    for (const Entry& entry : mEntries) {
+        ::close(entry.fileDescriptor);
+    }
+}
+
+int DecompressedTraceCache::acquire(const std::string& filepath) {
+    struct stat status {};
+    if (::stat(filepath.c_str(), &status) != 0) {
+        throw runtime_error("Cannot find file " +
+                            filesystem::absolute(filepath).string());
+    }
+
+    string key = filesystem::absolute(filepath).lexically_normal().string() + '\n' +
+                 to_string(status.st_mtim.tv_sec * 1000000000LL +
+                           status.st_mtim.tv_nsec) +
+                 '\n' + to_string(status.st_size);
+    return mConfig.directory.empty() ? acquireFromMemory(key, filepath)
+                                     : acquireFromDirectory(key, filepath);
+}
+
+DecompressedTraceCache::Stats DecompressedTraceCache::getStats() const {
+    lock_guard<mutex> lock(mMutex);
+    return mStats;
+}
+
+int DecompressedTraceCache::acquireFromMemory(const string& key, const string& filepath) {
+    {
+        lock_guard<mutex> lock(mMutex);
+        auto it = mIndex.find(key);
+        if (it != mIndex.end()) {
+            mEntries.splice(mEntries.begin(), mEntries, it->second);
+            ++mStats.hits;
+            return dup(it->second->fileDescriptor);
+        }
+    }
+
+    size_t size = readContentSize(filepath);
+    if (size == 0 || size > mConfig.byteBudget) {
+        lock_guard<mutex> lock(mMutex);
+        ++mStats.uncacheable;
+        return -1;
+    }
+
+    int fd = memfd_create("mmpr-trace", MFD_CLOEXEC);
+    if (fd < 0) {
+        throw runtime_error("Unable to create memfd for " + filepath + ": " +
+                            strerror(errno));
+    }
+    try {
+        writeDecompressed(*mPool, filepath, fd);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    // the cache and its callers only get read-only descriptors of the shared copy
+    fd = reopenReadOnly(fd, filepath);
+
+    lock_guard<mutex> lock(mMutex);
+    auto it = mIndex.find(key);
+    if (it != mIndex.end()) {
+        // decompressed concurrently by another thread
+        ::close(fd);
+        mEntries.splice(mEntries.begin(), mEntries, it->second);
+        ++mStats.hits;
+        return dup(it->second->fileDescriptor);
+    }
+
+    while (!mEntries.empty() && mCachedBytes + size > mConfig.byteBudget) {
+        const Entry& last = mEntries.back();
+        ::close(last.fileDescriptor);
+        mCachedBytes -= last.size;
+        mIndex.erase(last.key);
+        mEntries.pop_back();
+        ++mStats.evictions;
+    }
+    mEntries.push_front(Entry{key, fd, size});
+    mIndex[key] = mEntries.begin();
+    mCachedBytes += size;
+    ++mStats.misses;
+    return dup(fd);
+}
+
+int DecompressedTraceCache::acquireFromDirectory(const string& key,
+                                                 const string& filepath) {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx",
+             static_cast<unsigned long long>(hashKey(key)));
+    const string path =
+        (filesystem::path(mConfig.directory) / name).string() + COPY_SUFFIX;
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd >= 0) {
+        // marks the copy as recently used for all processes sharing the directory
+        futimens(fd, nullptr);
+        lock_guard<mutex> lock(mMutex);
+        ++mStats.hits;
+        return fd;
+    }
+
+    size_t size = readContentSize(filepath);
+    if (size == 0 || size > mConfig.byteBudget) {
+        lock_guard<mutex> lock(mMutex);
+        ++mStats.uncacheable;
+        return -1;
+    }
+
+    {
+        lock_guard<mutex> lock(mMutex);
+        evictFromDirectory(size);
+    }
+
+    // written under a unique name and renamed, other processes never see partial copies
+    static atomic<uint32_t> temporaryCounter{0};
+    const string temporaryPath = path + "." + to_string(getpid()) + "." +
+                                 to_string(temporaryCounter++) + ".tmp";
+    fd = ::open(temporaryPath.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw runtime_error("Unable to create " + temporaryPath + ": " + strerror(errno));
+    }
+    try {
+        writeDecompressed(*mPool, filepath, fd);
+    } catch (...) {
+        ::close(fd);
+        unlink(temporaryPath.c_str());
+        throw;
+    }
+    try {
+        // callers must not modify the copy shared with other processes
+        fd = reopenReadOnly(fd, filepath);
+    } catch (...) {
+        unlink(temporaryPath.c_str());
+        throw;
+    }
+    if (rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        const int error = errno;
+        ::close(fd);
+        unlink(temporaryPath.c_str());
+        throw runtime_error("Unable to rename " + temporaryPath + ": " + strerror(error));
+    }
+
+    lock_guard<mutex> lock(mMutex);
+    ++mStats.misses;
+    return fd;
+}
+
+void DecompressedTraceCache::evictFromDirectory(size_t required) {
+    struct Copy {
+        int64_t lastUse;
+        size_t size;
+        string path;
+    };
+    vector<Copy> copies;
+    size_t total = 0;
+    error_code error;
+    for (const auto& file : filesystem::directory_iterator(mConfig.directory, error)) {
+        const string path = file.path().string();
+        if (path.size() <= strlen(COPY_SUFFIX) ||
+            path.compare(path.size() - strlen(COPY_SUFFIX), string::npos, COPY_SUFFIX) !=
+                0) {
+            continue;
+        }
+        struct stat status {};
+        if (::stat(path.c_str(), &status) != 0) {
+            // removed by another process in the meantime
+            continue;
+        }
+        copies.push_back(Copy{status.st_mtim.tv_sec * 1000000000LL +
+                                  status.st_mtim.tv_nsec,
+                              static_cast<size_t>(status.st_size), path});
+        total += status.st_size;
+    }
+
+    sort(copies.begin(), copies.end(),
+         [](const Copy& a, const Copy& b) { return a.lastUse < b.lastUse; });
+    for (const Copy& copy : copies) {
+        if (total + required <= mConfig.byteBudget) {
+            break;
+        }
+        if (unlink(copy.path.c_str()) == 0) {
+            ++mStats.evictions;
+        }
+        total -= copy.size;
+    }
+}
+
+} // namespace mmpr
+
+#endif
@@ -0,0 +1,101 @@
+#include "mmpr/FileSet.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace mmpr {
+namespace {
+
+// record layout of getdents64(2), glibc only wraps the call since 2.30
+struct LinuxDirent64 {
+    uint64_t inode;
+    int64_t offset;
+    unsigned short recordLength;
+    unsigned char type;
+    // zero terminated, continues up to recordLength
+    char name[1];
+};
+
+} // namespace
+
+FileSet::FileSet(const std::string& directory) : mDirectory(directory) {
+    mDirectoryDescriptor =
+        ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC, 0);
+    if (mDirectoryDescriptor < 0) {
+        throw runtime_error("Error while opening directory " + directory + ": " +
+                            strerror(errno));
+    }
+
+    // large batches keep the number of getdents64 calls low for huge directories
+    alignas(LinuxDirent64) char buffer[64 * 1024];
+    while (true) {
+        long length =
+            syscall(SYS_getdents64, mDirectoryDescriptor, buffer, sizeof(buffer));
+        if (length < 0) {
+            int error = errno;
+            ::close(mDirectoryDescriptor);
+            throw runtime_error("Error while listing directory " + directory + ": " +
+                                strerror(error));
+        }
+        if (length == 0) {
+            break;
+        }
+
+        for (long offset = 0; offset < length;) {
+            const auto* entry = reinterpret_cast<const LinuxDirent64*>(&buffer[offset]);
+            offset += entry->recordLength;
+
+            const char* name = reinterpret_cast<const char*>(entry) +
+                               offsetof(LinuxDirent64, name);
+            unsigned char type = entry->type;
+            if (type == DT_LNK || type == DT_UNKNOWN) {
+                // only some file systems report the type, links need their target
+                struct stat status {};
+                if (fstatat(mDirectoryDescriptor, name, &status, 0) != 0) {
+                    continue;
+                }
+                type = S_ISREG(status.st_mode) ? DT_REG : DT_UNKNOWN;
+            }
+            if (type == DT_REG) {
+                mNames.emplace_back(name);
+            }
+        }
+    }
+    sort(mNames.begin(), mNames.end());
+}
+
+FileSet::~FileSet() {
+    ::close(mDirectoryDescriptor);
+}
+
+std::string FileSet::getPath(size_t index) const {
+    const string& name = mNames.at(index);
+    if (!mDirectory.empty() && mDirectory.back() != '/') {
+        return mDirectory + '/' + name;
+    }
+    return mDirectory + name;
+}
+
+std::unique_ptr<FileReader>
+FileSet::getReader(size_t index,
+                   const std::shared_ptr<ZstdDecompressionPool>& pool) const {
+    const string& name = mNames.at(index);
+    int fd = openat(mDirectoryDescriptor, name.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw runtime_error("Error while opening file " + getPath(index) + ": " +
+                            strerror(errno));
+    }
+    return FileReader::getReader(fd, getPath(index), pool);
+}
+
+} // namespace mmpr
@@ -0,0 +1,167 @@
+#include "mmpr/HeavyHitters.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace mmpr {
+
+HeavyHitters::HeavyHitters(size_t capacity, size_t width)
+    : mCapacity(capacity), mSketch(width) {
+    if (capacity == 0) {
+        throw invalid_argument("HeavyHitters requires a capacity of at least 1");
+    }
+    size_t slots = 1;
+    while (slots < 2 * capacity) {
+        slots <<= 1;
+    }
+    mHeap.reserve(capacity);
+    mIndex.resize(slots);
+}
+
+void HeavyHitters::update(const Key& key, uint64_t hash, uint64_t estimate) {
+    const size_t slot = findSlot(key, hash);
+    size_t position;
+    if (mIndex[slot] != 0) {
+        position = mIndex[slot] - 1;
+    } else if (mHeap.size() < mCapacity) {
+        position = mHeap.size();
+        mHeap.push_back({key, hash, estimate, 0});
+        insertSlot(position);
+        // sift the new entry up
+        while (position > 0 && mHeap[(position - 1) / 2].count > mHeap[position].count) {
+            swapEntries(position, (position - 1) / 2);
+            position = (position - 1) / 2;
+        }
+        return;
+    } else {
+        // the new key replaces the entry with the smallest count
+        position = 0;
+        eraseSlot(mHeap[0].slot);
+        mHeap[0].key = key;
+        mHeap[0].hash = hash;
+        insertSlot(0);
+    }
+    // counts only grow, so the entry can only move down
+    mHeap[position].count = estimate;
+    siftDown(position);
+}
+
+size_t HeavyHitters::findSlot(const Key& key, uint64_t hash) const {
+    const size_t mask = mIndex.size() - 1;
+    size_t slot = hash & mask;
+    while (mIndex[slot] != 0) {
+        const HeapEntry& entry = mHeap[mIndex[slot] - 1];
+        if (entry.hash == hash && entry.key == key) {
+            break;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void HeavyHitters::insertSlot(size_t position) {
+    const size_t mask = mIndex.size() - 1;
+    size_t slot = mHeap[position].hash & mask;
+    while (mIndex[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    mIndex[slot] = (uint32_t)(position + 1);
+    mHeap[position].slot = slot;
+}
+
+void HeavyHitters::eraseSlot(size_t slot) {
+    // backward shift deletion, moves later entries of the probe sequence into the gap
+    const size_t mask = mIndex.size() - 1;
+    mIndex[slot] = 0;
+    size_t next = slot;
+    while (true) {
+        next = (next + 1) & mask;
+        if (mIndex[next] == 0) {
+            return;
+        }
+        const size_t home = mHeap[mIndex[next] - 1].hash & mask;
+        // entries whose home lies cyclically in (slot, next] stay
+        const bool stays = slot <= next ? (slot < home && home <= next)
+                                        : (slot < home || home <= next);
+        if (!stays) {
+            mIndex[slot] = mIndex[next];
+            mHeap[mIndex[slot] - 1].slot = slot;
+            mIndex[next] = 0;
+            slot = next;
+        }
+    }
+}
+
+void HeavyHitters::siftDown(size_t position) {
+    while (true) {
+        const size_t left = 2 * position + 1;
+        if (left >= mHeap.size()) {
+            return;
+        }
+        const size_t right = left + 1;
+        size_t smallest = left;
+        if (right < mHeap.size() && mHeap[right].count < mHeap[left].count) {
+            smallest = right;
+        }
+        if (mHeap[position].count <= mHeap[smallest].count) {
+            return;
+        }
+        swapEntries(position, smallest);
+        position = smallest;
+    }
+}
+
+void HeavyHitters::swapEntries(size_t a, size_t b) {
+    swap(mHeap[a], mHeap[b]);
+    mIndex[mHeap[a].slot] = (uint32_t)(a + 1);
+    mIndex[mHeap[b].slot] = (uint32_t)(b + 1);
+}
+
+void HeavyHitters::merge(const HeavyHitters& other) {
+    if (other.mCapacity != mCapacity) {
+        throw invalid_argument("Cannot merge heavy hitters of capacities " +
+                               to_string(mCapacity) + " and " +
+                               to_string(other.mCapacity));
+    }
+    mSketch.merge(other.mSketch);
+
+    vector<HeapEntry> candidates = mHeap;
+    candidates.insert(candidates.end(), other.mHeap.begin(), other.mHeap.end());
+    for (auto& candidate : candidates) {
+        candidate.count = mSketch.estimate(candidate.hash);
+    }
+    sort(candidates.begin(), candidates.end(),
+         [](const HeapEntry& a, const HeapEntry& b) {
+             return a.count != b.count ? a.count > b.count : a.key < b.key;
+         });
+    candidates.erase(unique(candidates.begin(), candidates.end(),
+                            [](const HeapEntry& a, const HeapEntry& b) {
+                                return a.key == b.key;
+                            }),
+                     candidates.end());
+    if (candidates.size() > mCapacity) {
+        candidates.resize(mCapacity);
+    }
+
+    // ascending counts are a valid min-heap
+    mHeap.assign(candidates.rbegin(), candidates.rend());
+    fill(mIndex.begin(), mIndex.end(), 0);
+    for (size_t i = 0; i < mHeap.size(); ++i) {
+        insertSlot(i);
+    }
+}
+
+vector<HeavyHitters::Entry> HeavyHitters::top() const {
+    vector<Entry> entries;
+    for (const auto& entry : mHeap) {
+        entries.push_back({entry.key, entry.count});
+    }
+    sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.count != b.count ? a.count > b.count : a.key < b.key;
+    });
+    return entries;
+}
+
+} // namespace mmpr
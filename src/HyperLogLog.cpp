@@ -0,0 +1,32 @@
+#include "mmpr/HyperLogLog.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace mmpr {
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+    for (size_t i = 0; i < REGISTERS; ++i) {
+        mRegisters[i] = max(mRegisters[i], other.mRegisters[i]);
+    }
+}
+
+double HyperLogLog::estimate() const {
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t rank : mRegisters) {
+        sum += ldexp(1.0, -rank);
+        zeros += rank == 0;
+    }
+    const double m = REGISTERS;
+    const double alpha = 0.7213 / (1 + 1.079 / m);
+    const double raw = alpha * m * m / sum;
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * log(m / zeros);
+    }
+    return raw;
+}
+
+} // namespace mmpr
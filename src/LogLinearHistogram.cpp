@@ -0,0 +1,71 @@
+#include "mmpr/LogLinearHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace mmpr {
+
+void LogLinearHistogram::merge(const LogLinearHistogram& other) {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        mCounts[i] += other.mCounts[i];
+    }
+    mSum += other.mSum;
+    mMin = min(mMin, other.mMin);
+    mMax = max(mMax, other.mMax);
+}
+
+uint64_t LogLinearHistogram::getCount() const {
+    uint64_t count = 0;
+    for (uint64_t bucket : mCounts) {
+        count += bucket;
+    }
+    return count;
+}
+
+double LogLinearHistogram::getMean() const {
+    const uint64_t count = getCount();
+    return count > 0 ? (double)mSum / count : 0;
+}
+
+uint64_t LogLinearHistogram::valueAtQuantile(double quantile) const {
+    const uint64_t count = getCount();
+    if (count == 0) {
+        return 0;
+    }
+    quantile = min(max(quantile, 0.0), 1.0);
+    // rank of the value, counted from 1
+    const uint64_t rank = max<uint64_t>(1, (uint64_t)ceil(quantile * count));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += mCounts[i];
+        if (seen >= rank) {
+            return min(bucketUpperBound(i), mMax);
+        }
+    }
+    return mMax;
+}
+
+uint64_t LogLinearHistogram::bucketLowerBound(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    const size_t shift = (index >> SUB_BUCKET_BITS) - 1;
+    return (uint64_t)(index - (shift << SUB_BUCKET_BITS)) << shift;
+}
+
+uint64_t LogLinearHistogram::bucketUpperBound(size_t index) {
+    if (index < 2 * SUB_BUCKETS) {
+        return index;
+    }
+    const size_t shift = (index >> SUB_BUCKET_BITS) - 1;
+    return bucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+}
+
+bool LogLinearHistogram::operator==(const LogLinearHistogram& other) const {
+    return mSum == other.mSum && mMin == other.mMin && mMax == other.mMax &&
+           mCounts == other.mCounts;
+}
+
+} // namespace mmpr
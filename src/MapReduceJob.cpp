@@ -0,0 +1,336 @@
+#include "mmpr/MapReduceJob.h"
+
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng.h"
+#include "util.h"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+#define MMPR_MAP_REDUCE_PLAN_HEADER "mmpr-plan 1"
+
+namespace mmpr {
+namespace {
+
+bool isPcap(const string& filepath) {
+    const uint32_t magicNumber = util::read32bitsFromFile(filepath);
+    return magicNumber == MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS ||
+           magicNumber == MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS ||
+           magicNumber == MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS_SWAPPED ||
+           magicNumber == MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS_SWAPPED;
+}
+
+/**
+ * @return bytes of the file the item covers
+ */
+uint64_t itemWeight(const MapReduceJob::WorkItem& item) {
+    error_code error;
+    const uint64_t fileSize = filesystem::file_size(item.filepath, error);
+    if (error) {
+        return 0;
+    }
+    return min(item.end, fileSize) - min(item.begin, fileSize);
+}
+
+void writeExtent(const string& filepath, const MapReduceJob::ReadExtent& extent) {
+    const string temporary = filepath + ".tmp";
+    {
+        ofstream file(temporary, ios::trunc);
+        file << extent.first << ' ' << extent.end << '\n';
+        if (!file) {
+            throw runtime_error("Failed to write " + temporary);
+        }
+    }
+    filesystem::rename(temporary, filepath);
+}
+
+string hostName() {
+    char name[256] = {};
+    if (gethostname(name, sizeof(name) - 1) != 0) {
+        return "unknown";
+    }
+    return name;
+}
+
+MapReduceJob::ReadExtent readExtent(const string& filepath) {
+    ifstream file(filepath);
+    MapReduceJob::ReadExtent extent;
+    if (!(file >> extent.first >> extent.end)) {
+        throw runtime_error("Failed to read " + filepath);
+    }
+    return extent;
+}
+
+} // namespace
+
+MapReduceJob::MapReduceJob(string directory) : mDirectory(std::move(directory)) {}
+
+void MapReduceJob::plan(const vector<string>& files, uint64_t splitSize) {
+    filesystem::create_directories(mDirectory);
+    for (const auto& entry : filesystem::directory_iterator(mDirectory)) {
+        const string extension = entry.path().extension().string();
+        if (extension == ".claim" || extension == ".summary" || extension == ".extent" ||
+            extension == ".tmp") {
+            filesystem::remove(entry.path());
+        }
+    }
+
+    mItems.clear();
+    for (const auto& file : files) {
+        // absolute, workers on other hosts see the same paths on the shared filesystem
+        const string filepath = filesystem::absolute(file).string();
+        const uint64_t fileSize = filesystem::file_size(filepath);
+        if (splitSize == 0 || fileSize <= splitSize || !isPcap(filepath)) {
+            mItems.push_back({filepath, 0, UINT64_MAX});
+            continue;
+        }
+        for (uint64_t begin = 0; begin < fileSize; begin += splitSize) {
+            const uint64_t end = fileSize - begin > splitSize ? begin + splitSize
+                                                               : UINT64_MAX;
+            mItems.push_back({filepath, begin, end});
+        }
+    }
+    mItemsLoaded = true;
+
+    const string planPath = mDirectory + "/plan";
+    {
+        ofstream plan(planPath + ".tmp", ios::trunc);
+        plan << MMPR_MAP_REDUCE_PLAN_HEADER << '\n';
+        for (const auto& item : mItems) {
+            plan << item.begin << ' ' << item.end << ' ' << item.filepath << '\n';
+        }
+        if (!plan) {
+            throw runtime_error("Failed to write " + planPath);
+        }
+    }
+    filesystem::rename(planPath + ".tmp", planPath);
+}
+
+const vector<MapReduceJob::WorkItem>& MapReduceJob::getItems() {
+    if (mItemsLoaded) {
+        return mItems;
+    }
+    const string planPath = mDirectory + "/plan";
+    ifstream plan(planPath);
+    string line;
+    if (!getline(plan, line) || line != MMPR_MAP_REDUCE_PLAN_HEADER) {
+        throw runtime_error("No map/reduce plan in " + mDirectory);
+    }
+    while (getline(plan, line)) {
+        WorkItem item;
+        size_t position;
+        item.begin = stoull(line, &position);
+        line = line.substr(position + 1);
+        item.end = stoull(line, &position);
+        item.filepath = line.substr(position + 1);
+        mItems.push_back(item);
+    }
+    mItemsLoaded = true;
+    return mItems;
+}
+
+size_t MapReduceJob::work() {
+    const vector<WorkItem>& items = getItems();
+    vector<uint64_t> weights;
+    for (const auto& item : items) {
+        weights.push_back(itemWeight(item));
+    }
+    vector<size_t> order(items.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(),
+                [&weights](size_t a, size_t b) { return weights[a] > weights[b]; });
+
+    size_t mapped = 0;
+    for (size_t item : order) {
+        const string claimPath = itemPath(item, ".claim");
+        if (!claim(claimPath)) {
+            continue;
+        }
+        try {
+            ReadExtent extent;
+            const TraceSummary summary = map(items[item], &extent);
+            // before the summary, which marks the item as done
+            if (items[item].isRange()) {
+                writeExtent(itemPath(item, ".extent"), extent);
+            }
+            summary.writeFile(itemPath(item, ".summary"));
+        } catch (...) {
+            // lets the next worker try again
+            ::unlink(claimPath.c_str());
+            throw;
+        }
+        ++mapped;
+    }
+    return mapped;
+}
+
+bool MapReduceJob::claim(const string& claimPath) const {
+    const string owner = hostName() + ' ' + to_string(getpid()) + '\n';
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        // O_EXCL is atomic on local filesystems and NFSv3 or later
+        int fd = ::open(claimPath.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+        if (fd >= 0) {
+            const bool written =
+                ::write(fd, owner.data(), owner.size()) == (ssize_t)owner.size();
+            ::close(fd);
+            if (!written) {
+                ::unlink(claimPath.c_str());
+                throw runtime_error("Failed to write " + claimPath);
+            }
+            return true;
+        }
+        if (errno != EEXIST) {
+            throw runtime_error("Failed to claim " + claimPath + ": " + strerror(errno));
+        }
+        if (attempt > 0 || !isStale(claimPath)) {
+            return false;
+        }
+        // rename is atomic, only one of the workers that found the claim stale takes it
+        // over, the others fail with ENOENT
+        const string stale = claimPath + "." + to_string(getpid()) + ".tmp";
+        if (rename(claimPath.c_str(), stale.c_str()) != 0) {
+            return false;
+        }
+        ::unlink(stale.c_str());
+    }
+    return false;
+}
+
+bool MapReduceJob::isStale(const string& claimPath) const {
+    const string summaryPath = claimPath.substr(0, claimPath.size() - 6) + ".summary";
+    struct stat status {};
+    if (::stat(claimPath.c_str(), &status) != 0 || filesystem::exists(summaryPath)) {
+        return false;
+    }
+    ifstream file(claimPath);
+    string host;
+    pid_t pid = 0;
+    if (file >> host >> pid && host == hostName() && pid > 0 &&
+        kill(pid, 0) != 0 && errno == ESRCH) {
+        return true;
+    }
+    const uint64_t age = (uint64_t)(time(nullptr) - status.st_mtime);
+    return mClaimTimeout > 0 && age > mClaimTimeout;
+}
+
+void MapReduceJob::runWorkers(size_t workers) {
+    getItems();
+    // buffered output would otherwise be written by every worker again
+    fflush(stdout);
+    fflush(stderr);
+
+    vector<pid_t> pids;
+    for (size_t i = 0; i < workers; ++i) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            throw runtime_error(string("Failed to fork a worker: ") + strerror(errno));
+        }
+        if (pid == 0) {
+            int status = EXIT_SUCCESS;
+            try {
+                work();
+            } catch (const exception& e) {
+                fprintf(stderr, "Worker %d failed: %s\n", (int)getpid(), e.what());
+                status = EXIT_FAILURE;
+            }
+            // skips destructors and atexit handlers of the parent's state
+            _exit(status);
+        }
+        pids.push_back(pid);
+    }
+
+    size_t failed = 0;
+    for (pid_t pid : pids) {
+        int status;
+        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+            WEXITSTATUS(status) != EXIT_SUCCESS) {
+            ++failed;
+        }
+    }
+    if (failed > 0) {
+        throw runtime_error(to_string(failed) + " of " + to_string(workers) +
+                            " workers failed");
+    }
+}
+
+TraceSummary MapReduceJob::reduce() {
+    const vector<WorkItem>& items = getItems();
+    TraceSummary summary;
+    ReadExtent previous;
+    mRemappedItems = 0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        const string summaryPath = itemPath(i, ".summary");
+        if (!filesystem::exists(summaryPath)) {
+            throw runtime_error("Missing summary of work item " + to_string(i) + " (" +
+                                items[i].filepath + ")");
+        }
+        TraceSummary itemSummary = TraceSummary::readFile(summaryPath);
+        if (items[i].isRange()) {
+            ReadExtent extent = readExtent(itemPath(i, ".extent"));
+            // ranges of a file are consecutive items
+            if (items[i].begin != 0 && extent.first != previous.end) {
+                // the records chained up at the begin of the range were packet data of
+                // the record that straddles it, or records that failed the checks
+                WorkItem remainder = items[i];
+                remainder.begin = previous.end;
+                itemSummary = map(remainder, &extent, false);
+                writeExtent(itemPath(i, ".extent"), extent);
+                itemSummary.writeFile(summaryPath);
+                ++mRemappedItems;
+            }
+            previous = extent;
+        }
+        summary.merge(itemSummary);
+    }
+    return summary;
+}
+
+TraceSummary MapReduceJob::map(const WorkItem& item, ReadExtent* extent,
+                               bool synchronize) {
+    unique_ptr<FileReader> reader = FileReader::getReader(item.filepath);
+    if (item.isRange()) {
+        auto* pcapReader = dynamic_cast<MMPcapReader*>(reader.get());
+        if (pcapReader == nullptr) {
+            throw runtime_error("Byte ranges are only supported for Pcap files: " +
+                                item.filepath);
+        }
+        pcapReader->setRange(item.begin, item.end, synchronize);
+    }
+    reader->open();
+    if (extent != nullptr) {
+        extent->first = reader->getCurrentOffset();
+    }
+
+    TraceSummary summary;
+    Packet packet;
+    while (!reader->isExhausted()) {
+        if (reader->readNextPacket(packet)) {
+            summary.add(packet, reader->getDataLinkType(packet));
+        }
+    }
+    if (extent != nullptr) {
+        extent->end = reader->getCurrentOffset();
+    }
+    reader->close();
+    return summary;
+}
+
+string MapReduceJob::itemPath(size_t item, const char* extension) const {
+    char name[32];
+    snprintf(name, sizeof(name), "/item-%06zu", item);
+    return mDirectory + name + extension;
+}
+
+} // namespace mmpr
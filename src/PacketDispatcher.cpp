@@ -0,0 +1,511 @@
+#include "mmpr/PacketDispatcher.h"
+
+#include "mmpr/pcapng/PcapNgReader.h"
+#include "util.h"
+#include <cstring>
+#include <exception>
+#include <pthread.h>
+#include <sched.h>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+#define MMPR_DISPATCH_SPIN_LIMIT 64
+
+namespace mmpr {
+namespace {
+
+/**
+ * Spins for a while, afterwards yields the CPU to other threads.
+ */
+class Backoff {
+public:
+    void pause() {
+        if (mSpins < MMPR_DISPATCH_SPIN_LIMIT) {
+            ++mSpins;
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#endif
+        } else {
+            this_thread::yield();
+        }
+    }
+
+    void reset() { mSpins = 0; }
+
+private:
+    uint32_t mSpins{0};
+};
+
+void pinThread(pthread_t thread, int cpu) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    int result = pthread_setaffinity_np(thread, sizeof(cpu_set_t), &cpuSet);
+    if (result != 0) {
+        throw runtime_error("Failed to pin thread to CPU " + to_string(cpu) + ": " +
+                            strerror(result));
+    }
+}
+
+inline uint16_t read16BigEndian(const uint8_t* data) {
+    return (uint16_t)(data[0] << 8 | data[1]);
+}
+
+inline uint32_t read32BigEndian(const uint8_t* data) {
+    return (uint32_t)data[0] << 24 | (uint32_t)data[1] << 16 | (uint32_t)data[2] << 8 |
+           (uint32_t)data[3];
+}
+
+inline uint64_t fold128(const uint8_t* data) {
+    uint64_t high;
+    uint64_t low;
+    memcpy(&high, data, 8);
+    memcpy(&low, data + 8, 8);
+    return util::mix64(high) ^ low;
+}
+
+inline bool hasPorts(uint8_t protocol) {
+    // TCP, UDP, SCTP and UDP-Lite start with source and destination port
+    return protocol == 6 || protocol == 17 || protocol == 132 || protocol == 136;
+}
+
+/**
+ * Combines both endpoints in canonical order so that swapping source and destination
+ * yields the same hash.
+ */
+inline uint32_t symmetricHash(uint64_t endpointA, uint64_t endpointB, uint8_t protocol) {
+    uint64_t low = endpointA < endpointB ? endpointA : endpointB;
+    uint64_t high = endpointA < endpointB ? endpointB : endpointA;
+    uint64_t hash = util::mix64(util::mix64(low ^ protocol) ^ high);
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+/**
+ * Locates the IP header of a packet behind its link layer header.
+ *
+ * @param etherType set to 0x0800 for IPv4 and 0x86DD for IPv6, or another EtherType
+ * @return false if the packet has no network layer header
+ */
+bool locateNetworkHeader(const uint8_t* data, uint32_t length, uint16_t linkType,
+                         uint32_t& offset, uint16_t& etherType) {
+    switch (linkType) {
+    case 1: {
+        // Ethernet, possibly with up to two VLAN tags
+        if (length < 14) {
+            return false;
+        }
+        etherType = read16BigEndian(&data[12]);
+        offset = 14;
+        for (int tags = 0; tags < 2 && (etherType == 0x8100 || etherType == 0x88A8 ||
+                                        etherType == 0x9100);
+             ++tags) {
+            if (length < offset + 4) {
+                return false;
+            }
+            etherType = read16BigEndian(&data[offset + 2]);
+            offset += 4;
+        }
+        break;
+    }
+    case 113: {
+        // Linux cooked capture (SLL)
+        if (length < 16) {
+            return false;
+        }
+        etherType = read16BigEndian(&data[14]);
+        offset = 16;
+        break;
+    }
+    case 276: {
+        // Linux cooked capture v2 (SLL2)
+        if (length < 20) {
+            return false;
+        }
+        etherType = read16BigEndian(&data[0]);
+        offset = 20;
+        break;
+    }
+    case 0:
+    case 108: {
+        // BSD loopback, address family in host or network byte order, determine the IP
+        // version from the header itself
+        offset = 4;
+        etherType = 0;
+        break;
+    }
+    case 12:
+    case 14:
+    case 101:
+    case 228:
+    case 229: {
+        // raw IP
+        offset = 0;
+        etherType = 0;
+        break;
+    }
+    default:
+        return false;
+    }
+
+    if (length <= offset) {
+        return false;
+    }
+    if (etherType == 0) {
+        const uint8_t version = data[offset] >> 4;
+        etherType = version == 4 ? 0x0800 : version == 6 ? 0x86DD : 0;
+    }
+    return true;
+}
+
+/**
+ * Fields of the 5-tuple of an IP packet, the addresses point into the packet.
+ */
+struct FiveTuple {
+    const uint8_t* source;
+    const uint8_t* destination;
+    // 4 for IPv4, 16 for IPv6
+    size_t addressLength;
+    uint8_t protocol;
+    // false for fragments, protocols without ports and truncated transport headers
+    bool hasPorts;
+    uint16_t sourcePort;
+    uint16_t destinationPort;
+};
+
+/**
+ * @return false for non-IP and truncated IP packets
+ */
+bool parseFiveTuple(const Packet& packet, uint16_t linkType, FiveTuple& tuple) {
+    const uint8_t* data = packet.data;
+    const uint32_t length = packet.captureLength;
+    if (data == nullptr) {
+        return false;
+    }
+
+    uint32_t offset;
+    uint16_t etherType;
+    if (!locateNetworkHeader(data, length, linkType, offset, etherType)) {
+        return false;
+    }
+
+    const uint8_t* ip = &data[offset];
+    const uint32_t ipLength = length - offset;
+    uint32_t transportOffset;
+    bool fragmented;
+    if (etherType == 0x0800) {
+        if (ipLength < 20) {
+            return false;
+        }
+        transportOffset = (ip[0] & 0x0F) * 4;
+        tuple.protocol = ip[9];
+        // more fragments flag or fragment offset set
+        fragmented = (read16BigEndian(&ip[6]) & 0x3FFF) != 0;
+        tuple.source = &ip[12];
+        tuple.destination = &ip[16];
+        tuple.addressLength = 4;
+    } else if (etherType == 0x86DD) {
+        if (ipLength < 40) {
+            return false;
+        }
+        tuple.protocol = ip[6];
+        transportOffset = 40;
+        fragmented = false;
+        tuple.source = &ip[8];
+        tuple.destination = &ip[24];
+        tuple.addressLength = 16;
+        // skip hop-by-hop, routing and destination options extension headers
+        for (int headers = 0;
+             headers < 8 && (tuple.protocol == 0 || tuple.protocol == 43 ||
+                             tuple.protocol == 60 || tuple.protocol == 44);
+             ++headers) {
+            if (tuple.protocol == 44) {
+                fragmented = true;
+                break;
+            }
+            if (ipLength < transportOffset + 8) {
+                break;
+            }
+            tuple.protocol = ip[transportOffset];
+            transportOffset += (ip[transportOffset + 1] + 1) * 8;
+        }
+    } else {
+        return false;
+    }
+
+    tuple.hasPorts =
+        !fragmented && hasPorts(tuple.protocol) && ipLength >= transportOffset + 4;
+    tuple.sourcePort = 0;
+    tuple.destinationPort = 0;
+    if (tuple.hasPorts) {
+        tuple.sourcePort = read16BigEndian(&ip[transportOffset]);
+        tuple.destinationPort = read16BigEndian(&ip[transportOffset + 2]);
+    }
+    return true;
+}
+
+} // namespace
+
+bool FlowKey::operator<(const FlowKey& other) const {
+    if (lowAddress != other.lowAddress) {
+        return lowAddress < other.lowAddress;
+    }
+    if (highAddress != other.highAddress) {
+        return highAddress < other.highAddress;
+    }
+    if (lowPort != other.lowPort) {
+        return lowPort < other.lowPort;
+    }
+    if (highPort != other.highPort) {
+        return highPort < other.highPort;
+    }
+    return protocol < other.protocol;
+}
+
+size_t FlowKey::Hash::operator()(const FlowKey& key) const {
+    uint64_t hash = fold128(key.lowAddress.data());
+    hash = util::mix64(hash ^ fold128(key.highAddress.data()));
+    return util::mix64(hash ^ ((uint64_t)key.lowPort << 24 | (uint64_t)key.highPort << 8 |
+                               key.protocol));
+}
+
+PacketDispatcher::PacketDispatcher(FileReader& reader, const Config& config)
+    : mReader(reader), mConfig(config) {
+    if (mConfig.workers == 0) {
+        throw invalid_argument("PacketDispatcher requires at least one worker");
+    }
+    if (mConfig.batchSize == 0) {
+        throw invalid_argument("PacketDispatcher requires a batch size greater than 0");
+    }
+
+    mQueues.reserve(mConfig.workers);
+    for (size_t i = 0; i < mConfig.workers; ++i) {
+        auto queue = unique_ptr<WorkerQueue>(new WorkerQueue(mConfig.batchesPerWorker));
+        for (size_t j = 0; j < mConfig.batchesPerWorker; ++j) {
+            queue->batches.emplace_back(new PacketBatch(mConfig.batchSize));
+            queue->free.tryPush(queue->batches.back().get());
+        }
+        mQueues.emplace_back(std::move(queue));
+    }
+}
+
+PacketDispatcher::~PacketDispatcher() = default;
+
+void PacketDispatcher::dispatch(const BatchFunction& fn) {
+    mAborted.store(false, memory_order_relaxed);
+    for (auto& queue : mQueues) {
+        queue->finished.store(false, memory_order_relaxed);
+    }
+
+    vector<exception_ptr> workerErrors(mConfig.workers);
+    vector<thread> workers;
+    workers.reserve(mConfig.workers);
+    for (size_t i = 0; i < mConfig.workers; ++i) {
+        workers.emplace_back([this, i, &fn, &workerErrors]() {
+            try {
+                if (!mConfig.workerCpus.empty()) {
+                    pinThread(pthread_self(),
+                              mConfig.workerCpus[i % mConfig.workerCpus.size()]);
+                }
+                work(i, fn);
+            } catch (...) {
+                workerErrors[i] = current_exception();
+                mAborted.store(true, memory_order_release);
+            }
+        });
+    }
+
+    cpu_set_t previousCpuSet;
+    bool restoreAffinity = false;
+    exception_ptr readerError;
+    try {
+        if (mConfig.readerCpu >= 0) {
+            pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &previousCpuSet);
+            pinThread(pthread_self(), mConfig.readerCpu);
+            restoreAffinity = true;
+        }
+
+        vector<PacketBatch*> current(mConfig.workers, nullptr);
+        Packet packet;
+        PacketOptions options;
+        while (mReader.readNextPacket(packet)) {
+            uint32_t hash;
+            if (mConfig.useCaptureHash &&
+                PcapNgReader::readPacketOptions(packet, options) &&
+                options.hashLength > 0) {
+                hash = options.hash32();
+            } else {
+                hash = flowHash(packet, mReader.getDataLinkType(packet));
+            }
+            const size_t worker = selectWorker(hash, mConfig.workers);
+            PacketBatch*& batch = current[worker];
+            if (batch == nullptr && !acquireBatch(worker, batch)) {
+                break;
+            }
+
+            batch->packets[batch->size++] = packet;
+            if (batch->size == mConfig.batchSize) {
+                // cannot fail, the ring has room for all batches of this worker
+                mQueues[worker]->filled.tryPush(batch);
+                batch = nullptr;
+            }
+        }
+
+        // flush partially filled batches
+        for (size_t i = 0; i < mConfig.workers; ++i) {
+            if (current[i] != nullptr) {
+                mQueues[i]->filled.tryPush(current[i]);
+            }
+        }
+    } catch (...) {
+        readerError = current_exception();
+        mAborted.store(true, memory_order_release);
+    }
+
+    // signal end of stream, workers drain their rings before they terminate
+    for (auto& queue : mQueues) {
+        queue->finished.store(true, memory_order_release);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    if (restoreAffinity) {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &previousCpuSet);
+    }
+
+    if (readerError) {
+        rethrow_exception(readerError);
+    }
+    for (const auto& workerError : workerErrors) {
+        if (workerError) {
+            rethrow_exception(workerError);
+        }
+    }
+}
+
+bool PacketDispatcher::acquireBatch(size_t worker, PacketBatch*& batch) {
+    Backoff backoff;
+    while (!mQueues[worker]->free.tryPop(batch)) {
+        if (mAborted.load(memory_order_acquire)) {
+            return false;
+        }
+        backoff.pause();
+    }
+    batch->size = 0;
+    return true;
+}
+
+void PacketDispatcher::work(size_t worker, const BatchFunction& fn) {
+    WorkerQueue& queue = *mQueues[worker];
+    Backoff backoff;
+    PacketBatch* batch;
+    while (true) {
+        if (queue.filled.tryPop(batch)) {
+            backoff.reset();
+            if (!mAborted.load(memory_order_relaxed)) {
+                fn(worker, batch->packets.data(), batch->size);
+            }
+            queue.free.tryPush(batch);
+            continue;
+        }
+
+        if (queue.finished.load(memory_order_acquire)) {
+            // all batches were pushed before finished was set, drain what is left
+            while (queue.filled.tryPop(batch)) {
+                if (!mAborted.load(memory_order_relaxed)) {
+                    fn(worker, batch->packets.data(), batch->size);
+                }
+                queue.free.tryPush(batch);
+            }
+            return;
+        }
+
+        backoff.pause();
+    }
+}
+
+uint32_t PacketDispatcher::flowHash(const Packet& packet, uint16_t linkType) {
+    FiveTuple tuple;
+    if (!parseFiveTuple(packet, linkType, tuple)) {
+        return 0;
+    }
+
+    uint64_t source;
+    uint64_t destination;
+    if (tuple.addressLength == 4) {
+        source = read32BigEndian(tuple.source);
+        destination = read32BigEndian(tuple.destination);
+    } else {
+        source = fold128(tuple.source);
+        destination = fold128(tuple.destination);
+    }
+    uint64_t endpointA = source;
+    uint64_t endpointB = destination;
+    if (tuple.hasPorts) {
+        endpointA = util::mix64(source) ^ tuple.sourcePort;
+        endpointB = util::mix64(destination) ^ tuple.destinationPort;
+    }
+
+    return symmetricHash(endpointA, endpointB, tuple.protocol);
+}
+
+bool PacketDispatcher::flowKey(const Packet& packet, uint16_t linkType, FlowKey& key) {
+    FiveTuple tuple;
+    if (!parseFiveTuple(packet, linkType, tuple)) {
+        return false;
+    }
+
+    array<uint8_t, 16> source{};
+    array<uint8_t, 16> destination{};
+    if (tuple.addressLength == 4) {
+        source[10] = destination[10] = 0xFF;
+        source[11] = destination[11] = 0xFF;
+        memcpy(&source[12], tuple.source, 4);
+        memcpy(&destination[12], tuple.destination, 4);
+    } else {
+        memcpy(source.data(), tuple.source, 16);
+        memcpy(destination.data(), tuple.destination, 16);
+    }
+
+    const bool sourceFirst = source != destination
+                                 ? source < destination
+                                 : tuple.sourcePort <= tuple.destinationPort;
+    key.lowAddress = sourceFirst ? source : destination;
+    key.highAddress = sourceFirst ? destination : source;
+    key.lowPort = sourceFirst ? tuple.sourcePort : tuple.destinationPort;
+    key.highPort = sourceFirst ? tuple.destinationPort : tuple.sourcePort;
+    key.protocol = tuple.protocol;
+    return true;
+}
+
+bool PacketDispatcher::sourceAddress(const Packet& packet, uint16_t linkType,
+                                     std::array<uint8_t, 16>& address) {
+    const uint8_t* data = packet.data;
+    const uint32_t length = packet.captureLength;
+    uint32_t offset;
+    uint16_t etherType;
+    if (data == nullptr ||
+        !locateNetworkHeader(data, length, linkType, offset, etherType)) {
+        return false;
+    }
+
+    const uint8_t* ip = &data[offset];
+    const uint32_t ipLength = length - offset;
+    if (etherType == 0x0800 && ipLength >= 20) {
+        // IPv4-mapped IPv6 address ::ffff:a.b.c.d
+        address.fill(0);
+        address[10] = 0xFF;
+        address[11] = 0xFF;
+        memcpy(&address[12], &ip[12], 4);
+        return true;
+    }
+    if (etherType == 0x86DD && ipLength >= 40) {
+        memcpy(address.data(), &ip[8], 16);
+        return true;
+    }
+    return false;
+}
+
+} // namespace mmpr
@@ -0,0 +1,22 @@
+#include "mmpr/PacketHistograms.h"
+
+namespace mmpr {
+
+void PacketHistograms::startTrace() {
+    for (auto& interface : mInterfaces) {
+        interface.lastTimestamp = UINT64_MAX;
+    }
+}
+
+void PacketHistograms::merge(const PacketHistograms& other) {
+    if (other.mInterfaces.size() > mInterfaces.size()) {
+        mInterfaces.resize(other.mInterfaces.size());
+    }
+    for (size_t i = 0; i < other.mInterfaces.size(); ++i) {
+        mInterfaces[i].captureLength.merge(other.mInterfaces[i].captureLength);
+        mInterfaces[i].length.merge(other.mInterfaces[i].length);
+        mInterfaces[i].interArrival.merge(other.mInterfaces[i].interArrival);
+    }
+}
+
+} // namespace mmpr
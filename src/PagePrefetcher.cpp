@@ -0,0 +1,154 @@
+#include "mmpr/PagePrefetcher.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MADV_POPULATE_READ
+// Linux 5.14, missing from older headers
+#define MADV_POPULATE_READ 22
+#endif
+
+// time the helper thread sleeps once the window ahead of the parser is resident
+#define MMPR_PREFETCH_IDLE_MICROSECONDS 100
+
+using namespace std;
+
+namespace mmpr {
+namespace {
+
+size_t roundUpToPage(size_t value) {
+    const size_t pageSize = FileReader::getPageSize();
+    return (value + pageSize - 1) / pageSize * pageSize;
+}
+
+} // namespace
+
+PagePrefetcher::PagePrefetcher(const FileReader& reader)
+    : PagePrefetcher(reader, Config()) {}
+
+PagePrefetcher::PagePrefetcher(const FileReader& reader, const Config& config)
+    : mData(reader.getMappedMemory()),
+      mFileSize(reader.getFileSize()),
+      mConfig(config),
+      mParserOffset(reader.getCurrentOffset()) {
+    if (mData == nullptr) {
+        throw runtime_error("PagePrefetcher requires an open, memory mapped reader, "
+                            "but " +
+                            reader.getFilepath() + " is not mapped");
+    }
+    if (mConfig.window == 0 || mConfig.chunkSize == 0) {
+        throw invalid_argument("PagePrefetcher window and chunk size have to be > 0");
+    }
+    mConfig.chunkSize = roundUpToPage(mConfig.chunkSize);
+    mResidency.resize(mConfig.chunkSize / FileReader::getPageSize());
+
+    if (mConfig.method == READAHEAD) {
+        // the mapped file itself, the path may name a different file, e.g. the
+        // compressed original of a cached trace
+        const int mappedFileDescriptor = reader.getMappedFileDescriptor();
+        if (mappedFileDescriptor < 0) {
+            mConfig.method = WILLNEED;
+        } else {
+            mFileDescriptor = fcntl(mappedFileDescriptor, F_DUPFD_CLOEXEC, 0);
+            if (mFileDescriptor < 0) {
+                throw runtime_error("Error while duplicating the descriptor of " +
+                                    filesystem::absolute(reader.getFilepath()).string() +
+                                    " for prefetching: " + strerror(errno));
+            }
+        }
+    }
+
+    mThread = thread(&PagePrefetcher::run, this);
+}
+
+PagePrefetcher::~PagePrefetcher() {
+    stop();
+}
+
+void PagePrefetcher::stop() {
+    mStopped.store(true, memory_order_release);
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+    if (mFileDescriptor >= 0) {
+        ::close(mFileDescriptor);
+        mFileDescriptor = -1;
+    }
+}
+
+PrefetchStats PagePrefetcher::getStats() const {
+    PrefetchStats stats;
+    stats.bytesPrefetched = mBytesPrefetched.load(memory_order_relaxed);
+    stats.faultsAvoided = mFaultsAvoided.load(memory_order_relaxed);
+    stats.parserOvertook = mParserOvertook.load(memory_order_relaxed);
+    return stats;
+}
+
+void PagePrefetcher::run() {
+    // the mapping ends with the page containing the last byte of the file, everything
+    // beyond would fault
+    const size_t fileEnd = roundUpToPage(mFileSize);
+    const size_t pageSize = FileReader::getPageSize();
+    size_t prefetched = mParserOffset.load(memory_order_relaxed) / pageSize * pageSize;
+
+    while (prefetched < fileEnd && !mStopped.load(memory_order_acquire)) {
+        const size_t parserOffset = mParserOffset.load(memory_order_relaxed);
+        const size_t parserPage = parserOffset / pageSize * pageSize;
+        if (parserPage > prefetched) {
+            // the parser caught up, prefetching behind it is useless
+            mParserOvertook.fetch_add(1, memory_order_relaxed);
+            prefetched = parserPage;
+            continue;
+        }
+
+        const size_t target = min(fileEnd, roundUpToPage(parserOffset + mConfig.window));
+        if (prefetched >= target) {
+            this_thread::sleep_for(chrono::microseconds(MMPR_PREFETCH_IDLE_MICROSECONDS));
+            continue;
+        }
+
+        const size_t length = min(mConfig.chunkSize, target - prefetched);
+        prefetch(prefetched, length);
+        prefetched += length;
+    }
+}
+
+void PagePrefetcher::prefetch(size_t offset, size_t length) {
+    void* address = const_cast<uint8_t*>(&mData[offset]);
+
+    // pages that are not resident yet would have faulted on the parsing thread
+    uint64_t missing = 0;
+    if (mincore(address, length, mResidency.data()) == 0) {
+        for (size_t i = 0; i < length / FileReader::getPageSize(); ++i) {
+            missing += (mResidency[i] & 1) == 0;
+        }
+    }
+
+    // prefetching is best effort, errors only reduce its benefit
+    switch (mConfig.method) {
+    case POPULATE_READ:
+        if (madvise(address, length, MADV_POPULATE_READ) == 0 || errno != EINVAL) {
+            break;
+        }
+        // not supported by the running kernel
+        mConfig.method = WILLNEED;
+        [[fallthrough]];
+    case WILLNEED:
+        madvise(address, length, MADV_WILLNEED);
+        break;
+    case READAHEAD:
+        readahead(mFileDescriptor, (off64_t)offset, length);
+        break;
+    }
+
+    mBytesPrefetched.fetch_add(length, memory_order_relaxed);
+    mFaultsAvoided.fetch_add(missing, memory_order_relaxed);
+}
+
+} // namespace mmpr
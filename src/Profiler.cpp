@@ -0,0 +1,59 @@
+#include "mmpr/Profiler.h"
+
+#if MMPR_PROFILE
+
+#include <cstring>
+#include <pthread.h>
+
+namespace mmpr {
+namespace profile {
+
+namespace {
+
+const char* sectionName(int section) {
+    switch (section) {
+    case EPB_HEADER:
+        return "epb_header";
+    case TIMESTAMP:
+        return "timestamp";
+    case OPTIONS:
+        return "options";
+    case DECOMPRESSION:
+        return "decompression";
+    default:
+        return "unknown";
+    }
+}
+
+} // namespace
+
+void dump(FILE* file) {
+#if defined(__x86_64__) || defined(__i386__)
+    const char* unit = "cycles";
+#else
+    const char* unit = "ns";
+#endif
+    for (int section = 0; section < SECTION_COUNT; ++section) {
+        Histogram& histogram = threadProfile.sections[section];
+        if (histogram.count == 0) {
+            continue;
+        }
+        fprintf(file, "mmpr profile (thread %lu): %s %lu calls, %.1f %s/call\n",
+                (unsigned long)pthread_self(), sectionName(section),
+                (unsigned long)histogram.count,
+                (double)histogram.cycles / histogram.count, unit);
+        for (int bucket = 0; bucket < BUCKETS; ++bucket) {
+            if (histogram.buckets[bucket] != 0) {
+                fprintf(file, "    [%llu, %llu) %s: %lu\n", 1ull << bucket,
+                        bucket == 63 ? ~0ull : 1ull << (bucket + 1), unit,
+                        (unsigned long)histogram.buckets[bucket]);
+            }
+        }
+    }
+    memset(&threadProfile, 0, sizeof(threadProfile));
+}
+
+} // namespace profile
+} // namespace mmpr
+
+#endif
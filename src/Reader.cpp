@@ -3,39 +3,205 @@
 #include "mmpr/pcap/MMPcapReader.h"
 #include "mmpr/pcapng/MMPcapNgReader.h"
 #ifdef MMPR_USE_ZSTD
+#include "mmpr/DecompressedTraceCache.h"
 #include "mmpr/pcapng/ZstdPcapNgReader.h"
 #endif
 #include "mmpr/modified_pcap/MMModifiedPcapReader.h"
-#include "util.h"
-#include <filesystem>
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <memory>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <vector>
 
 namespace mmpr {
 
+namespace {
+
+/**
+ * Reads the magic number with a single pread(), 0 if the file is shorter.
+ */
+uint32_t readMagicNumber(int fileDescriptor) {
+    uint32_t magicNumber{0};
+    if (pread(fileDescriptor, &magicNumber, sizeof(magicNumber), 0) !=
+        sizeof(magicNumber)) {
+        return 0;
+    }
+    return magicNumber;
+}
+
+void readPageFaults(uint64_t& major, uint64_t& minor) {
+    rusage usage{};
+    if (getrusage(RUSAGE_THREAD, &usage) == 0) {
+        major = usage.ru_majflt;
+        minor = usage.ru_minflt;
+    }
+}
+
+/**
+ * Counts the resident pages of a mapping with mincore(), 0 if it fails.
+ */
+uint64_t residentBytes(const uint8_t* memory, size_t length) {
+    const size_t pageSize = FileReader::getPageSize();
+    const size_t pages = (length + pageSize - 1) / pageSize;
+    std::vector<unsigned char> residency(pages);
+    if (mincore((void*)memory, length, residency.data()) != 0) {
+        return 0;
+    }
+    uint64_t resident = 0;
+    for (unsigned char page : residency) {
+        resident += page & 1;
+    }
+    return std::min<uint64_t>(resident * pageSize, length);
+}
+
+int openOrThrow(const std::string& filepath) {
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw std::runtime_error("FileReader: could not open file \"" + filepath +
+                                 "\": " + strerror(errno));
+    }
+    return fd;
+}
+
+} // namespace
+
 FileReader::FileReader(const std::string& filepath) : mFilepath(filepath) {}
 
+FileReader::FileReader(const std::string& filepath, int fileDescriptor)
+    : mFilepath(filepath), mSourceDescriptor(fileDescriptor) {}
+
+FileReader::~FileReader() {
+    if (mSourceDescriptor >= 0) {
+        ::close(mSourceDescriptor);
+    }
+}
+
+size_t FileReader::getPageSize() {
+    static const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    return pageSize;
+}
+
+int FileReader::openFile() const {
+    if (mSourceDescriptor >= 0) {
+        return fcntl(mSourceDescriptor, F_DUPFD_CLOEXEC, 0);
+    }
+    return ::open(mFilepath.c_str(), O_RDONLY | O_CLOEXEC, 0);
+}
+
+void FileReader::setStatisticsEnabled(bool enabled) {
+    if (!enabled) {
+        mStatistics.reset();
+    } else if (!mStatistics) {
+        mStatistics = std::make_unique<ReaderStatistics>();
+        readPageFaults(mMajorPageFaultsAtOpen, mMinorPageFaultsAtOpen);
+    }
+}
+
+void FileReader::resetStatistics() {
+    if (mStatistics) {
+        *mStatistics = ReaderStatistics{};
+        readPageFaults(mMajorPageFaultsAtOpen, mMinorPageFaultsAtOpen);
+    }
+}
+
+void FileReader::recordSkippedRange(std::vector<SkippedRange>& ranges,
+                                    size_t start,
+                                    size_t end,
+                                    const std::string& reason) {
+    if (!ranges.empty() && ranges.back().offset + ranges.back().length == start) {
+        // the range continues right after a previously skipped one
+        ranges.back().length += end - start;
+    } else {
+        ranges.push_back({start, end - start, reason});
+    }
+    if (mStatistics) {
+        mStatistics->skippedBytes += end - start;
+    }
+}
+
+ReaderStatistics FileReader::getStatistics() const {
+    if (!mStatistics) {
+        return {};
+    }
+    ReaderStatistics statistics = *mStatistics;
+    uint64_t majorPageFaults = mMajorPageFaultsAtOpen;
+    uint64_t minorPageFaults = mMinorPageFaultsAtOpen;
+    readPageFaults(majorPageFaults, minorPageFaults);
+    statistics.majorPageFaults = majorPageFaults - mMajorPageFaultsAtOpen;
+    statistics.minorPageFaults = minorPageFaults - mMinorPageFaultsAtOpen;
+    if (const uint8_t* memory = getMappedMemory(); memory != nullptr) {
+        statistics.mappedBytes = getFileSize();
+        statistics.residentBytes = residentBytes(memory, getFileSize());
+    }
+    return statistics;
+}
+
 std::unique_ptr<FileReader> FileReader::getReader(const std::string& filepath) {
-    if (!std::filesystem::exists(filepath)) {
-        throw std::runtime_error("FileReader: could not find file \"" + filepath + "\"");
+    return getReader(filepath, std::shared_ptr<ZstdDecompressionPool>());
+}
+
+std::unique_ptr<FileReader>
+FileReader::getReader(const std::string& filepath,
+                      const std::shared_ptr<ZstdDecompressionPool>& pool) {
+    return getReader(openOrThrow(filepath), filepath, pool);
+}
+
+std::unique_ptr<FileReader>
+FileReader::getCachedReader(const std::string& filepath,
+                            const std::shared_ptr<DecompressedTraceCache>& cache) {
+    int fd = openOrThrow(filepath);
+#ifdef MMPR_USE_ZSTD
+    if (cache && readMagicNumber(fd) == MMPR_MAGIC_NUMBER_ZSTD) {
+        ::close(fd);
+        fd = cache->acquire(filepath);
+        if (fd < 0) {
+            // too large for the cache, decompressed by the reader
+            return std::unique_ptr<ZstdPcapNgReader>(
+                new ZstdPcapNgReader(filepath, cache->getPool()));
+        }
+        return std::unique_ptr<MMPcapNgReader>(new MMPcapNgReader(filepath, fd));
     }
+#else
+    MMPR_UNUSED(cache);
+#endif
+    return getReader(fd, filepath);
+}
 
-    uint32_t magicNumber = util::read32bitsFromFile(filepath);
+std::unique_ptr<FileReader>
+FileReader::getReader(int fileDescriptor,
+                      const std::string& filepath,
+                      const std::shared_ptr<ZstdDecompressionPool>& pool) {
+#ifndef MMPR_USE_ZSTD
+    MMPR_UNUSED(pool);
+#endif
+    uint32_t magicNumber = readMagicNumber(fileDescriptor);
     switch (magicNumber) {
     case MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS:
     case MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS:
-        return std::unique_ptr<MMPcapReader>(new MMPcapReader(filepath));
+    case MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS_SWAPPED:
+    case MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS_SWAPPED:
+        return std::unique_ptr<MMPcapReader>(new MMPcapReader(filepath, fileDescriptor));
     case MMPR_MAGIC_NUMBER_PCAPNG:
-        return std::unique_ptr<MMPcapNgReader>(new MMPcapNgReader(filepath));
+        return std::unique_ptr<MMPcapNgReader>(
+            new MMPcapNgReader(filepath, fileDescriptor));
 #ifdef MMPR_USE_ZSTD
     case MMPR_MAGIC_NUMBER_ZSTD:
-        return std::unique_ptr<ZstdPcapNgReader>(new ZstdPcapNgReader(filepath));
+        return std::unique_ptr<ZstdPcapNgReader>(
+            new ZstdPcapNgReader(filepath, fileDescriptor, pool));
 #endif
     case MMPR_MAGIC_NUMBER_MODIFIED_PCAP:
-        return std::unique_ptr<MMModifiedPcapReader>(new MMModifiedPcapReader(filepath));
+    case MMPR_MAGIC_NUMBER_MODIFIED_PCAP_SWAPPED:
+        return std::unique_ptr<MMModifiedPcapReader>(
+            new MMModifiedPcapReader(filepath, fileDescriptor));
     default:
+        ::close(fileDescriptor);
         throw std::runtime_error("Failed to determine file type based on first 32 bits");
     }
 }
 
-} // namespace mmpr
\ No newline at end of file
+} // namespace mmpr
@@ -0,0 +1,58 @@
+#include "mmpr/ReaderStatistics.h"
+
+#include "mmpr/pcapng.h"
+#include <cstdio>
+#include <sstream>
+
+namespace mmpr {
+
+std::string ReaderStatistics::blockTypeName(uint32_t blockType) {
+    switch (blockType) {
+    case MMPR_SECTION_HEADER_BLOCK:
+        return "section_header";
+    case MMPR_INTERFACE_DESCRIPTION_BLOCK:
+        return "interface_description";
+    case MMPR_PACKET_BLOCK:
+        return "packet";
+    case MMPR_SIMPLE_PACKET_BLOCK:
+        return "simple_packet";
+    case MMPR_NAME_RESOLUTION_BLOCK:
+        return "name_resolution";
+    case MMPR_INTERFACE_STATISTICS_BLOCK:
+        return "interface_statistics";
+    case MMPR_ENHANCED_PACKET_BLOCK:
+        return "enhanced_packet";
+    case MMPR_DECRYPTION_SECRETS_BLOCK:
+        return "decryption_secrets";
+    case MMPR_CUSTOM_CAN_COPY_BLOCK:
+        return "custom_can_copy";
+    case MMPR_CUSTOM_DO_NOT_COPY_BLOCK:
+        return "custom_do_not_copy";
+    default: {
+        char name[11];
+        snprintf(name, sizeof(name), "0x%08X", blockType);
+        return name;
+    }
+    }
+}
+
+std::string ReaderStatistics::toJson() const {
+    std::ostringstream json;
+    json << "{\"packets\":" << packets << ",\"captured_bytes\":" << capturedBytes
+         << ",\"bytes\":" << bytes << ",\"blocks\":{";
+    bool first = true;
+    for (const auto& [blockType, count] : blocks) {
+        json << (first ? "" : ",") << '"' << blockTypeName(blockType) << "\":" << count;
+        first = false;
+    }
+    json << "},\"skipped_bytes\":" << skippedBytes
+         << ",\"decompression_ns\":" << decompressionNanoseconds
+         << ",\"parsing_ns\":" << parsingNanoseconds
+         << ",\"major_page_faults\":" << majorPageFaults
+         << ",\"minor_page_faults\":" << minorPageFaults
+         << ",\"mapped_bytes\":" << mappedBytes
+         << ",\"resident_bytes\":" << residentBytes << '}';
+    return json.str();
+}
+
+} // namespace mmpr
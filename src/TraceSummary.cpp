@@ -0,0 +1,229 @@
+#include "mmpr/TraceSummary.h"
+
+#include "mmpr/PacketDispatcher.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+#define MMPR_TRACE_SUMMARY_MAGIC "MMPRSUM"
+// version 1 keyed flows by a 32-bit hash
+#define MMPR_TRACE_SUMMARY_VERSION 2
+
+namespace mmpr {
+namespace {
+
+void writeVarint(string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back((char)(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back((char)value);
+}
+
+uint64_t readVarint(const string& data, size_t& offset) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (offset >= data.size()) {
+            throw runtime_error("Truncated trace summary");
+        }
+        const auto byte = (uint8_t)data[offset++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw runtime_error("Invalid varint in trace summary");
+}
+
+bool isIpv4Mapped(const array<uint8_t, 16>& address) {
+    static const uint8_t IPV4_MAPPED[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    return memcmp(address.data(), IPV4_MAPPED, sizeof(IPV4_MAPPED)) == 0;
+}
+
+void writeAddress(string& out, const array<uint8_t, 16>& address, bool ipv4) {
+    const size_t offset = ipv4 ? 12 : 0;
+    out.append((const char*)address.data() + offset, address.size() - offset);
+}
+
+void readAddress(const string& data, size_t& offset, array<uint8_t, 16>& address,
+                 bool ipv4) {
+    const size_t start = ipv4 ? 12 : 0;
+    const size_t length = address.size() - start;
+    if (data.size() - offset < length) {
+        throw runtime_error("Truncated trace summary");
+    }
+    address.fill(0);
+    if (ipv4) {
+        address[10] = 0xFF;
+        address[11] = 0xFF;
+    }
+    memcpy(address.data() + start, data.data() + offset, length);
+    offset += length;
+}
+
+} // namespace
+
+void TraceSummary::add(const Packet& packet, uint16_t linkType) {
+    ++packets;
+    bytes += packet.length;
+    capturedBytes += packet.captureLength;
+    firstTimestamp = min(firstTimestamp, packet.timestamp);
+    lastTimestamp = max(lastTimestamp, packet.timestamp);
+    // bit width of the length, 0 for empty packets
+    const size_t bucket = packet.length == 0 ? 0 : 32 - __builtin_clz(packet.length);
+    ++lengthHistogram[bucket];
+
+    FlowKey key;
+    PacketDispatcher::flowKey(packet, linkType, key);
+    FlowCounters& flow = flows[key];
+    ++flow.packets;
+    flow.bytes += packet.length;
+}
+
+void TraceSummary::merge(const TraceSummary& other) {
+    packets += other.packets;
+    bytes += other.bytes;
+    capturedBytes += other.capturedBytes;
+    firstTimestamp = min(firstTimestamp, other.firstTimestamp);
+    lastTimestamp = max(lastTimestamp, other.lastTimestamp);
+    for (size_t i = 0; i < LENGTH_BUCKETS; ++i) {
+        lengthHistogram[i] += other.lengthHistogram[i];
+    }
+    for (const auto& [key, counters] : other.flows) {
+        FlowCounters& flow = flows[key];
+        flow.packets += counters.packets;
+        flow.bytes += counters.bytes;
+    }
+}
+
+string TraceSummary::serialize() const {
+    string out(MMPR_TRACE_SUMMARY_MAGIC, sizeof(MMPR_TRACE_SUMMARY_MAGIC));
+    writeVarint(out, MMPR_TRACE_SUMMARY_VERSION);
+    writeVarint(out, packets);
+    writeVarint(out, bytes);
+    writeVarint(out, capturedBytes);
+    // shifted by one so that UINT64_MAX (no packets) encodes as 0
+    writeVarint(out, firstTimestamp + 1);
+    writeVarint(out, lastTimestamp);
+    writeVarint(out, LENGTH_BUCKETS);
+    for (uint64_t count : lengthHistogram) {
+        writeVarint(out, count);
+    }
+
+    // sorted, so that equal summaries serialize alike
+    vector<const pair<const FlowKey, FlowCounters>*> sorted;
+    sorted.reserve(flows.size());
+    for (const auto& flow : flows) {
+        sorted.push_back(&flow);
+    }
+    sort(sorted.begin(), sorted.end(),
+         [](const auto* a, const auto* b) { return a->first < b->first; });
+    writeVarint(out, sorted.size());
+    for (const auto* flow : sorted) {
+        const FlowKey& key = flow->first;
+        const bool ipv4 = isIpv4Mapped(key.lowAddress) && isIpv4Mapped(key.highAddress);
+        writeVarint(out, (uint64_t)key.protocol << 1 | ipv4);
+        writeAddress(out, key.lowAddress, ipv4);
+        writeAddress(out, key.highAddress, ipv4);
+        writeVarint(out, key.lowPort);
+        writeVarint(out, key.highPort);
+        writeVarint(out, flow->second.packets);
+        writeVarint(out, flow->second.bytes);
+    }
+    return out;
+}
+
+TraceSummary TraceSummary::deserialize(const string& data) {
+    const size_t magicLength = sizeof(MMPR_TRACE_SUMMARY_MAGIC);
+    if (data.size() < magicLength ||
+        memcmp(data.data(), MMPR_TRACE_SUMMARY_MAGIC, magicLength) != 0) {
+        throw runtime_error("Not a trace summary");
+    }
+    size_t offset = magicLength;
+    const uint64_t version = readVarint(data, offset);
+    if (version != MMPR_TRACE_SUMMARY_VERSION) {
+        throw runtime_error("Unsupported trace summary version " + to_string(version));
+    }
+
+    TraceSummary summary;
+    summary.packets = readVarint(data, offset);
+    summary.bytes = readVarint(data, offset);
+    summary.capturedBytes = readVarint(data, offset);
+    summary.firstTimestamp = readVarint(data, offset) - 1;
+    summary.lastTimestamp = readVarint(data, offset);
+    if (readVarint(data, offset) != LENGTH_BUCKETS) {
+        throw runtime_error("Unexpected length histogram in trace summary");
+    }
+    for (uint64_t& count : summary.lengthHistogram) {
+        count = readVarint(data, offset);
+    }
+
+    const uint64_t flowCount = readVarint(data, offset);
+    summary.flows.reserve(min<uint64_t>(flowCount, data.size()));
+    for (uint64_t i = 0; i < flowCount; ++i) {
+        const uint64_t protocol = readVarint(data, offset);
+        FlowKey key;
+        const bool ipv4 = (protocol & 1) != 0;
+        readAddress(data, offset, key.lowAddress, ipv4);
+        readAddress(data, offset, key.highAddress, ipv4);
+        const uint64_t lowPort = readVarint(data, offset);
+        const uint64_t highPort = readVarint(data, offset);
+        if (protocol >> 1 > UINT8_MAX || lowPort > UINT16_MAX || highPort > UINT16_MAX) {
+            throw runtime_error("Invalid flow in trace summary");
+        }
+        key.protocol = (uint8_t)(protocol >> 1);
+        key.lowPort = (uint16_t)lowPort;
+        key.highPort = (uint16_t)highPort;
+        FlowCounters& flow = summary.flows[key];
+        flow.packets = readVarint(data, offset);
+        flow.bytes = readVarint(data, offset);
+    }
+    if (offset != data.size()) {
+        throw runtime_error("Trailing bytes after trace summary");
+    }
+    return summary;
+}
+
+void TraceSummary::writeFile(const string& filepath) const {
+    const string temporary = filepath + ".tmp";
+    {
+        ofstream file(temporary, ios::binary | ios::trunc);
+        const string data = serialize();
+        file.write(data.data(), (streamsize)data.size());
+        if (!file) {
+            throw runtime_error("Failed to write trace summary " + temporary);
+        }
+    }
+    if (rename(temporary.c_str(), filepath.c_str()) != 0) {
+        throw runtime_error("Failed to rename " + temporary + ": " + strerror(errno));
+    }
+}
+
+TraceSummary TraceSummary::readFile(const string& filepath) {
+    ifstream file(filepath, ios::binary);
+    if (!file) {
+        throw runtime_error("Failed to open trace summary " + filepath);
+    }
+    const string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    try {
+        return deserialize(data);
+    } catch (const runtime_error& e) {
+        throw runtime_error(filepath + ": " + e.what());
+    }
+}
+
+bool TraceSummary::operator==(const TraceSummary& other) const {
+    return packets == other.packets && bytes == other.bytes &&
+           capturedBytes == other.capturedBytes &&
+           firstTimestamp == other.firstTimestamp &&
+           lastTimestamp == other.lastTimestamp &&
+           lengthHistogram == other.lengthHistogram && flows == other.flows;
+}
+
+} // namespace mmpr
@@ -0,0 +1,56 @@
+#include "mmpr/TrafficSketches.h"
+
+#include "mmpr/PacketDispatcher.h"
+#include "util.h"
+#include <arpa/inet.h>
+#include <cstring>
+
+using namespace std;
+
+namespace mmpr {
+namespace {
+
+inline uint64_t hashAddress(const HeavyHitters::Key& address) {
+    uint64_t high;
+    uint64_t low;
+    memcpy(&high, address.data(), 8);
+    memcpy(&low, address.data() + 8, 8);
+    return util::mix64(util::mix64(high) ^ low);
+}
+
+} // namespace
+
+TrafficSketches::TrafficSketches(size_t topSources)
+    : mSourcesByBytes(topSources), mSourcesByPackets(topSources) {}
+
+void TrafficSketches::record(const Packet& packet, uint16_t linkType) {
+    HeavyHitters::Key source;
+    if (!PacketDispatcher::sourceAddress(packet, linkType, source)) {
+        return;
+    }
+    const uint64_t hash = hashAddress(source);
+    mSourcesByBytes.add(source, hash, packet.length);
+    mSourcesByPackets.add(source, hash, 1);
+    mDistinctSources.add(hash);
+    mDistinctFlows.add(util::mix64(PacketDispatcher::flowHash(packet, linkType)));
+}
+
+void TrafficSketches::merge(const TrafficSketches& other) {
+    mSourcesByBytes.merge(other.mSourcesByBytes);
+    mSourcesByPackets.merge(other.mSourcesByPackets);
+    mDistinctSources.merge(other.mDistinctSources);
+    mDistinctFlows.merge(other.mDistinctFlows);
+}
+
+string TrafficSketches::formatAddress(const HeavyHitters::Key& address) {
+    static const uint8_t IPV4_MAPPED[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xFF, 0xFF};
+    char text[INET6_ADDRSTRLEN];
+    if (memcmp(address.data(), IPV4_MAPPED, sizeof(IPV4_MAPPED)) == 0) {
+        inet_ntop(AF_INET, &address[12], text, sizeof(text));
+    } else {
+        inet_ntop(AF_INET6, address.data(), text, sizeof(text));
+    }
+    return text;
+}
+
+} // namespace mmpr
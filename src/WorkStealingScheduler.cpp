@@ -0,0 +1,123 @@
+#include "mmpr/WorkStealingScheduler.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace mmpr {
+
+WorkStealingScheduler::WorkStealingScheduler(size_t threads) : mThreads(threads) {
+    if (threads == 0) {
+        throw invalid_argument("WorkStealingScheduler needs at least one thread");
+    }
+    for (size_t i = 0; i < threads; ++i) {
+        mDeques.push_back(make_unique<TaskDeque>());
+    }
+}
+
+void WorkStealingScheduler::run(const vector<uint64_t>& weights, const TaskFunction& fn) {
+    mWeights = &weights;
+    mStolenTasks.assign(mThreads, 0);
+    mAborted = false;
+    mException = nullptr;
+
+    // heaviest first, ties keep the input order so that runs are reproducible
+    vector<size_t> order(weights.size());
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(),
+                [&weights](size_t a, size_t b) { return weights[a] > weights[b]; });
+    for (size_t i = 0; i < order.size(); ++i) {
+        TaskDeque& deque = *mDeques[i % mThreads];
+        deque.tasks.push_back(order[i]);
+        deque.weight += weights[order[i]];
+    }
+
+    // no more threads than tasks, idle threads would only steal
+    const size_t threads = max<size_t>(1, min(mThreads, weights.size()));
+    vector<thread> workers;
+    for (size_t i = 1; i < threads; ++i) {
+        workers.emplace_back([this, i, &fn] { work(i, fn); });
+    }
+    work(0, fn);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (auto& deque : mDeques) {
+        deque->tasks.clear();
+        deque->weight = 0;
+    }
+    mWeights = nullptr;
+    if (mException) {
+        rethrow_exception(mException);
+    }
+}
+
+void WorkStealingScheduler::work(size_t thread, const TaskFunction& fn) {
+    size_t task;
+    while (!mAborted && (take(thread, task) || steal(thread, task))) {
+        try {
+            fn(task, thread);
+        } catch (...) {
+            lock_guard<mutex> lock(mExceptionMutex);
+            if (!mException) {
+                mException = current_exception();
+            }
+            mAborted = true;
+        }
+    }
+}
+
+bool WorkStealingScheduler::take(size_t thread, size_t& task) {
+    TaskDeque& deque = *mDeques[thread];
+    lock_guard<mutex> lock(deque.mutex);
+    if (deque.tasks.empty()) {
+        return false;
+    }
+    task = deque.tasks.front();
+    deque.tasks.pop_front();
+    deque.weight -= (*mWeights)[task];
+    return true;
+}
+
+bool WorkStealingScheduler::steal(size_t thread, size_t& task) {
+    // tasks are never added during a run, once all deques are empty there is nothing
+    // left to steal
+    while (true) {
+        size_t victim = mThreads;
+        uint64_t victimWeight = 0;
+        bool found = false;
+        for (size_t i = 0; i < mThreads; ++i) {
+            if (i == thread) {
+                continue;
+            }
+            lock_guard<mutex> lock(mDeques[i]->mutex);
+            if (!mDeques[i]->tasks.empty() &&
+                (!found || mDeques[i]->weight > victimWeight)) {
+                victim = i;
+                victimWeight = mDeques[i]->weight;
+                found = true;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+
+        TaskDeque& deque = *mDeques[victim];
+        lock_guard<mutex> lock(deque.mutex);
+        if (deque.tasks.empty()) {
+            // the owner or another thief was faster, look again
+            continue;
+        }
+        task = deque.tasks.front();
+        deque.tasks.pop_front();
+        deque.weight -= (*mWeights)[task];
+        ++mStolenTasks[thread];
+        return true;
+    }
+}
+
+} // namespace mmpr
@@ -0,0 +1,224 @@
+#ifdef MMPR_USE_ZSTD
+
+#include "mmpr/ZstdDecompressionPool.h"
+
+#include "mmpr/Profiler.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zstd.h>
+
+// buffers are sized in multiples of a transparent huge page (2 MiB on x86-64)
+#define MMPR_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+using namespace std;
+
+namespace mmpr {
+
+ZstdDecompressionPool::~ZstdDecompressionPool() {
+    // buffers of readers that are still open are unmapped as well
+    for (const Buffer& buffer : mFreeBuffers) {
+        munmap(buffer.data, buffer.capacity);
+    }
+    for (const Buffer& buffer : mUsedBuffers) {
+        munmap(buffer.data, buffer.capacity);
+    }
+    for (void* context : mFreeContexts) {
+        ZSTD_freeDCtx(reinterpret_cast<ZSTD_DCtx*>(context));
+    }
+}
+
+const uint8_t* ZstdDecompressionPool::decompress(const std::string& filepath,
+                                                 size_t& decompressedSize) {
+    int fd = ::open(filepath.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        throw runtime_error("Error while reading file " +
+                            filesystem::absolute(filepath).string() + ": " +
+                            strerror(errno));
+    }
+    try {
+        const uint8_t* data = decompress(fd, filepath, decompressedSize);
+        ::close(fd);
+        return data;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+const uint8_t* ZstdDecompressionPool::decompress(int fd,
+                                                 const std::string& filepath,
+                                                 size_t& decompressedSize) {
+    struct stat status {};
+    if (fstat(fd, &status) != 0) {
+        throw runtime_error("Error while reading file " + filepath + ": " +
+                            strerror(errno));
+    }
+    const size_t compressedSize = status.st_size;
+
+    Buffer input = acquireBuffer(compressedSize);
+    size_t read = 0;
+    while (read < compressedSize) {
+        ssize_t result = pread(fd, &input.data[read], compressedSize - read, read);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            int error = result < 0 ? errno : EIO;
+            releaseBuffer(input);
+            throw runtime_error("Error while reading file " +
+                                filesystem::absolute(filepath).string() + ": " +
+                                strerror(error));
+        }
+        read += result;
+    }
+
+    // we require the content size in the frame header, zstd writes it by default
+    unsigned long long const contentSize =
+        ZSTD_getFrameContentSize(input.data, compressedSize);
+    if (contentSize == ZSTD_CONTENTSIZE_ERROR ||
+        contentSize == ZSTD_CONTENTSIZE_UNKNOWN) {
+        releaseBuffer(input);
+        throw runtime_error(filepath + (contentSize == ZSTD_CONTENTSIZE_ERROR
+                                            ? " is not compressed by zstd"
+                                            : " original size unknown"));
+    }
+
+    Buffer output;
+    try {
+        output = acquireBuffer(contentSize);
+    } catch (...) {
+        releaseBuffer(input);
+        throw;
+    }
+
+    void* context;
+    try {
+        context = acquireContext();
+    } catch (...) {
+        releaseBuffer(input);
+        releaseBuffer(output);
+        throw;
+    }
+    {
+        MMPR_PROFILE_SCOPE(DECOMPRESSION);
+        decompressedSize =
+            ZSTD_decompressDCtx(reinterpret_cast<ZSTD_DCtx*>(context), output.data,
+                                contentSize, input.data, compressedSize);
+    }
+    releaseContext(context);
+    releaseBuffer(input);
+
+    if (ZSTD_isError(decompressedSize) || decompressedSize != contentSize) {
+        releaseBuffer(output);
+        throw runtime_error(filepath + ": " +
+                            (ZSTD_isError(decompressedSize)
+                                 ? ZSTD_getErrorName(decompressedSize)
+                                 : "content size does not match"));
+    }
+
+    lock_guard<mutex> lock(mMutex);
+    mUsedBuffers.push_back(output);
+    ++mStats.decompressions;
+    mStats.bytesDecompressed += decompressedSize;
+    return output.data;
+}
+
+void ZstdDecompressionPool::release(const uint8_t* data) {
+    lock_guard<mutex> lock(mMutex);
+    auto it = find_if(mUsedBuffers.begin(), mUsedBuffers.end(),
+                      [data](const Buffer& buffer) { return buffer.data == data; });
+    if (it == mUsedBuffers.end()) {
+        throw invalid_argument("Buffer was not handed out by this decompression pool");
+    }
+    mFreeBuffers.push_back(*it);
+    mUsedBuffers.erase(it);
+}
+
+ZstdDecompressionPool::Stats ZstdDecompressionPool::getStats() const {
+    lock_guard<mutex> lock(mMutex);
+    return mStats;
+}
+
+ZstdDecompressionPool::Buffer ZstdDecompressionPool::acquireBuffer(size_t size) {
+    Buffer buffer;
+    {
+        lock_guard<mutex> lock(mMutex);
+        // smallest free buffer that fits, otherwise the largest one, which gets grown
+        auto best = mFreeBuffers.end();
+        for (auto it = mFreeBuffers.begin(); it != mFreeBuffers.end(); ++it) {
+            if (best == mFreeBuffers.end()) {
+                best = it;
+            } else if (it->capacity >= size) {
+                if (best->capacity < size || it->capacity < best->capacity) {
+                    best = it;
+                }
+            } else if (best->capacity < size && it->capacity > best->capacity) {
+                best = it;
+            }
+        }
+        if (best != mFreeBuffers.end()) {
+            buffer = *best;
+            mFreeBuffers.erase(best);
+        }
+        if (buffer.data != nullptr && buffer.capacity >= size) {
+            return buffer;
+        }
+        ++mStats.bufferAllocations;
+    }
+
+    // buffers only grow, the too small one is replaced by a larger mapping
+    if (buffer.data != nullptr) {
+        munmap(buffer.data, buffer.capacity);
+    }
+    buffer.capacity = (max(size, (size_t)1) + MMPR_HUGE_PAGE_SIZE - 1) /
+                      MMPR_HUGE_PAGE_SIZE * MMPR_HUGE_PAGE_SIZE;
+    void* data = mmap(nullptr, buffer.capacity, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        throw runtime_error("Unable to map " + to_string(buffer.capacity) +
+                            " bytes for decompression: " + strerror(errno));
+    }
+    // large buffers are backed by transparent huge pages if the system allows it
+    madvise(data, buffer.capacity, MADV_HUGEPAGE);
+    buffer.data = reinterpret_cast<uint8_t*>(data);
+    return buffer;
+}
+
+void ZstdDecompressionPool::releaseBuffer(const Buffer& buffer) {
+    lock_guard<mutex> lock(mMutex);
+    mFreeBuffers.push_back(buffer);
+}
+
+void* ZstdDecompressionPool::acquireContext() {
+    {
+        lock_guard<mutex> lock(mMutex);
+        if (!mFreeContexts.empty()) {
+            void* context = mFreeContexts.back();
+            mFreeContexts.pop_back();
+            return context;
+        }
+        ++mStats.contextAllocations;
+    }
+
+    ZSTD_DCtx* context = ZSTD_createDCtx();
+    if (context == nullptr) {
+        throw runtime_error("Unable to create zstd decompression context");
+    }
+    return context;
+}
+
+void ZstdDecompressionPool::releaseContext(void* context) {
+    lock_guard<mutex> lock(mMutex);
+    mFreeContexts.push_back(context);
+}
+
+} // namespace mmpr
+
+#endif
@@ -15,8 +15,11 @@ namespace mmpr {
 MMModifiedPcapReader::MMModifiedPcapReader(const string& filepath)
     : ModifiedPcapReader(filepath) {}
 
+MMModifiedPcapReader::MMModifiedPcapReader(const string& filepath, int fileDescriptor)
+    : ModifiedPcapReader(filepath, fileDescriptor) {}
+
 void MMModifiedPcapReader::open() {
-    mFileDescriptor = ::open(mFilepath.c_str(), O_RDONLY, 0);
+    mFileDescriptor = openFile();
     if (mFileDescriptor < 0) {
         throw runtime_error("Error while reading file " +
                             std::filesystem::absolute(mFilepath).string() + ": " +
@@ -24,7 +27,7 @@ void MMModifiedPcapReader::open() {
     }
 
     mFileSize = lseek(mFileDescriptor, 0, SEEK_END);
-    mMappedSize = (mFileSize / MMPR_PAGE_SIZE + 1) * MMPR_PAGE_SIZE;
+    mMappedSize = (mFileSize / getPageSize() + 1) * getPageSize();
 
     auto mmapResult =
         mmap(nullptr, mMappedSize, PROT_READ, MAP_SHARED, mFileDescriptor, 0);
@@ -36,46 +39,52 @@ void MMModifiedPcapReader::open() {
     }
 
     mOffset = 0;
+    resetStatistics();
     mMappedMemory = reinterpret_cast<const uint8_t*>(mmapResult);
 
+    // the byte order is fixed for the whole file, determine it once
+    const uint32_t magicNumber = mFileSize >= 24 ? *(const uint32_t*)mMappedMemory : 0;
+    if (magicNumber != MMPR_MAGIC_NUMBER_MODIFIED_PCAP &&
+        magicNumber != MMPR_MAGIC_NUMBER_MODIFIED_PCAP_SWAPPED) {
+        close();
+        throw runtime_error("Expected modified PCAP format to start with appropriate "
+                            "magic numbers: " +
+                            mFilepath);
+    }
+    mSwapped = magicNumber == MMPR_MAGIC_NUMBER_MODIFIED_PCAP_SWAPPED;
+
     ModifiedPcapFileHeader fileHeader{};
-    ModifiedPcapParser::readFileHeader(mMappedMemory, fileHeader);
+    if (mSwapped) {
+        ModifiedPcapParser<SwappedByteOrder>::readFileHeader(mMappedMemory, fileHeader);
+    } else {
+        ModifiedPcapParser<NativeByteOrder>::readFileHeader(mMappedMemory, fileHeader);
+    }
     mOffset += 24;
 }
 
-bool MMModifiedPcapReader::isExhausted() const {
-    return mOffset >= mFileSize;
-}
-
 bool MMModifiedPcapReader::readNextPacket(Packet& packet) {
-    if (isExhausted()) {
-        // nothing more to read
-        return false;
+    if (mSwapped) {
+        return readNextPacket<SwappedByteOrder>(packet);
     }
+    return readNextPacket<NativeByteOrder>(packet);
+}
 
-    // make sure there are enough bytes to read
-    if (mFileSize - mOffset < 24) {
-        throw runtime_error(
-            "Expected to read at least one more raw packet record (24 bytes "
-            "at least), but there are only " +
-            to_string(mFileSize - mOffset) + " bytes left in the file");
-    }
-
-    ModifiedPcapPacketRecord packetRecord{};
-    ModifiedPcapParser::readPacketRecord(&mMappedMemory[mOffset], packetRecord);
-    packet.timestampSeconds = packetRecord.timestampSeconds;
-    packet.captureLength = packetRecord.captureLength;
-    packet.length = packetRecord.length;
-    packet.data = packetRecord.data;
-
-    mOffset += 24 + packetRecord.captureLength;
-
-    return true;
+template <typename ByteOrder>
+bool MMModifiedPcapReader::readNextPacketInstrumented(Packet& packet) {
+    return readNextPacketCounted(
+        packet, [this](Packet& next) { return readPacket<ByteOrder>(next); });
 }
 
+template bool
+MMModifiedPcapReader::readNextPacketInstrumented<NativeByteOrder>(Packet& packet);
+template bool
+MMModifiedPcapReader::readNextPacketInstrumented<SwappedByteOrder>(Packet& packet);
+
 void MMModifiedPcapReader::close() {
     munmap((void*)mMappedMemory, mMappedSize);
     ::close(mFileDescriptor);
+    mMappedMemory = nullptr;
+    mMappedSize = 0;
 }
 
 } // namespace mmpr
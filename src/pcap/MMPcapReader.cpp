@@ -17,19 +17,24 @@ namespace mmpr {
 MMPcapReader::MMPcapReader(const string& filepath) : PcapReader(filepath) {
     uint32_t magicNumber = util::read32bitsFromFile(filepath);
     if (magicNumber != MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS &&
-        magicNumber != MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS) {
+        magicNumber != MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS &&
+        magicNumber != MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS_SWAPPED &&
+        magicNumber != MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS_SWAPPED) {
         stringstream sstream;
         sstream << std::hex << magicNumber;
         string hex = sstream.str();
         std::transform(hex.begin(), hex.end(), hex.begin(), ::toupper);
         throw std::runtime_error("Expected PCAP format to start with appropriate magic "
                                  "numbers, instead got: 0x" +
-                                 hex + ", possibly little/big endian issue");
+                                 hex);
     }
 }
 
+MMPcapReader::MMPcapReader(const string& filepath, int fileDescriptor)
+    : PcapReader(filepath, fileDescriptor) {}
+
 void MMPcapReader::open() {
-    mFileDescriptor = ::open(mFilepath.c_str(), O_RDONLY, 0);
+    mFileDescriptor = openFile();
     if (mFileDescriptor < 0) {
         throw runtime_error("Error while reading file " +
                             std::filesystem::absolute(mFilepath).string() + ": " +
@@ -37,7 +42,7 @@ void MMPcapReader::open() {
     }
 
     mFileSize = lseek(mFileDescriptor, 0, SEEK_END);
-    mMappedSize = (mFileSize / MMPR_PAGE_SIZE + 1) * MMPR_PAGE_SIZE;
+    mMappedSize = (mFileSize / getPageSize() + 1) * getPageSize();
 
     auto mmapResult =
         mmap(nullptr, mMappedSize, PROT_READ, MAP_SHARED, mFileDescriptor, 0);
@@ -49,50 +54,164 @@ void MMPcapReader::open() {
     }
 
     mOffset = 0;
+    mSkippedRanges.clear();
+    resetStatistics();
     mMappedMemory = reinterpret_cast<const uint8_t*>(mmapResult);
 
+    // the byte order is fixed for the whole file, determine it once
+    const uint32_t magicNumber = mFileSize >= 24 ? *(const uint32_t*)mMappedMemory : 0;
+    if (magicNumber != MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS &&
+        magicNumber != MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS &&
+        magicNumber != MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS_SWAPPED &&
+        magicNumber != MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS_SWAPPED) {
+        // readers of an opened file have not checked the magic number yet
+        close();
+        throw runtime_error("Expected PCAP format to start with appropriate magic "
+                            "numbers: " +
+                            mFilepath);
+    }
+    mSwapped = magicNumber == MMPR_MAGIC_NUMBER_PCAP_MICROSECONDS_SWAPPED ||
+               magicNumber == MMPR_MAGIC_NUMBER_PCAP_NANOSECONDS_SWAPPED;
+
     FileHeader fileHeader{};
-    PcapParser::readFileHeader(mMappedMemory, fileHeader);
+    if (mSwapped) {
+        PcapParser<SwappedByteOrder>::readFileHeader(mMappedMemory, fileHeader);
+    } else {
+        PcapParser<NativeByteOrder>::readFileHeader(mMappedMemory, fileHeader);
+    }
     mDataLinkType = fileHeader.linkType;
     mTimestampFormat = fileHeader.timestampFormat;
     mOffset += 24;
-}
 
-bool MMPcapReader::isExhausted() const {
-    return mOffset >= mFileSize;
+    mEnd = std::min(mRangeEnd, mFileSize);
+    if (mRangeBegin > mOffset && !mRangeSynchronize) {
+        mOffset = std::min(mRangeBegin, mFileSize);
+    } else if (mRangeBegin > mOffset) {
+        if (mFileSize >= 40) {
+            mFirstSeconds = mSwapped ? SwappedByteOrder::read32(&mMappedMemory[24])
+                                     : NativeByteOrder::read32(&mMappedMemory[24]);
+        }
+        mOffset = mSwapped ? findRecordChain<SwappedByteOrder>(mRangeBegin, true)
+                           : findRecordChain<NativeByteOrder>(mRangeBegin, true);
+    }
 }
 
 bool MMPcapReader::readNextPacket(Packet& packet) {
-    if (isExhausted()) {
-        // nothing more to read
-        return false;
+    if (mSwapped) {
+        return readNextPacket<SwappedByteOrder>(packet);
     }
+    return readNextPacket<NativeByteOrder>(packet);
+}
 
-    // make sure there are enough bytes to read
-    if (mFileSize - mOffset < 16) {
-        throw runtime_error("Expected to read at least one more packet record (16 bytes "
-                            "at least), but there are only " +
-                            to_string(mFileSize - mOffset) + " bytes left in the file");
+namespace {
+
+// largest packet libpcap captures (MAXIMUM_SNAPLEN)
+constexpr uint32_t MAXIMUM_PACKET_LENGTH = 262144;
+// number of plausible records that have to follow each other after a resynchronization
+constexpr int CHAINED_RECORDS = 3;
+// at the start of a range, where a false start would count packets twice
+constexpr int RANGE_CHAINED_RECORDS = 8;
+// records at the start of a range lie at most a day before and a year after the first
+// packet of the file, repeated patterns in packet data form plausible records otherwise
+constexpr uint32_t RANGE_SECONDS_BEFORE = 24 * 3600;
+constexpr uint32_t RANGE_SECONDS_AFTER = 366 * 24 * 3600;
+
+} // namespace
+
+template <typename ByteOrder>
+bool MMPcapReader::readNextPacketInstrumented(Packet& packet) {
+    if (!mStatistics) {
+        return readNextPacketRecovering<ByteOrder>(packet);
     }
+    return readNextPacketCounted(packet, [this](Packet& next) {
+        return mRecovery ? readNextPacketRecovering<ByteOrder>(next)
+                         : readPacket<ByteOrder>(next);
+    });
+}
 
-    PacketRecord packetRecord{};
-    PcapParser::readPacketRecord(&mMappedMemory[mOffset], packetRecord);
-    packet.timestampSeconds = packetRecord.timestampSeconds;
-    packet.timestampMicroseconds = mTimestampFormat == FileHeader::MICROSECONDS
-                                       ? packetRecord.timestampSubSeconds
-                                       : packetRecord.timestampSubSeconds / 1000;
-    packet.captureLength = packetRecord.captureLength;
-    packet.length = packetRecord.length;
-    packet.data = packetRecord.data;
+template <typename ByteOrder>
+bool MMPcapReader::readNextPacketRecovering(Packet& packet) {
+    while (!isExhausted()) {
+        if (plausibleRecordLength<ByteOrder>(mOffset) != 0) {
+            readPacketRecord<ByteOrder>(packet);
+            return true;
+        }
+        resynchronize<ByteOrder>(mFileSize - mOffset < 16
+                                     ? "truncated packet record header"
+                                     : "implausible packet record");
+    }
+    return false;
+}
 
-    mOffset += 16 + packetRecord.captureLength;
+template <typename ByteOrder>
+size_t MMPcapReader::plausibleRecordLength(size_t offset) const {
+    if (offset + 16 > mFileSize) {
+        return 0;
+    }
+    const uint8_t* data = &mMappedMemory[offset];
+    const uint32_t subSeconds = ByteOrder::read32(&data[4]);
+    const uint32_t captureLength = ByteOrder::read32(&data[8]);
+    const uint32_t length = ByteOrder::read32(&data[12]);
+    const uint32_t subSecondsPerSecond =
+        mTimestampFormat == FileHeader::MICROSECONDS ? 1000000 : 1000000000;
+    // records without captured bytes are legal, unlike ones of empty packets that are
+    // what runs of zero bytes look like
+    if (subSeconds >= subSecondsPerSecond || length == 0 || captureLength > length ||
+        length > MAXIMUM_PACKET_LENGTH || captureLength > mFileSize - offset - 16) {
+        return 0;
+    }
+    return 16 + (size_t)captureLength;
+}
 
-    return true;
+template <typename ByteOrder>
+size_t MMPcapReader::findRecordChain(size_t from, bool range) const {
+    const int chainLength = range ? RANGE_CHAINED_RECORDS : CHAINED_RECORDS;
+    // records have no alignment and no marker, a candidate offset is accepted once a
+    // chain of plausible records starts there
+    size_t offset = from;
+    for (; offset < mFileSize; ++offset) {
+        size_t next = offset;
+        int chained = 0;
+        while (chained < chainLength && next < mFileSize) {
+            const size_t recordLength = plausibleRecordLength<ByteOrder>(next);
+            if (recordLength == 0) {
+                break;
+            }
+            if (range) {
+                // unsigned, earlier seconds wrap around to large differences
+                const uint32_t seconds = ByteOrder::read32(&mMappedMemory[next]);
+                if (seconds - (mFirstSeconds - RANGE_SECONDS_BEFORE) >
+                    RANGE_SECONDS_BEFORE + RANGE_SECONDS_AFTER) {
+                    break;
+                }
+            }
+            next += recordLength;
+            ++chained;
+        }
+        if (chained == chainLength || (chained > 0 && next == mFileSize)) {
+            break;
+        }
+    }
+    return std::min(offset, mFileSize);
 }
 
+template <typename ByteOrder>
+void MMPcapReader::resynchronize(const std::string& reason) {
+    const size_t start = mOffset;
+    const size_t offset = findRecordChain<ByteOrder>(start + 1, false);
+
+    recordSkippedRange(mSkippedRanges, start, offset, reason);
+    mOffset = offset;
+}
+
+template bool MMPcapReader::readNextPacketInstrumented<NativeByteOrder>(Packet& packet);
+template bool MMPcapReader::readNextPacketInstrumented<SwappedByteOrder>(Packet& packet);
+
 void MMPcapReader::close() {
     munmap((void*)mMappedMemory, mMappedSize);
     ::close(mFileDescriptor);
+    mMappedMemory = nullptr;
+    mMappedSize = 0;
 }
 
 } // namespace mmpr
@@ -28,8 +28,11 @@ MMPcapNgReader::MMPcapNgReader(const string& filepath) : PcapNgReader(filepath)
     }
 }
 
+MMPcapNgReader::MMPcapNgReader(const string& filepath, int fileDescriptor)
+    : PcapNgReader(filepath, fileDescriptor) {}
+
 void MMPcapNgReader::open() {
-    mFileDescriptor = ::open(mFilepath.c_str(), O_RDONLY, 0);
+    mFileDescriptor = openFile();
     if (mFileDescriptor < 0) {
         throw runtime_error("Error while reading file " +
                             std::filesystem::absolute(mFilepath).string() + ": " +
@@ -37,7 +40,7 @@ void MMPcapNgReader::open() {
     }
 
     mFileSize = lseek(mFileDescriptor, 0, SEEK_END);
-    mMappedSize = (mFileSize / MMPR_PAGE_SIZE + 1) * MMPR_PAGE_SIZE;
+    mMappedSize = (mFileSize / getPageSize() + 1) * getPageSize();
 
     auto mmapResult =
         mmap(nullptr, mMappedSize, PROT_READ, MAP_SHARED, mFileDescriptor, 0);
@@ -49,12 +52,27 @@ void MMPcapNgReader::open() {
     }
 
     mOffset = 0;
+    resetBlockState();
+    resetStatistics();
     mData = reinterpret_cast<const uint8_t*>(mmapResult);
+
+    // readers of an opened file have not checked the magic number yet
+    if (mFileSize < 4 || *(const uint32_t*)mData != MMPR_MAGIC_NUMBER_PCAPNG) {
+        close();
+        throw runtime_error("Expected PcapNG format to start with appropriate magic "
+                            "number: " +
+                            mFilepath);
+    }
 }
 
 void MMPcapNgReader::close() {
+    // the metadata views would point into unmapped or reused memory
+    releaseTraceViews();
     munmap((void*)mData, mMappedSize);
     ::close(mFileDescriptor);
+    mData = nullptr;
+    mMappedSize = 0;
+    MMPR_PROFILE_DUMP();
 }
 
 } // namespace mmpr
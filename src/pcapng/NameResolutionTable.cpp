@@ -0,0 +1,92 @@
+#include "mmpr/pcapng/NameResolutionTable.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace std;
+
+namespace mmpr {
+
+size_t NameResolutionTable::addressLength(AddressType type) {
+    switch (type) {
+    case IPV4:
+        return 4;
+    case IPV6:
+        return 16;
+    case EUI48:
+        return 6;
+    case EUI64:
+        return 8;
+    }
+    throw invalid_argument("Unknown name resolution address type " + to_string(type));
+}
+
+void NameResolutionTable::insert(AddressType type,
+                                 const uint8_t* address,
+                                 std::string_view name) {
+    // keep the load factor at 50% at most
+    if ((mSize + 1) * 2 > mSlots.size()) {
+        grow();
+    }
+
+    Slot& slot = mSlots[findSlot(type, address)];
+    if (slot.type == 0) {
+        slot.type = type;
+        memcpy(slot.address, address, addressLength(type));
+        ++mSize;
+    }
+    slot.name = name.data();
+    slot.nameLength = name.size();
+}
+
+std::string_view NameResolutionTable::lookup(AddressType type,
+                                             const uint8_t* address) const {
+    if (mSize == 0) {
+        return {};
+    }
+    const Slot& slot = mSlots[findSlot(type, address)];
+    if (slot.type == 0) {
+        return {};
+    }
+    return {slot.name, slot.nameLength};
+}
+
+void NameResolutionTable::clear() {
+    mSlots.clear();
+    mSize = 0;
+}
+
+size_t NameResolutionTable::findSlot(AddressType type, const uint8_t* address) const {
+    const size_t length = addressLength(type);
+    uint8_t key[16]{};
+    memcpy(key, address, length);
+
+    uint64_t low;
+    uint64_t high;
+    memcpy(&low, &key[0], 8);
+    memcpy(&high, &key[8], 8);
+    uint64_t hash = (low ^ type) * 0x9E3779B97F4A7C15ULL ^ high * 0xC2B2AE3D27D4EB4FULL;
+    hash ^= hash >> 29;
+
+    const size_t mask = mSlots.size() - 1;
+    for (size_t index = hash & mask;; index = (index + 1) & mask) {
+        const Slot& slot = mSlots[index];
+        if (slot.type == 0 || (slot.type == type && memcmp(slot.address, key, 16) == 0)) {
+            return index;
+        }
+    }
+}
+
+void NameResolutionTable::grow() {
+    std::vector<Slot> slots(mSlots.empty() ? 64 : mSlots.size() * 2);
+    std::swap(slots, mSlots);
+    for (const Slot& slot : slots) {
+        if (slot.type != 0) {
+            mSlots[findSlot(static_cast<AddressType>(slot.type), slot.address)] = slot;
+        }
+    }
+}
+
+} // namespace mmpr
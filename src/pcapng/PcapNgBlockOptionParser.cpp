@@ -21,17 +21,19 @@ namespace mmpr {
  * |   Option Code == opt_endofopt |   Option Length == 0          |
  * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
-void PcapNgBlockOptionParser::readOption(const uint8_t* data,
-                                         Option& option,
-                                         size_t offset) {
-    option.type = *(const uint16_t*)&data[offset];
-    option.length = *(const uint16_t*)&data[offset + 2];
+template <typename ByteOrder>
+void PcapNgBlockOptionParser<ByteOrder>::readOption(const uint8_t* data,
+                                                    Option& option,
+                                                    size_t offset) {
+    option.type = ByteOrder::read16(&data[offset]);
+    option.length = ByteOrder::read16(&data[offset + 2]);
     option.value = &data[offset + 4];
 }
 
-void PcapNgBlockOptionParser::readSHBOption(const uint8_t* data,
-                                            Option& option,
-                                            size_t offset) {
+template <typename ByteOrder>
+void PcapNgBlockOptionParser<ByteOrder>::readSHBOption(const uint8_t* data,
+                                                       Option& option,
+                                                       size_t offset) {
     readOption(data, option, offset);
 
     switch (option.type) {
@@ -65,25 +67,23 @@ void PcapNgBlockOptionParser::readSHBOption(const uint8_t* data,
     MMPR_DEBUG_LOG("[SHB][OPT] Option Length: %u\n", option.length);
 }
 
-void PcapNgBlockOptionParser::readIDBBlockOption(const uint8_t* data,
-                                                 Option& option,
-                                                 size_t offset) {
+template <typename ByteOrder>
+void PcapNgBlockOptionParser<ByteOrder>::readIDBBlockOption(const uint8_t* data,
+                                                            Option& option,
+                                                            size_t offset) {
     readOption(data, option, offset);
 
     // TODO check if pre-defined options have the correct length, e.g., uint32_t = 4
     switch (option.type) {
     case MMPR_BLOCK_OPTION_IDB_NAME: {
         // if_name: name of the device used to capture data
-        std::string name = util::parseUTF8(option);
-        MMPR_UNUSED(name);
-        MMPR_DEBUG_LOG("[IDB][OPT] Device Name: %s\n", name.c_str());
+        MMPR_DEBUG_LOG_2("[IDB][OPT] Device Name: %.*s\n", option.length, option.value);
         return;
     }
     case MMPR_BLOCK_OPTION_IDB_DESCRIPTION: {
         // if_description: description of the device used to capture data
-        std::string description = util::parseUTF8(option);
-        MMPR_UNUSED(description);
-        MMPR_DEBUG_LOG("[IDB][OPT] Device Description: %s\n", description.c_str());
+        MMPR_DEBUG_LOG_2("[IDB][OPT] Device Description: %.*s\n", option.length,
+                         option.value);
         return;
     }
     case 4: {
@@ -108,7 +108,7 @@ void PcapNgBlockOptionParser::readIDBBlockOption(const uint8_t* data,
     }
     case 8: {
         // if_speed: interface speed, in bits per second
-        const uint64_t speed = *(const uint64_t*)option.value;
+        const uint64_t speed = ByteOrder::read64(option.value);
         MMPR_UNUSED(speed);
         MMPR_DEBUG_LOG("[IDB][OPT] Interface Speed: %lu bits/s\n", speed);
         return;
@@ -142,18 +142,14 @@ void PcapNgBlockOptionParser::readIDBBlockOption(const uint8_t* data,
          * this is a libpcap string, or BPF bytecode, and more).
          */
         // skip first octet (filter code), interpret rest as string, cf. util::fromUTF8()
-        std::string filter = std::string(reinterpret_cast<const char*>(&option.value[1]),
-                                         option.length - 1);
-        MMPR_UNUSED(filter);
-        MMPR_DEBUG_LOG("[IDB][OPT] Filter: %s\n", filter.c_str());
+        MMPR_DEBUG_LOG_2("[IDB][OPT] Filter: %.*s\n", option.length - 1,
+                         &option.value[1]);
         return;
     }
     case MMPR_BLOCK_OPTION_IDB_OS: {
         // if_os: name of the operating system of the machine in which this interface is
         // installed
-        std::string os = util::parseUTF8(option);
-        MMPR_UNUSED(os);
-        MMPR_DEBUG_LOG("[IDB][OPT] OS: %s\n", os.c_str());
+        MMPR_DEBUG_LOG_2("[IDB][OPT] OS: %.*s\n", option.length, option.value);
         return;
     }
     case 13: {
@@ -163,10 +159,10 @@ void PcapNgBlockOptionParser::readIDBBlockOption(const uint8_t* data,
         MMPR_DEBUG_LOG("[IDB][OPT] Frame Check Sequence: 0x%01X\n", fcslen);
         return;
     }
-    case 14: {
+    case MMPR_BLOCK_OPTION_IDB_TSOFFSET: {
         // if_tsoffset: offset (in seconds) that must be added to the timestamp of
         // each packet to obtain the absolute timestamp of a packet
-        const int64_t tsoffset = *(const int64_t*)option.value;
+        const int64_t tsoffset = (int64_t)ByteOrder::read64(option.value);
         MMPR_UNUSED(tsoffset);
         MMPR_DEBUG_LOG("[IDB][OPT] Timestamp Offset: %li\n", tsoffset);
         return;
@@ -179,14 +175,14 @@ void PcapNgBlockOptionParser::readIDBBlockOption(const uint8_t* data,
     }
     case 16: {
         // if_txspeed: interface transmit speed in bits per second
-        const uint64_t txspeed = *(const uint64_t*)option.value;
+        const uint64_t txspeed = ByteOrder::read64(option.value);
         MMPR_UNUSED(txspeed);
         MMPR_DEBUG_LOG("[IDB][OPT] Transmit Speed: %lu bits/s\n", txspeed);
         return;
     }
     case 17: {
         // if_rxspeed: interface receive speed, in bits per second
-        const uint64_t rxspeed = *(const uint64_t*)option.value;
+        const uint64_t rxspeed = ByteOrder::read64(option.value);
         MMPR_UNUSED(rxspeed);
         MMPR_DEBUG_LOG("[IDB][OPT] Receive Speed: %lu bits/s\n", rxspeed);
         return;
@@ -200,23 +196,23 @@ void PcapNgBlockOptionParser::readIDBBlockOption(const uint8_t* data,
     MMPR_DEBUG_LOG("[IDB][OPT] Option Length: %u\n", option.length);
 }
 
-void PcapNgBlockOptionParser::readEPBOption(const uint8_t* data,
-                                            Option& option,
-                                            size_t offset) {
+template <typename ByteOrder>
+void PcapNgBlockOptionParser<ByteOrder>::readEPBOption(const uint8_t* data,
+                                                       Option& option,
+                                                       size_t offset) {
     readOption(data, option, offset);
 
     // TODO check if pre-defined options have the correct length, e.g., uint32_t = 4
     switch (option.type) {
     case 2: {
         // epb_flags: 32-bit flags word containing link-layer information
-        uint32_t flags = *(const uint32_t*)option.value;
+        uint32_t flags = ByteOrder::read32(option.value);
         MMPR_UNUSED(flags);
-        MMPR_DEBUG_LOG("[IDB][OPT] Frame Check Sequence: 0x%04X\n", flags);
+        MMPR_DEBUG_LOG("[EPB][OPT] Flags: 0x%08X\n", flags);
         return;
     }
     case 3: {
-        // epb_hash: hash of the packet
-        // TODO parse epb_hash
+        // epb_hash: hash of the packet, decoded on demand by readEPBOptions
         break;
     }
     case 4: {
@@ -225,14 +221,14 @@ void PcapNgBlockOptionParser::readEPBOption(const uint8_t* data,
         //                between this packet and the preceding one for the same interface
         //                or, for the first packet for an interface, between this packet
         //                and the start of the capture process
-        uint64_t dropCount = *(const uint64_t*)option.value;
+        uint64_t dropCount = ByteOrder::read64(option.value);
         MMPR_UNUSED(dropCount);
         MMPR_DEBUG_LOG("[EPB][OPT] Drop Count: %lu packets\n", dropCount);
         return;
     }
     case 5: {
         // epb_packetid: 64-bit unsigned integer that uniquely identifies the packet
-        uint64_t packetId = *(const uint64_t*)option.value;
+        uint64_t packetId = ByteOrder::read64(option.value);
         MMPR_UNUSED(packetId);
         MMPR_DEBUG_LOG("[EPB][OPT] Packet ID: %lu\n", packetId);
         return;
@@ -241,7 +237,7 @@ void PcapNgBlockOptionParser::readEPBOption(const uint8_t* data,
         // epb_queue: 32-bit unsigned integer that identifies on which queue of the
         // interface
         //            the specific packet was received
-        uint32_t queue = *(const uint32_t*)option.value;
+        uint32_t queue = ByteOrder::read32(option.value);
         MMPR_UNUSED(queue);
         MMPR_DEBUG_LOG("[EPB][OPT] Queue: %u\n", queue);
         return;
@@ -262,27 +258,26 @@ void PcapNgBlockOptionParser::readEPBOption(const uint8_t* data,
     MMPR_DEBUG_LOG("[EPB][OPT] Option Length: %u\n", option.length);
 }
 
-void PcapNgBlockOptionParser::readISBOption(const uint8_t* data,
-                                            Option& option,
-                                            size_t offset) {
+template <typename ByteOrder>
+void PcapNgBlockOptionParser<ByteOrder>::readISBOption(const uint8_t* data,
+                                                       Option& option,
+                                                       size_t offset) {
     readOption(data, option, offset);
 
     // TODO check if pre-defined options have the correct length, e.g., uint32_t = 4
     switch (option.type) {
     case 2: {
-        // isb_starttime: time the capture started
-        // TODO parse isb_starttime timestamp
+        // isb_starttime: time the capture started, stored in the block by readISB
         break;
     }
     case 3: {
-        // isb_endtime: time the capture ended
-        // TODO parse isb_starttime timestamp
+        // isb_endtime: time the capture ended, stored in the block by readISB
         break;
     }
     case 4: {
         // isb_ifrecv: number of packets received from the physical interface
         //             starting from the beginning of the capture
-        uint64_t ifrecv = *(const uint64_t*)option.value;
+        uint64_t ifrecv = ByteOrder::read64(option.value);
         MMPR_UNUSED(ifrecv);
         MMPR_DEBUG_LOG("[ISB][OPT] Received Packets: %lu", ifrecv);
         return;
@@ -290,7 +285,7 @@ void PcapNgBlockOptionParser::readISBOption(const uint8_t* data,
     case 5: {
         // isb_ifdrop: number of packets dropped by the interface due to lack of
         //             resources starting from the beginning of the capture
-        uint64_t ifdrop = *(const uint64_t*)option.value;
+        uint64_t ifdrop = ByteOrder::read64(option.value);
         MMPR_UNUSED(ifdrop);
         MMPR_DEBUG_LOG("[ISB][OPT] Dropped Packets (Interface): %lu", ifdrop);
         return;
@@ -298,7 +293,7 @@ void PcapNgBlockOptionParser::readISBOption(const uint8_t* data,
     case 6: {
         // isb_filteraccept: number of packets accepted by filter starting from
         //                   the beginning of the capture
-        uint64_t filteraccept = *(const uint64_t*)option.value;
+        uint64_t filteraccept = ByteOrder::read64(option.value);
         MMPR_UNUSED(filteraccept);
         MMPR_DEBUG_LOG("[ISB][OPT] Filtered Packets: %lu", filteraccept);
         return;
@@ -306,7 +301,7 @@ void PcapNgBlockOptionParser::readISBOption(const uint8_t* data,
     case 7: {
         // isb_osdrop: number of packets dropped by the operating system starting
         //             from the beginning of the capture
-        uint64_t osdrop = *(const uint64_t*)option.value;
+        uint64_t osdrop = ByteOrder::read64(option.value);
         MMPR_UNUSED(osdrop);
         MMPR_DEBUG_LOG("[ISB][OPT] Dropped Packets (OS): %lu", osdrop);
         return;
@@ -314,7 +309,7 @@ void PcapNgBlockOptionParser::readISBOption(const uint8_t* data,
     case 8: {
         // isb_usrdeliv: number of packets delivered to the user starting from the
         //               beginning of the capture
-        uint64_t usrdeliv = *(const uint64_t*)option.value;
+        uint64_t usrdeliv = ByteOrder::read64(option.value);
         MMPR_UNUSED(usrdeliv);
         MMPR_DEBUG_LOG("[ISB][OPT] Packets Delivered to User: %lu", usrdeliv);
         return;
@@ -327,4 +322,7 @@ void PcapNgBlockOptionParser::readISBOption(const uint8_t* data,
     MMPR_DEBUG_LOG("[ISB][OPT] Option Code/Type: %u\n", option.type);
     MMPR_DEBUG_LOG("[ISB][OPT] Option Length: %u\n", option.length);
 }
+
+template class PcapNgBlockOptionParser<NativeByteOrder>;
+template class PcapNgBlockOptionParser<SwappedByteOrder>;
 } // namespace mmpr
@@ -3,6 +3,8 @@
 #include "mmpr/mmpr.h"
 #include "mmpr/pcapng/PcapNgBlockOptionParser.h"
 #include "util.h"
+#include <cstring>
+#include <string_view>
 
 namespace mmpr {
 /**
@@ -30,23 +32,24 @@ namespace mmpr {
  *    |                      Block Total Length                       |
  *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
-void PcapNgBlockParser::readSHB(const uint8_t* data, SectionHeaderBlock& shb) {
-    auto blockType = *(const uint32_t*)&data[0];
+template <typename ByteOrder>
+void PcapNgBlockParser<ByteOrder>::readSHB(const uint8_t* data, SectionHeaderBlock& shb) {
+    auto blockType = ByteOrder::read32(&data[0]);
     MMPR_ASSERT(blockType == MMPR_SECTION_HEADER_BLOCK);
 
-    shb.blockTotalLength = *(const uint32_t*)&data[4];
+    shb.blockTotalLength = ByteOrder::read32(&data[4]);
 
-    auto byteOrderMagic = *(const uint32_t*)&data[8];
-    MMPR_ASSERT(byteOrderMagic == 0x1A2B3C4D);
+    auto byteOrderMagic = ByteOrder::read32(&data[8]);
+    MMPR_ASSERT(byteOrderMagic == MMPR_BYTE_ORDER_MAGIC);
 
-    shb.majorVersion = *(const uint16_t*)&data[12];
-    shb.minorVersion = *(const uint16_t*)&data[14];
+    shb.majorVersion = ByteOrder::read16(&data[12]);
+    shb.minorVersion = ByteOrder::read16(&data[14]);
 
     // TODO: Also, special care should be taken in accessing this
     //      field: since the alignment of all the blocks in the file is
     //      32-bits, this field is not guaranteed to be aligned to a 64-bit
     //      boundary.  This could be a problem on 64-bit processors.
-    shb.sectionLength = *(const int64_t*)&data[16];
+    shb.sectionLength = (int64_t)ByteOrder::read64(&data[16]);
     MMPR_ASSERT(shb.sectionLength != -1 ? shb.sectionLength % 4 == 0 : true);
 
     MMPR_DEBUG_LOG("--- [Section Header Block %p] ---\n", (void*)data);
@@ -57,32 +60,32 @@ void PcapNgBlockParser::readSHB(const uint8_t* data, SectionHeaderBlock& shb) {
 
     // standard Section Header Block has size 28 (without any options)
     if (shb.blockTotalLength > 28) {
+        MMPR_PROFILE_SCOPE(OPTIONS);
         uint32_t totalOptionsLength = shb.blockTotalLength - 28;
         uint32_t readOptionsLength = 0;
         while (readOptionsLength < totalOptionsLength) {
             Option option{};
-            PcapNgBlockOptionParser::readSHBOption(data, option, 24 + readOptionsLength);
+            OptionParser::readSHBOption(data, option, 24 + readOptionsLength);
             readOptionsLength += option.totalLength();
             switch (option.type) {
             case MMPR_BLOCK_OPTION_COMMENT:
-                shb.options.comment = std::string((char*)option.value, option.length);
+                shb.options.comment = util::parseUTF8(option);
                 break;
             case MMPR_BLOCK_OPTION_SHB_OS:
-                shb.options.os = std::string((char*)option.value, option.length);
+                shb.options.os = util::parseUTF8(option);
                 break;
             case MMPR_BLOCK_OPTION_SHB_HARDWARE:
-                shb.options.hardware = std::string((char*)option.value, option.length);
+                shb.options.hardware = util::parseUTF8(option);
                 break;
             case MMPR_BLOCK_OPTION_SHB_USERAPPL:
-                shb.options.userApplication =
-                    std::string((char*)option.value, option.length);
+                shb.options.userApplication = util::parseUTF8(option);
                 break;
             }
         }
     }
 
     // make sure that the block actually ends with block total length
-    auto blockTotalLength = *(const uint32_t*)&data[shb.blockTotalLength - 4];
+    auto blockTotalLength = ByteOrder::read32(&data[shb.blockTotalLength - 4]);
     MMPR_ASSERT(shb.blockTotalLength == blockTotalLength);
 }
 
@@ -107,13 +110,15 @@ void PcapNgBlockParser::readSHB(const uint8_t* data, SectionHeaderBlock& shb) {
  *    |                      Block Total Length                       |
  *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
-void PcapNgBlockParser::readIDB(const uint8_t* data, InterfaceDescriptionBlock& idb) {
-    auto blockType = *(const uint32_t*)&data[0];
+template <typename ByteOrder>
+void PcapNgBlockParser<ByteOrder>::readIDB(const uint8_t* data,
+                                           InterfaceDescriptionBlock& idb) {
+    auto blockType = ByteOrder::read32(&data[0]);
     MMPR_ASSERT(blockType == MMPR_INTERFACE_DESCRIPTION_BLOCK);
 
-    idb.blockTotalLength = *(const uint32_t*)&data[4];
-    idb.linkType = *(const uint16_t*)&data[8];
-    idb.snapLen = *(const uint32_t*)&data[12];
+    idb.blockTotalLength = ByteOrder::read32(&data[4]);
+    idb.linkType = ByteOrder::read16(&data[8]);
+    idb.snapLen = ByteOrder::read32(&data[12]);
 
     MMPR_DEBUG_LOG("--- [Interface Description Block %p] ---\n", (void*)data);
     MMPR_DEBUG_LOG("[IDB] Block Total Length: %u\n", idb.blockTotalLength);
@@ -122,18 +127,23 @@ void PcapNgBlockParser::readIDB(const uint8_t* data, InterfaceDescriptionBlock&
 
     // standard Interface Description Block has size 20 (without any options)
     if (idb.blockTotalLength > 20) {
+        MMPR_PROFILE_SCOPE(OPTIONS);
         uint32_t totalOptionsLength = idb.blockTotalLength - 20;
         uint32_t readOptionsLength = 0;
         while (readOptionsLength < totalOptionsLength) {
             Option option{};
-            PcapNgBlockOptionParser::readIDBBlockOption(data, option,
-                                                        16 + readOptionsLength);
+            OptionParser::readIDBBlockOption(data, option, 16 + readOptionsLength);
             readOptionsLength += option.totalLength();
             switch (option.type) {
             case MMPR_BLOCK_OPTION_IDB_TSRESOL:
                 MMPR_ASSERT(option.length == 1);
+                idb.options.tsresol = *option.value;
                 idb.options.timestampResolution = util::fromIfTsresolUInt(*option.value);
                 break;
+            case MMPR_BLOCK_OPTION_IDB_TSOFFSET:
+                MMPR_ASSERT(option.length == 8);
+                idb.options.tsoffset = (int64_t)ByteOrder::read64(option.value);
+                break;
             case MMPR_BLOCK_OPTION_IDB_NAME:
                 idb.options.name = util::parseUTF8(option);
                 break;
@@ -142,7 +152,7 @@ void PcapNgBlockParser::readIDB(const uint8_t* data, InterfaceDescriptionBlock&
                 break;
             case MMPR_BLOCK_OPTION_IDB_FILTER:
                 // skip first octet (filter code), interpret rest as string
-                idb.options.filter = std::string(
+                idb.options.filter = std::string_view(
                     reinterpret_cast<const char*>(&option.value[1]), option.length - 1);
                 break;
             case MMPR_BLOCK_OPTION_IDB_OS:
@@ -153,84 +163,10 @@ void PcapNgBlockParser::readIDB(const uint8_t* data, InterfaceDescriptionBlock&
     }
 
     // make sure that the block actually ends with block total length
-    auto blockTotalLength = *(const uint32_t*)&data[idb.blockTotalLength - 4];
+    auto blockTotalLength = ByteOrder::read32(&data[idb.blockTotalLength - 4]);
     MMPR_ASSERT(idb.blockTotalLength == blockTotalLength);
 }
 
-/**
- * 4.3.  Enhanced Packet Block
- *
- *                         1                   2                   3
- *     0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- *  0 |                    Block Type = 0x00000006                    |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- *  4 |                      Block Total Length                       |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- *  8 |                         Interface ID                          |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- * 12 |                        Timestamp (High)                       |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- * 16 |                        Timestamp (Low)                        |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- * 20 |                    Captured Packet Length                     |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- * 24 |                    Original Packet Length                     |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- * 28 /                                                               /
- *    /                          Packet Data                          /
- *    /              variable length, padded to 32 bits               /
- *    /                                                               /
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- *    /                                                               /
- *    /                      Options (variable)                       /
- *    /                                                               /
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- *    |                      Block Total Length                       |
- *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
- */
-void PcapNgBlockParser::readEPB(const uint8_t* data, EnhancedPacketBlock& epb) {
-    auto blockType = *(const uint32_t*)&data[0];
-    MMPR_ASSERT(blockType == MMPR_ENHANCED_PACKET_BLOCK);
-
-    epb.blockTotalLength = *(const uint32_t*)&data[4];
-    epb.interfaceId = *(const uint32_t*)&data[8];
-    epb.timestampHigh = *(const uint32_t*)&data[12];
-    epb.timestampLow = *(const uint32_t*)&data[16];
-    epb.capturePacketLength = *(const uint32_t*)&data[20];
-    epb.originalPacketLength = *(const uint32_t*)&data[24];
-    epb.packetData = &data[28];
-
-    MMPR_DEBUG_LOG("--- [Enhanced Packet Block @%p] ---\n", (void*)data);
-    MMPR_DEBUG_LOG("[EPB] Block Total Length: %u\n", epb.blockTotalLength);
-    MMPR_DEBUG_LOG("[EPB] Interface ID: 0x%08X\n", epb.interfaceId);
-    MMPR_DEBUG_LOG("[EPB] Timestamp (High): %u\n", epb.timestampHigh);
-    MMPR_DEBUG_LOG("[EPB] Timestamp (Low): %u\n", epb.timestampLow);
-    MMPR_DEBUG_LOG("[EPB] Captured Packet Length: %u\n", epb.capturePacketLength);
-    MMPR_DEBUG_LOG("[EPB] Original Packet Length: %u\n", epb.originalPacketLength);
-    MMPR_DEBUG_LOG("[EPB] Packet Data: %p\n", (void*)epb.packetData);
-
-    // packet data is padded to 32 bits, calculate the total size in memory (including
-    // padding)
-    auto packetDataTotalLength =
-        epb.capturePacketLength + (4 - epb.capturePacketLength % 4) % 4;
-    // standard Enhanced Packet Block has size 32 (without packet data or options)
-    if (epb.blockTotalLength - 32 > packetDataTotalLength) {
-        uint32_t totalOptionsLength = epb.blockTotalLength - 32 - packetDataTotalLength;
-        uint32_t readOptionsLength = 0;
-        while (readOptionsLength < totalOptionsLength) {
-            Option option{};
-            PcapNgBlockOptionParser::readEPBOption(
-                data, option, 32 + packetDataTotalLength + readOptionsLength);
-            readOptionsLength += option.totalLength();
-        }
-    }
-
-    // make sure that the block actually ends with block total length
-    auto blockTotalLength = *(const uint32_t*)&data[epb.blockTotalLength - 4];
-    MMPR_ASSERT(epb.blockTotalLength == blockTotalLength);
-}
-
 /**
  * Appendix A.  Packet Block (obsolete)
  *
@@ -263,17 +199,18 @@ void PcapNgBlockParser::readEPB(const uint8_t* data, EnhancedPacketBlock& epb) {
  *    |                      Block Total Length                       |
  *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
-void PcapNgBlockParser::readPB(const uint8_t* data, PacketBlock& pb) {
-    auto blockType = *(const uint32_t*)&data[0];
+template <typename ByteOrder>
+void PcapNgBlockParser<ByteOrder>::readPB(const uint8_t* data, PacketBlock& pb) {
+    auto blockType = ByteOrder::read32(&data[0]);
     MMPR_ASSERT(blockType == MMPR_PACKET_BLOCK);
 
-    pb.blockTotalLength = *(const uint32_t*)&data[4];
-    pb.interfaceId = *(const uint16_t*)&data[8];
-    pb.dropsCount = *(const uint16_t*)&data[10];
-    pb.timestampHigh = *(const uint32_t*)&data[12];
-    pb.timestampLow = *(const uint32_t*)&data[16];
-    pb.capturePacketLength = *(const uint32_t*)&data[20];
-    pb.originalPacketLength = *(const uint32_t*)&data[24];
+    pb.blockTotalLength = ByteOrder::read32(&data[4]);
+    pb.interfaceId = ByteOrder::read16(&data[8]);
+    pb.dropsCount = ByteOrder::read16(&data[10]);
+    pb.timestampHigh = ByteOrder::read32(&data[12]);
+    pb.timestampLow = ByteOrder::read32(&data[16]);
+    pb.capturePacketLength = ByteOrder::read32(&data[20]);
+    pb.originalPacketLength = ByteOrder::read32(&data[24]);
     pb.packetData = &data[28];
 
     MMPR_DEBUG_LOG("--- [Packet Block @%p] ---\n", (void*)data);
@@ -292,18 +229,19 @@ void PcapNgBlockParser::readPB(const uint8_t* data, PacketBlock& pb) {
         pb.capturePacketLength + (4 - pb.capturePacketLength % 4) % 4;
     // standard Enhanced Packet Block has size 32 (without packet data or options)
     if (pb.blockTotalLength - 32 > packetDataTotalLength) {
+        MMPR_PROFILE_SCOPE(OPTIONS);
         uint32_t totalOptionsLength = pb.blockTotalLength - 32 - packetDataTotalLength;
         uint32_t readOptionsLength = 0;
         while (readOptionsLength < totalOptionsLength) {
             Option option{};
-            PcapNgBlockOptionParser::readEPBOption(
-                data, option, 32 + packetDataTotalLength + readOptionsLength);
+            OptionParser::readEPBOption(data, option,
+                                       32 + packetDataTotalLength + readOptionsLength);
             readOptionsLength += option.totalLength();
         }
     }
 
     // make sure that the block actually ends with block total length
-    auto blockTotalLength = *(const uint32_t*)&data[pb.blockTotalLength - 4];
+    auto blockTotalLength = ByteOrder::read32(&data[pb.blockTotalLength - 4]);
     MMPR_ASSERT(pb.blockTotalLength == blockTotalLength);
 }
 
@@ -330,14 +268,16 @@ void PcapNgBlockParser::readPB(const uint8_t* data, PacketBlock& pb) {
  *    |                      Block Total Length                       |
  *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
-void PcapNgBlockParser::readISB(const uint8_t* data, InterfaceStatisticsBlock& isb) {
-    auto blockType = *(const uint32_t*)&data[0];
+template <typename ByteOrder>
+void PcapNgBlockParser<ByteOrder>::readISB(const uint8_t* data,
+                                           InterfaceStatisticsBlock& isb) {
+    auto blockType = ByteOrder::read32(&data[0]);
     MMPR_ASSERT(blockType == MMPR_INTERFACE_STATISTICS_BLOCK);
 
-    isb.blockTotalLength = *(const uint32_t*)&data[4];
-    isb.interfaceId = *(const uint32_t*)&data[8];
-    isb.timestampHigh = *(const uint32_t*)&data[12];
-    isb.timestampLow = *(const uint32_t*)&data[16];
+    isb.blockTotalLength = ByteOrder::read32(&data[4]);
+    isb.interfaceId = ByteOrder::read32(&data[8]);
+    isb.timestampHigh = ByteOrder::read32(&data[12]);
+    isb.timestampLow = ByteOrder::read32(&data[16]);
 
     MMPR_DEBUG_LOG("--- [Interface Statistics Block @%p] ---\n", (void*)data);
     MMPR_DEBUG_LOG("[ISB] Block Type: 0x%08X\n", blockType);
@@ -347,18 +287,202 @@ void PcapNgBlockParser::readISB(const uint8_t* data, InterfaceStatisticsBlock& i
     MMPR_DEBUG_LOG("[ISB] Timestamp (Low): %u\n", isb.timestampLow);
 
     // standard Interface Statistics Block has size 24 (without any options)
-    if (isb.blockTotalLength > 20) {
-        uint32_t totalOptionsLength = isb.blockTotalLength - 20;
+    if (isb.blockTotalLength > 24) {
+        MMPR_PROFILE_SCOPE(OPTIONS);
+        uint32_t totalOptionsLength = isb.blockTotalLength - 24;
         uint32_t readOptionsLength = 0;
         while (readOptionsLength < totalOptionsLength) {
             Option option{};
-            PcapNgBlockOptionParser::readISBOption(data, option, 16 + readOptionsLength);
+            OptionParser::readISBOption(data, option, 20 + readOptionsLength);
             readOptionsLength += option.totalLength();
+            if (option.length != 8) {
+                // all statistics options are 64 bit values, comments are not stored
+                continue;
+            }
+            switch (option.type) {
+            case MMPR_BLOCK_OPTION_ISB_STARTTIME:
+                isb.options.startTime = (uint64_t)ByteOrder::read32(option.value) << 32 |
+                                        ByteOrder::read32(&option.value[4]);
+                break;
+            case MMPR_BLOCK_OPTION_ISB_ENDTIME:
+                isb.options.endTime = (uint64_t)ByteOrder::read32(option.value) << 32 |
+                                      ByteOrder::read32(&option.value[4]);
+                break;
+            case MMPR_BLOCK_OPTION_ISB_IFRECV:
+                isb.options.ifRecv = ByteOrder::read64(option.value);
+                break;
+            case MMPR_BLOCK_OPTION_ISB_IFDROP:
+                isb.options.ifDrop = ByteOrder::read64(option.value);
+                break;
+            case MMPR_BLOCK_OPTION_ISB_FILTERACCEPT:
+                isb.options.filterAccept = ByteOrder::read64(option.value);
+                break;
+            case MMPR_BLOCK_OPTION_ISB_OSDROP:
+                isb.options.osDrop = ByteOrder::read64(option.value);
+                break;
+            case MMPR_BLOCK_OPTION_ISB_USRDELIV:
+                isb.options.usrDeliv = ByteOrder::read64(option.value);
+                break;
+            }
         }
     }
 
     // make sure that the block actually ends with block total length
-    auto blockTotalLength = *(const uint32_t*)&data[isb.blockTotalLength - 4];
+    auto blockTotalLength = ByteOrder::read32(&data[isb.blockTotalLength - 4]);
     MMPR_ASSERT(isb.blockTotalLength == blockTotalLength);
 }
+
+/**
+ * 4.5.  Name Resolution Block
+ *
+ *                         1                   2                   3
+ *     0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  0 |                    Block Type = 0x00000004                    |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  4 |                      Block Total Length                       |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  8 |      Record Type              |      Record Value Length      |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * 12 /                       Record Value                            /
+ *    /              variable length, padded to 32 bits               /
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *    .                                                               .
+ *    .                  . . . other records . . .                    .
+ *    .                                                               .
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *    |  Record Type = nrb_record_end |   Record Value Length = 0     |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *    /                                                               /
+ *    /                      Options (variable)                       /
+ *    /                                                               /
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *    |                      Block Total Length                       |
+ *    +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * The value of an address record is the address followed by one or more zero terminated
+ * names.
+ */
+template <typename ByteOrder>
+void PcapNgBlockParser<ByteOrder>::readNRB(const uint8_t* data,
+                                           NameResolutionTable& table) {
+    auto blockType = ByteOrder::read32(&data[0]);
+    MMPR_ASSERT(blockType == MMPR_NAME_RESOLUTION_BLOCK);
+    const uint32_t blockTotalLength = ByteOrder::read32(&data[4]);
+
+    MMPR_DEBUG_LOG("--- [Name Resolution Block @%p] ---\n", (void*)data);
+    MMPR_DEBUG_LOG("[NRB] Block Total Length: %u\n", blockTotalLength);
+
+    // records end with the end record, at the latest before the trailing block length
+    uint32_t offset = 8;
+    while (offset + 4 <= blockTotalLength - 4) {
+        const uint16_t recordType = ByteOrder::read16(&data[offset]);
+        const uint16_t recordLength = ByteOrder::read16(&data[offset + 2]);
+        if (recordType == MMPR_NRB_RECORD_END ||
+            offset + 4 + recordLength > blockTotalLength - 4) {
+            break;
+        }
+
+        if (recordType >= NameResolutionTable::IPV4 &&
+            recordType <= NameResolutionTable::EUI64) {
+            const auto type = static_cast<NameResolutionTable::AddressType>(recordType);
+            const size_t addressLength = NameResolutionTable::addressLength(type);
+            if (recordLength > addressLength) {
+                const uint8_t* address = &data[offset + 4];
+                const char* name = reinterpret_cast<const char*>(address + addressLength);
+                table.insert(type, address,
+                             std::string_view(name, strnlen(name, recordLength -
+                                                                      addressLength)));
+            }
+        } else {
+            MMPR_WARN_1("Encountered unknown name resolution record type: %u, skipping\n",
+                        recordType);
+        }
+
+        // record values are padded to 32 bits
+        offset += 4 + recordLength + (4 - recordLength % 4) % 4;
+    }
+
+    // make sure that the block actually ends with block total length
+    MMPR_ASSERT(ByteOrder::read32(&data[blockTotalLength - 4]) == blockTotalLength);
+}
+
+template <typename ByteOrder>
+void PcapNgBlockParser<ByteOrder>::readEPBOptions(const uint8_t* data,
+                                                 PacketOptions& options) {
+    MMPR_PROFILE_SCOPE(OPTIONS);
+    const uint32_t blockTotalLength = ByteOrder::read32(&data[4]);
+    const uint32_t capturePacketLength = ByteOrder::read32(&data[20]);
+    const uint32_t packetDataTotalLength =
+        capturePacketLength + (4 - capturePacketLength % 4) % 4;
+
+    // options start after the packet data and end before the trailing block total
+    // length
+    size_t offset = 28 + (size_t)packetDataTotalLength;
+    while (offset + 4 <= blockTotalLength - 4) {
+        Option option{};
+        OptionParser::readEPBOption(data, option, offset);
+        if (option.type == MMPR_BLOCK_OPTION_END_OF_OPT ||
+            offset + option.totalLength() > blockTotalLength - 4) {
+            break;
+        }
+        offset += option.totalLength();
+
+        switch (option.type) {
+        case MMPR_BLOCK_OPTION_EPB_FLAGS:
+            if (option.length == 4) {
+                options.flags = ByteOrder::read32(option.value);
+            }
+            break;
+        case MMPR_BLOCK_OPTION_EPB_HASH:
+            // one byte algorithm followed by the digest
+            if (option.length >= 1) {
+                options.hashAlgorithm = option.value[0];
+                options.hash = &option.value[1];
+                options.hashLength = option.length - 1;
+            }
+            break;
+        case MMPR_BLOCK_OPTION_EPB_DROPCOUNT:
+            if (option.length == 8) {
+                options.dropCount = ByteOrder::read64(option.value);
+            }
+            break;
+        case MMPR_BLOCK_OPTION_EPB_PACKETID:
+            if (option.length == 8) {
+                options.packetId = ByteOrder::read64(option.value);
+            }
+            break;
+        case MMPR_BLOCK_OPTION_EPB_QUEUE:
+            if (option.length == 4) {
+                options.queue = ByteOrder::read32(option.value);
+            }
+            break;
+        }
+    }
+}
+
+template <typename ByteOrder>
+bool PcapNgBlockParser<ByteOrder>::checkOptions(const uint8_t* data, size_t offset) {
+    const uint32_t blockTotalLength = ByteOrder::read32(&data[4]);
+    // options end before the trailing block total length, opt_endofopt is optional
+    const size_t end = blockTotalLength - 4;
+    while (offset < end) {
+        if (offset + 4 > end) {
+            return false;
+        }
+        Option option{};
+        OptionParser::readOption(data, option, offset);
+        if (offset + option.totalLength() > end) {
+            return false;
+        }
+        if (option.type == MMPR_BLOCK_OPTION_END_OF_OPT) {
+            break;
+        }
+        offset += option.totalLength();
+    }
+    return true;
+}
+
+template class PcapNgBlockParser<NativeByteOrder>;
+template class PcapNgBlockParser<SwappedByteOrder>;
 } // namespace mmpr
@@ -8,6 +8,14 @@ using namespace std;
 namespace mmpr {
 
 bool PcapNgReader::readNextPacket(Packet& packet) {
+    if (mSwapped) {
+        return readNextPacket<SwappedByteOrder>(packet);
+    }
+    return readNextPacket<NativeByteOrder>(packet);
+}
+
+template <typename ByteOrder>
+bool PcapNgReader::readNextPacketFromBlocks(Packet& packet) {
     if (isExhausted()) {
         // nothing more to read
         return false;
@@ -20,25 +28,37 @@ bool PcapNgReader::readNextPacket(Packet& packet) {
                             to_string(mFileSize - mOffset) + " bytes left in the file");
     }
 
-    uint32_t blockType = *(uint32_t*)&mData[mOffset];
-    uint32_t blockTotalLength = *(uint32_t*)&mData[mOffset + 4];
+    uint32_t blockType = ByteOrder::read32(&mData[mOffset]);
+    uint32_t blockTotalLength = ByteOrder::read32(&mData[mOffset + 4]);
+
+    while (blockType != MMPR_ENHANCED_PACKET_BLOCK &&
+           blockType != MMPR_SIMPLE_PACKET_BLOCK && blockType != MMPR_PACKET_BLOCK) {
+        if (blockType != MMPR_SECTION_HEADER_BLOCK) {
+            // Section Header Blocks are checked once their byte order is known
+            blockTotalLength = checkBlock<ByteOrder>(minimumBlockLength(blockType));
+        } else {
+            blockTotalLength = processSectionHeaderBlock();
+        }
+        if (mStatistics) {
+            countBlock(blockType, blockTotalLength);
+        }
 
-    // TODO add support for Simple Packet Blocks
-    while (blockType != MMPR_ENHANCED_PACKET_BLOCK && blockType != MMPR_PACKET_BLOCK) {
         if (blockType == MMPR_SECTION_HEADER_BLOCK) {
-            SectionHeaderBlock shb{};
-            PcapNgBlockParser::readSHB(&mData[mOffset], shb);
-            mMetadata.comment = shb.options.comment;
-            mMetadata.os = shb.options.os;
-            mMetadata.hardware = shb.options.hardware;
-            mMetadata.userApplication = shb.options.userApplication;
+            if (mSwapped != ByteOrder::SWAPPED) {
+                // the new section has a different byte order, continue with the
+                // matching parser
+                mOffset += blockTotalLength;
+                return mSwapped ? readNextPacketFromBlocks<SwappedByteOrder>(packet)
+                                : readNextPacketFromBlocks<NativeByteOrder>(packet);
+            }
         } else if (blockType == MMPR_INTERFACE_DESCRIPTION_BLOCK) {
-            InterfaceDescriptionBlock idb{};
-            PcapNgBlockParser::readIDB(&mData[mOffset], idb);
-            mDataLinkType = idb.linkType;
-            mMetadata.timestampResolution = idb.options.timestampResolution;
-            mTraceInterfaces.emplace_back(idb.options.name, idb.options.description,
-                                          idb.options.filter, idb.options.os);
+            processInterfaceDescriptionBlock<ByteOrder>();
+        } else if (blockType == MMPR_NAME_RESOLUTION_BLOCK) {
+            // parsed once names are queried
+            recordNameResolutionBlock(mOffset, ByteOrder::SWAPPED);
+        } else if (blockType == MMPR_INTERFACE_STATISTICS_BLOCK &&
+                   mInterfaceStatisticsCallback) {
+            processInterfaceStatisticsBlock<ByteOrder>();
         }
 
         mOffset += blockTotalLength;
@@ -57,35 +77,39 @@ bool PcapNgReader::readNextPacket(Packet& packet) {
         }
 
         // try to read next block type
-        blockType = *(const uint32_t*)&mData[mOffset];
-        blockTotalLength = *(const uint32_t*)&mData[mOffset + 4];
+        blockType = ByteOrder::read32(&mData[mOffset]);
+        blockTotalLength = ByteOrder::read32(&mData[mOffset + 4]);
     }
 
+    if (mStatistics) {
+        countBlock(blockType, blockTotalLength);
+    }
     switch (blockType) {
     case MMPR_ENHANCED_PACKET_BLOCK: {
-        EnhancedPacketBlock epb{};
-        PcapNgBlockParser::readEPB(&mData[mOffset], epb);
-        util::calculateTimestamps(mMetadata.timestampResolution, epb.timestampHigh,
-                                  epb.timestampLow, &(packet.timestampSeconds),
-                                  &(packet.timestampMicroseconds));
-        packet.captureLength = epb.capturePacketLength;
-        packet.length = epb.originalPacketLength;
-        packet.data = epb.packetData;
-        packet.interfaceIndex = epb.interfaceId;
-
-        mOffset += epb.blockTotalLength;
+        readEnhancedPacketBlock<ByteOrder>(packet);
+        break;
+    }
+    case MMPR_SIMPLE_PACKET_BLOCK: {
+        readSimplePacketBlock<ByteOrder>(packet);
         break;
     }
     case MMPR_PACKET_BLOCK: {
+        checkBlock<ByteOrder>(minimumBlockLength(MMPR_PACKET_BLOCK));
         PacketBlock pb{};
-        PcapNgBlockParser::readPB(&mData[mOffset], pb);
-        util::calculateTimestamps(mMetadata.timestampResolution, pb.timestampHigh,
-                                  pb.timestampLow, &(packet.timestampSeconds),
-                                  &(packet.timestampMicroseconds));
+        PcapNgBlockParser<ByteOrder>::readPB(&mData[mOffset], pb);
+        const InterfaceDescriptor& interface = lookupInterface(pb.interfaceId);
+        if (mValidationLevel != ValidationLevel::NONE) {
+            checkCaptureLength(pb.capturePacketLength, pb.blockTotalLength - 32,
+                               interface.snapLength);
+        }
+        util::calculateTimestamps(interface.timestampConverter, pb.timestampHigh,
+                                  pb.timestampLow, packet);
         packet.captureLength = pb.capturePacketLength;
         packet.length = pb.originalPacketLength;
         packet.data = pb.packetData;
         packet.interfaceIndex = pb.interfaceId;
+        packet.optionsBlock = nullptr;
+        packet.optionsSwapped = false;
 
         mOffset += pb.blockTotalLength;
         break;
@@ -95,6 +119,19 @@ bool PcapNgReader::readNextPacket(Packet& packet) {
     return true;
 }
 
+bool PcapNgReader::readPacketOptions(const Packet& packet, PacketOptions& options) {
+    if (packet.optionsBlock == nullptr) {
+        return false;
+    }
+    options = PacketOptions{};
+    if (packet.optionsSwapped) {
+        PcapNgBlockParser<SwappedByteOrder>::readEPBOptions(packet.optionsBlock, options);
+    } else {
+        PcapNgBlockParser<NativeByteOrder>::readEPBOptions(packet.optionsBlock, options);
+    }
+    return true;
+}
+
 /**
  * 3.1.  General Block Structure
  *
@@ -112,50 +149,76 @@ bool PcapNgReader::readNextPacket(Packet& packet) {
  *   +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
 uint32_t PcapNgReader::readBlock() {
-    const auto blockType = *(const uint32_t*)&mData[mOffset];
-    const auto blockTotalLength = *(const uint32_t*)&mData[mOffset + 4];
+    if (mSwapped) {
+        return readBlock<SwappedByteOrder>();
+    }
+    return readBlock<NativeByteOrder>();
+}
+
+template <typename ByteOrder>
+uint32_t PcapNgReader::readBlock() {
+    if (mFileSize - mOffset < 8) {
+        throw runtime_error("Expected to read at least one more block (8 bytes at "
+                            "least), but there are only " +
+                            to_string(mFileSize - mOffset) + " bytes left in the file");
+    }
+
+    const auto blockType = ByteOrder::read32(&mData[mOffset]);
+    auto blockTotalLength = ByteOrder::read32(&mData[mOffset + 4]);
+    if (blockType != MMPR_SECTION_HEADER_BLOCK) {
+        // Section Header Blocks are checked once their byte order is known
+        blockTotalLength = checkBlock<ByteOrder>(minimumBlockLength(blockType));
+    } else {
+        // may switch the byte order for the following blocks
+        blockTotalLength = processSectionHeaderBlock();
+    }
+    if (mStatistics) {
+        countBlock(blockType, blockTotalLength);
+    }
 
     switch (blockType) {
     case MMPR_SECTION_HEADER_BLOCK: {
-        SectionHeaderBlock shb{};
-        PcapNgBlockParser::readSHB(&mData[mOffset], shb);
-        mMetadata.comment = shb.options.comment;
-        mMetadata.os = shb.options.os;
-        mMetadata.hardware = shb.options.hardware;
-        mMetadata.userApplication = shb.options.userApplication;
         break;
     }
     case MMPR_INTERFACE_DESCRIPTION_BLOCK: {
-        InterfaceDescriptionBlock idb{};
-        PcapNgBlockParser::readIDB(&mData[mOffset], idb);
-        mDataLinkType = idb.linkType;
-        mMetadata.timestampResolution = idb.options.timestampResolution;
-        mTraceInterfaces.emplace_back(idb.options.name, idb.options.description,
-                                      idb.options.filter, idb.options.os);
+        processInterfaceDescriptionBlock<ByteOrder>();
         break;
     }
     case MMPR_ENHANCED_PACKET_BLOCK: {
-        EnhancedPacketBlock epb{};
-        PcapNgBlockParser::readEPB(&mData[mOffset], epb);
-        break;
+        // validated like in the packet loop, which also moves to the next block
+        Packet packet;
+        readEnhancedPacketBlock<ByteOrder>(packet);
+        return blockType;
     }
     case MMPR_PACKET_BLOCK: {
         // deprecated in newer versions of PcapNG
         PacketBlock pb{};
-        PcapNgBlockParser::readPB(&mData[mOffset], pb);
+        PcapNgBlockParser<ByteOrder>::readPB(&mData[mOffset], pb);
+        if (mValidationLevel != ValidationLevel::NONE) {
+            checkCaptureLength(pb.capturePacketLength, pb.blockTotalLength - 32,
+                               lookupInterface(pb.interfaceId).snapLength);
+        }
         break;
     }
     case MMPR_SIMPLE_PACKET_BLOCK: {
-        MMPR_WARN("Parsing of Simple Packet Blocks not implemented, skipping\n");
-        break;
+        Packet packet;
+        readSimplePacketBlock<ByteOrder>(packet);
+        return blockType;
     }
     case MMPR_NAME_RESOLUTION_BLOCK: {
-        MMPR_WARN("Parsing of Name Resolution Blocks not implemented, skipping\n");
+        recordNameResolutionBlock(mOffset, ByteOrder::SWAPPED);
         break;
     }
     case MMPR_INTERFACE_STATISTICS_BLOCK: {
-        InterfaceStatisticsBlock isb{};
-        PcapNgBlockParser::readISB(&mData[mOffset], isb);
+        if (mInterfaceStatisticsCallback) {
+            processInterfaceStatisticsBlock<ByteOrder>();
+        } else {
+            if (mValidationLevel == ValidationLevel::FULL) {
+                checkOptions<ByteOrder>(20);
+            }
+            InterfaceStatisticsBlock isb{};
+            PcapNgBlockParser<ByteOrder>::readISB(&mData[mOffset], isb);
+        }
         break;
     }
     case MMPR_DECRYPTION_SECRETS_BLOCK: {
@@ -182,4 +245,418 @@ uint32_t PcapNgReader::readBlock() {
     return blockType;
 }
 
+uint32_t PcapNgReader::processSectionHeaderBlock() {
+    if (mFileSize - mOffset < 12) {
+        throw runtime_error("Expected to read a Section Header Block (12 bytes at "
+                            "least), but there are only " +
+                            to_string(mFileSize - mOffset) + " bytes left in the file");
+    }
+
+    // every section declares its own byte order
+    uint32_t blockType;
+    uint32_t blockTotalLength;
+    if (!readBlockHeader(mOffset, mSwapped, blockType, blockTotalLength)) {
+        throw runtime_error("Section Header Block at offset " + to_string(mOffset) +
+                            " has an invalid byte-order magic");
+    }
+
+    // standard Section Header Block has size 28 (without any options)
+    SectionHeaderBlock shb{};
+    if (mSwapped) {
+        checkBlock<SwappedByteOrder>(28);
+        if (mValidationLevel == ValidationLevel::FULL) {
+            checkOptions<SwappedByteOrder>(24);
+        }
+        PcapNgBlockParser<SwappedByteOrder>::readSHB(&mData[mOffset], shb);
+    } else {
+        checkBlock<NativeByteOrder>(28);
+        if (mValidationLevel == ValidationLevel::FULL) {
+            checkOptions<NativeByteOrder>(24);
+        }
+        PcapNgBlockParser<NativeByteOrder>::readSHB(&mData[mOffset], shb);
+    }
+    mMetadata = shb.options;
+    // interface ids start over in every section
+    mInterfaceDescriptors.clear();
+    ++mSectionCount;
+    return shb.blockTotalLength;
+}
+
+template <typename ByteOrder>
+void PcapNgReader::processInterfaceDescriptionBlock() {
+    if (mValidationLevel == ValidationLevel::FULL) {
+        checkOptions<ByteOrder>(16);
+    }
+    InterfaceDescriptionBlock idb{};
+    PcapNgBlockParser<ByteOrder>::readIDB(&mData[mOffset], idb);
+    mDataLinkType = idb.linkType;
+    mInterfaceDescriptors.emplace_back(idb);
+    mTraceInterfaces.push_back(idb.options);
+}
+
+namespace {
+
+std::optional<std::string> toString(const std::optional<std::string_view>& view) {
+    if (!view) {
+        return std::nullopt;
+    }
+    return std::string(*view);
+}
+
+TraceInterface toTraceInterface(const InterfaceDescriptionBlock::Options& options) {
+    return TraceInterface(toString(options.name), toString(options.description),
+                          toString(options.filter), toString(options.os));
+}
+
+} // namespace
+
+std::vector<TraceInterface> PcapNgReader::getTraceInterfaces() const {
+    std::vector<TraceInterface> traceInterfaces;
+    traceInterfaces.reserve(mTraceInterfaces.size());
+    for (const auto& options : mTraceInterfaces) {
+        traceInterfaces.push_back(toTraceInterface(options));
+    }
+    return traceInterfaces;
+}
+
+TraceInterface PcapNgReader::getTraceInterface(size_t id) const {
+    if (id >= mTraceInterfaces.size()) {
+        throw std::out_of_range("Trace interface index " + std::to_string(id) +
+                                " is out of range");
+    }
+    return toTraceInterface(mTraceInterfaces[id]);
+}
+
+namespace {
+
+template <typename ByteOrder>
+InterfaceStatistics
+toInterfaceStatistics(const uint8_t* data,
+                      uint32_t section,
+                      const std::vector<InterfaceDescriptor>& interfaces) {
+    InterfaceStatisticsBlock isb{};
+    PcapNgBlockParser<ByteOrder>::readISB(data, isb);
+    if (isb.interfaceId >= interfaces.size()) {
+        throw runtime_error("Interface Statistics Block refers to interface " +
+                            to_string(isb.interfaceId) + ", but only " +
+                            to_string(interfaces.size()) +
+                            " interfaces have been described in the current section");
+    }
+    const TimestampConverter& converter = interfaces[isb.interfaceId].timestampConverter;
+
+    InterfaceStatistics statistics{};
+    statistics.section = section;
+    statistics.interfaceId = isb.interfaceId;
+    statistics.timestamp =
+        converter.toNanoseconds((uint64_t)isb.timestampHigh << 32 | isb.timestampLow);
+    if (isb.options.startTime) {
+        statistics.startTime = converter.toNanoseconds(*isb.options.startTime);
+    }
+    if (isb.options.endTime) {
+        statistics.endTime = converter.toNanoseconds(*isb.options.endTime);
+    }
+    statistics.received = isb.options.ifRecv;
+    statistics.interfaceDropped = isb.options.ifDrop;
+    statistics.filterAccepted = isb.options.filterAccept;
+    statistics.osDropped = isb.options.osDrop;
+    statistics.userDelivered = isb.options.usrDeliv;
+    return statistics;
+}
+
+} // namespace
+
+template <typename ByteOrder>
+void PcapNgReader::processInterfaceStatisticsBlock() {
+    // a block before the first Section Header Block is rejected by the interface check
+    const uint32_t section = mSectionCount > 0 ? mSectionCount - 1 : 0;
+    if (mValidationLevel == ValidationLevel::FULL) {
+        checkOptions<ByteOrder>(20);
+    }
+    const uint8_t* data = &mData[mOffset];
+    mInterfaceStatisticsCallback(
+        toInterfaceStatistics<ByteOrder>(data, section, mInterfaceDescriptors));
+}
+
+template <typename Visit>
+void PcapNgReader::forEachBlock(size_t offset, bool swapped, Visit visit) const {
+    while (offset + 12 <= mFileSize) {
+        uint32_t blockType;
+        uint32_t blockTotalLength;
+        if (!readBlockHeader(offset, swapped, blockType, blockTotalLength)) {
+            throw runtime_error("Section Header Block at offset " + to_string(offset) +
+                                " has an invalid byte-order magic");
+        }
+        if (blockTotalLength < 12 || blockTotalLength > mFileSize - offset) {
+            throw runtime_error("Block at offset " + to_string(offset) +
+                                " has an invalid block total length " +
+                                to_string(blockTotalLength));
+        }
+        visit(offset, blockType, swapped);
+        offset += blockTotalLength;
+    }
+}
+
+std::vector<InterfaceStatistics> PcapNgReader::readInterfaceStatistics() const {
+    std::vector<InterfaceStatistics> result;
+    std::vector<InterfaceDescriptor> interfaces;
+    uint32_t sectionCount = 0;
+    forEachBlock(0, false, [&](size_t offset, uint32_t blockType, bool swapped) {
+        if (blockType == MMPR_SECTION_HEADER_BLOCK) {
+            interfaces.clear();
+            ++sectionCount;
+        } else if (blockType == MMPR_INTERFACE_DESCRIPTION_BLOCK) {
+            InterfaceDescriptionBlock idb{};
+            if (swapped) {
+                PcapNgBlockParser<SwappedByteOrder>::readIDB(&mData[offset], idb);
+            } else {
+                PcapNgBlockParser<NativeByteOrder>::readIDB(&mData[offset], idb);
+            }
+            interfaces.emplace_back(idb);
+        } else if (blockType == MMPR_INTERFACE_STATISTICS_BLOCK) {
+            const uint32_t section = sectionCount > 0 ? sectionCount - 1 : 0;
+            result.push_back(
+                swapped ? toInterfaceStatistics<SwappedByteOrder>(&mData[offset], section,
+                                                                  interfaces)
+                        : toInterfaceStatistics<NativeByteOrder>(&mData[offset], section,
+                                                                 interfaces));
+        }
+    });
+    return result;
+}
+
+const NameResolutionTable& PcapNgReader::getNameResolutionTable() {
+    for (const NameResolutionBlockRef& block : mPendingNameResolutionBlocks) {
+        if (block.swapped) {
+            PcapNgBlockParser<SwappedByteOrder>::readNRB(&mData[block.offset],
+                                                         mNameResolutionTable);
+        } else {
+            PcapNgBlockParser<NativeByteOrder>::readNRB(&mData[block.offset],
+                                                        mNameResolutionTable);
+        }
+    }
+    mPendingNameResolutionBlocks.clear();
+    return mNameResolutionTable;
+}
+
+void PcapNgReader::scanNameResolutionBlocks() {
+    forEachBlock(mOffset, mSwapped,
+                 [this](size_t offset, uint32_t blockType, bool swapped) {
+                     if (blockType == MMPR_NAME_RESOLUTION_BLOCK) {
+                         recordNameResolutionBlock(offset, swapped);
+                     }
+                 });
+    mNameResolutionRecordedUntil = mFileSize;
+}
+
+void PcapNgReader::resetBlockState() {
+    releaseTraceViews();
+    mSkippedRanges.clear();
+    mSectionCount = 0;
+    mNameResolutionRecordedUntil = 0;
+}
+
+void PcapNgReader::releaseTraceViews() {
+    mMetadata = {};
+    mTraceInterfaces.clear();
+    mPendingNameResolutionBlocks.clear();
+    mNameResolutionTable.clear();
+}
+
+bool PcapNgReader::readNextPacketInstrumented(Packet& packet) {
+    if (!mStatistics) {
+        return readNextPacketRecovering(packet);
+    }
+    return readNextPacketCounted(packet, [this](Packet& next) {
+        return mRecovery ? readNextPacketRecovering(next) : readPacketOfSection(next);
+    });
+}
+
+bool PcapNgReader::readNextPacketRecovering(Packet& packet) {
+    while (!isExhausted()) {
+        try {
+            // the byte order may change with a section found by resynchronize()
+            return readPacketOfSection(packet);
+        } catch (const runtime_error& error) {
+            // blocks are validated before the offset moves past them, the current
+            // offset is the invalid block
+            resynchronize(error.what());
+        }
+    }
+    return false;
+}
+
+bool PcapNgReader::readPacketOfSection(Packet& packet) {
+    // the fast path of readPacket() does not pass readNextPacketFromBlocks(), which
+    // counts all other blocks
+    uint32_t blockType = 0;
+    if (mStatistics && mOffset + 8 <= mFileSize) {
+        blockType = mSwapped ? SwappedByteOrder::read32(&mData[mOffset])
+                             : NativeByteOrder::read32(&mData[mOffset]);
+    }
+    const bool read = mSwapped ? readPacket<SwappedByteOrder>(packet)
+                               : readPacket<NativeByteOrder>(packet);
+    if (blockType == MMPR_ENHANCED_PACKET_BLOCK ||
+        blockType == MMPR_SIMPLE_PACKET_BLOCK) {
+        countBlock(blockType, 0);
+    }
+    return read;
+}
+
+void PcapNgReader::countBlock(uint32_t blockType, uint32_t blockTotalLength) {
+    ++mStatistics->blocks[blockType];
+    switch (blockType) {
+    case MMPR_SECTION_HEADER_BLOCK:
+    case MMPR_INTERFACE_DESCRIPTION_BLOCK:
+    case MMPR_PACKET_BLOCK:
+    case MMPR_SIMPLE_PACKET_BLOCK:
+    case MMPR_NAME_RESOLUTION_BLOCK:
+    case MMPR_INTERFACE_STATISTICS_BLOCK:
+    case MMPR_ENHANCED_PACKET_BLOCK:
+        break;
+    default:
+        // decryption secrets, custom and unknown blocks are skipped unparsed
+        mStatistics->skippedBytes += blockTotalLength;
+    }
+}
+
+void PcapNgReader::resynchronize(const std::string& reason) {
+    const size_t start = mOffset;
+    size_t offset = start + 1;
+    // blocks are 32 bit aligned, but a block cut off by a failed write shifts all
+    // following blocks, so every byte is a candidate
+    for (; offset + 12 <= mFileSize; ++offset) {
+        uint32_t blockTotalLength;
+        if (!isBlockBoundary(offset, mSwapped, blockTotalLength)) {
+            continue;
+        }
+        // random bytes passing the checks are unlikely, but require the following
+        // block to be valid as well
+        const size_t next = offset + blockTotalLength;
+        uint32_t nextBlockTotalLength;
+        if (next == mFileSize || isBlockBoundary(next, mSwapped, nextBlockTotalLength)) {
+            break;
+        }
+    }
+    if (offset + 12 > mFileSize) {
+        // no block left, the rest of the file is lost
+        offset = mFileSize;
+    }
+
+    recordSkippedRange(mSkippedRanges, start, offset, reason);
+    mOffset = offset;
+}
+
+bool PcapNgReader::isBlockBoundary(size_t offset,
+                                   bool swapped,
+                                   uint32_t& blockTotalLength) const {
+    uint32_t blockType;
+    if (offset + 12 > mFileSize ||
+        !readBlockHeader(offset, swapped, blockType, blockTotalLength)) {
+        return false;
+    }
+
+    switch (blockType) {
+    case MMPR_SECTION_HEADER_BLOCK:
+    case MMPR_INTERFACE_DESCRIPTION_BLOCK:
+    case MMPR_PACKET_BLOCK:
+    case MMPR_SIMPLE_PACKET_BLOCK:
+    case MMPR_NAME_RESOLUTION_BLOCK:
+    case MMPR_INTERFACE_STATISTICS_BLOCK:
+    case MMPR_ENHANCED_PACKET_BLOCK:
+    case MMPR_DECRYPTION_SECRETS_BLOCK:
+    case MMPR_CUSTOM_CAN_COPY_BLOCK:
+    case MMPR_CUSTOM_DO_NOT_COPY_BLOCK:
+        break;
+    default:
+        return false;
+    }
+
+    if (blockTotalLength < minimumBlockLength(blockType) || blockTotalLength % 4 != 0 ||
+        blockTotalLength > mFileSize - offset) {
+        return false;
+    }
+    const uint8_t* trailer = &mData[offset + blockTotalLength - 4];
+    return (swapped ? SwappedByteOrder::read32(trailer)
+                    : NativeByteOrder::read32(trailer)) == blockTotalLength;
+}
+
+bool PcapNgReader::readBlockHeader(size_t offset,
+                                   bool& swapped,
+                                   uint32_t& blockType,
+                                   uint32_t& blockTotalLength) const {
+    blockType = NativeByteOrder::read32(&mData[offset]);
+    if (blockType == MMPR_SECTION_HEADER_BLOCK) {
+        const uint32_t byteOrderMagic = NativeByteOrder::read32(&mData[offset + 8]);
+        if (byteOrderMagic != MMPR_BYTE_ORDER_MAGIC &&
+            byteOrderMagic != MMPR_BYTE_ORDER_MAGIC_SWAPPED) {
+            return false;
+        }
+        swapped = byteOrderMagic == MMPR_BYTE_ORDER_MAGIC_SWAPPED;
+    } else if (swapped) {
+        blockType = SwappedByteOrder::read32(&mData[offset]);
+    }
+    blockTotalLength = swapped ? SwappedByteOrder::read32(&mData[offset + 4])
+                               : NativeByteOrder::read32(&mData[offset + 4]);
+    return true;
+}
+
+template <typename ByteOrder>
+void PcapNgReader::checkOptions(size_t optionsOffset) const {
+    if (!PcapNgBlockParser<ByteOrder>::checkOptions(&mData[mOffset], optionsOffset)) {
+        throw runtime_error("Block at offset " + to_string(mOffset) +
+                            " has an option exceeding the block");
+    }
+}
+
+void PcapNgReader::throwInvalidBlockLength(uint32_t blockTotalLength,
+                                           uint32_t minimumLength) const {
+    string reason;
+    if (blockTotalLength < minimumLength) {
+        reason = "is shorter than the minimum of " + to_string(minimumLength) + " bytes";
+    } else if (blockTotalLength > mFileSize - mOffset) {
+        reason = "exceeds the " + to_string(mFileSize - mOffset) +
+                 " bytes left in the file";
+    } else if (blockTotalLength % 4 != 0) {
+        reason = "is not a multiple of 4";
+    } else {
+        reason = "does not match the trailing block total length";
+    }
+    throw runtime_error("Block at offset " + to_string(mOffset) +
+                        " has an invalid block total length " +
+                        to_string(blockTotalLength) + ", it " + reason);
+}
+
+void PcapNgReader::throwInvalidCaptureLength(uint32_t captureLength,
+                                             uint32_t maximumLength) const {
+    throw runtime_error("Packet at offset " + to_string(mOffset) +
+                        " has an invalid captured length " + to_string(captureLength) +
+                        ", it exceeds the block or the snapshot length (" +
+                        to_string(maximumLength) + " bytes)");
+}
+
+uint32_t PcapNgReader::minimumBlockLength(uint32_t blockType) {
+    switch (blockType) {
+    case MMPR_SECTION_HEADER_BLOCK:
+        return 28;
+    case MMPR_INTERFACE_DESCRIPTION_BLOCK:
+        return 20;
+    case MMPR_ENHANCED_PACKET_BLOCK:
+    case MMPR_PACKET_BLOCK:
+        return 32;
+    case MMPR_INTERFACE_STATISTICS_BLOCK:
+        return 24;
+    case MMPR_SIMPLE_PACKET_BLOCK:
+    case MMPR_NAME_RESOLUTION_BLOCK:
+        return 16;
+    default:
+        // block type, block total length and trailing block total length
+        return 12;
+    }
+}
+
+template void PcapNgReader::checkOptions<NativeByteOrder>(size_t optionsOffset) const;
+template void PcapNgReader::checkOptions<SwappedByteOrder>(size_t optionsOffset) const;
+template bool PcapNgReader::readNextPacketFromBlocks<NativeByteOrder>(Packet& packet);
+template bool PcapNgReader::readNextPacketFromBlocks<SwappedByteOrder>(Packet& packet);
+
 } // namespace mmpr
\ No newline at end of file
@@ -2,7 +2,6 @@
 
 #include "mmpr/pcapng/ZstdPcapNgReader.h"
 
-#include "mmpr/ZstdDecompressor.h"
 #include "util.h"
 #include <algorithm>
 #include <sstream>
@@ -11,7 +10,9 @@ using namespace std;
 
 namespace mmpr {
 
-ZstdPcapNgReader::ZstdPcapNgReader(const std::string& filepath) : PcapNgReader(filepath) {
+ZstdPcapNgReader::ZstdPcapNgReader(const std::string& filepath,
+                                   std::shared_ptr<ZstdDecompressionPool> pool)
+    : PcapNgReader(filepath), mPool(std::move(pool)) {
     uint32_t magicNumber = util::read32bitsFromFile(filepath);
     if (magicNumber != MMPR_MAGIC_NUMBER_ZSTD) {
         stringstream sstream;
@@ -22,16 +23,46 @@ ZstdPcapNgReader::ZstdPcapNgReader(const std::string& filepath) : PcapNgReader(f
                                  "number, instead got: 0x" +
                                  hex + ", possibly little/big endian issue");
     }
+    if (!mPool) {
+        mPool = std::make_shared<ZstdDecompressionPool>();
+    }
+}
+
+ZstdPcapNgReader::ZstdPcapNgReader(const std::string& filepath,
+                                   int fileDescriptor,
+                                   std::shared_ptr<ZstdDecompressionPool> pool)
+    : PcapNgReader(filepath, fileDescriptor), mPool(std::move(pool)) {
+    if (!mPool) {
+        mPool = std::make_shared<ZstdDecompressionPool>();
+    }
 }
 
 void ZstdPcapNgReader::open() {
-    mData = reinterpret_cast<const uint8_t*>(
-        ZstdDecompressor::decompressFileInMemory(mFilepath, mFileSize));
+    resetStatistics();
+    const auto start = std::chrono::steady_clock::now();
+    // pread() does not depend on the file offset, the descriptor is used directly
+    mData = mSourceDescriptor >= 0
+                ? mPool->decompress(mSourceDescriptor, mFilepath, mFileSize)
+                : mPool->decompress(mFilepath, mFileSize);
+    if (mStatistics) {
+        mStatistics->decompressionNanoseconds =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start)
+                .count();
+    }
+    mOffset = 0;
+    resetBlockState();
     assert(mFileSize > 0);
 }
 
 void ZstdPcapNgReader::close() {
-    free((void*)mData);
+    // the metadata views would point into unmapped or reused memory
+    releaseTraceViews();
+    if (mData != nullptr) {
+        mPool->release(mData);
+        mData = nullptr;
+    }
+    MMPR_PROFILE_DUMP();
 }
 
 } // namespace mmpr
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <fstream>
+#include <string_view>
 
 namespace mmpr {
 namespace util {
@@ -29,10 +30,10 @@ __attribute__((unused)) static uint32_t read32bitsFromFile(const std::string& fi
  * Parses a non zero terminated string from the option at option.value with length
  * option.length.
  * @param option the option containing the string value
- * @return string value
+ * @return view of the string value, pointing into the option
  */
-__attribute__((unused)) static std::string parseUTF8(const Option& option) {
-    return std::string(reinterpret_cast<const char*>(option.value), option.length);
+__attribute__((unused)) static std::string_view parseUTF8(const Option& option) {
+    return {reinterpret_cast<const char*>(option.value), option.length};
 }
 
 __attribute__((unused)) static void dumpMemory(const uint8_t* data, size_t length) {
@@ -75,15 +76,28 @@ __attribute__((unused)) static uint32_t fromIfTsresolUInt(const uint8_t value) {
     }
 }
 
-inline static void calculateTimestamps(uint32_t timestampResolution,
+/**
+ * Converts a split 64 bit pcapng timestamp into nanoseconds using the interface's
+ * precomputed constants and stores it in the packet.
+ */
+inline static void calculateTimestamps(const TimestampConverter& converter,
                                        uint32_t timestampHigh,
                                        uint32_t timestampLow,
-                                       uint32_t* timestampSeconds,
-                                       uint32_t* timestampMicroseconds) {
+                                       Packet& packet) {
     uint64_t timestamp = (uint64_t)timestampHigh << 32 | timestampLow;
-    uint64_t sec = timestamp / timestampResolution;
-    *timestampSeconds = sec;
-    *timestampMicroseconds = timestamp - sec * timestampResolution;
+    packet.setTimestamp(converter.toNanoseconds(timestamp));
+}
+
+/**
+ * Finalizer of MurmurHash3, spreads every input bit over all output bits.
+ */
+inline uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
 }
 
 } // namespace util
@@ -0,0 +1,94 @@
+#ifndef MMPR_TESTS_CORRUPTEDTRACE_H
+#define MMPR_TESTS_CORRUPTEDTRACE_H
+
+#include "mmpr/pcapng.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace mmpr {
+
+/**
+ * Copy of a little-endian trace that can be corrupted before it is written to a
+ * temporary file with the extension of the original, which is removed again on
+ * destruction.
+ */
+class CorruptedTrace {
+public:
+    explicit CorruptedTrace(const std::string& filepath) {
+        std::ifstream file(filepath, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Failed to open " + filepath);
+        }
+        mData.assign(std::istreambuf_iterator<char>(file), {});
+        static int instances = 0;
+        mFilepath = (std::filesystem::temp_directory_path() /
+                     ("mmpr-corrupted-" + std::to_string(getpid()) + "-" +
+                      std::to_string(instances++) +
+                      std::filesystem::path(filepath).extension().string()))
+                        .string();
+    }
+    CorruptedTrace(const CorruptedTrace&) = delete;
+    CorruptedTrace& operator=(const CorruptedTrace&) = delete;
+    ~CorruptedTrace() { std::filesystem::remove(mFilepath); }
+
+    size_t size() const { return mData.size(); }
+
+    /**
+     * @return offset of the first Enhanced Packet Block of a PcapNG trace, with options
+     * if requested
+     */
+    size_t findEnhancedPacketBlock(bool withOptions) const {
+        size_t offset = 0;
+        while (offset + 28 <= mData.size()) {
+            const uint32_t blockType = read32(offset);
+            const uint32_t blockTotalLength = read32(offset + 4);
+            if (blockType == MMPR_ENHANCED_PACKET_BLOCK) {
+                const uint32_t captureLength = read32(offset + 20);
+                const bool hasOptions =
+                    blockTotalLength - 32 > captureLength + (4 - captureLength % 4) % 4;
+                if (hasOptions == withOptions) {
+                    return offset;
+                }
+            }
+            offset += blockTotalLength;
+        }
+        throw std::runtime_error("no matching Enhanced Packet Block");
+    }
+
+    uint32_t read32(size_t offset) const {
+        uint32_t value;
+        memcpy(&value, &mData[offset], 4);
+        return value;
+    }
+    void write32(size_t offset, uint32_t value) { memcpy(&mData[offset], &value, 4); }
+    void write16(size_t offset, uint16_t value) { memcpy(&mData[offset], &value, 2); }
+    void zero(size_t offset, size_t length) {
+        std::fill_n(mData.begin() + offset, length, 0);
+    }
+    void truncate(size_t size) { mData.resize(size); }
+
+    /**
+     * @return path of the temporary file
+     */
+    const std::string& save() {
+        std::ofstream file(mFilepath, std::ios::binary | std::ios::trunc);
+        file.write(mData.data(), (std::streamsize)mData.size());
+        return mFilepath;
+    }
+
+private:
+    std::vector<char> mData;
+    std::string mFilepath;
+};
+
+} // namespace mmpr
+
+#endif // MMPR_TESTS_CORRUPTEDTRACE_H
@@ -1,6 +1,8 @@
 #include "gtest/gtest.h"
 
+#include "CorruptedTrace.h"
 #include "mmpr/pcap/MMPcapReader.h"
+#include <stdexcept>
 
 TEST(MMPcapReader, ConstructorSimple) {
     mmpr::MMPcapReader reader{"tracefiles/example.pcap"};
@@ -46,4 +48,37 @@ TEST(MMPcapReader, DLT) {
         }
         ASSERT_EQ(processedPackets, 1000);
     }
-}
\ No newline at end of file
+}
+TEST(MMPcapReader, CaptureLengthBeyondFile) {
+    const auto countPackets = [](const std::string& filepath, size_t& packets) {
+        auto reader = mmpr::FileReader::getReader(filepath);
+        reader->open();
+        mmpr::Packet packet;
+        while (reader->readNextPacket(packet)) {
+            ++packets;
+        }
+    };
+    {
+        // a capture that was cut off
+        mmpr::CorruptedTrace trace("tracefiles/example.pcap");
+        trace.truncate(trace.size() - 10);
+        size_t packets{0};
+        EXPECT_THROW(countPackets(trace.save(), packets), std::runtime_error);
+        EXPECT_EQ(packets, 4630);
+    }
+    {
+        // corrupted captured length of the first record
+        mmpr::CorruptedTrace trace("tracefiles/example.pcap");
+        trace.write32(24 + 8, 0x7FFFFFFF);
+        size_t packets{0};
+        EXPECT_THROW(countPackets(trace.save(), packets), std::runtime_error);
+        EXPECT_EQ(packets, 0);
+    }
+    {
+        mmpr::CorruptedTrace trace("tracefiles/big-endian-modified.pcap");
+        trace.truncate(trace.size() - 10);
+        size_t packets{0};
+        EXPECT_THROW(countPackets(trace.save(), packets), std::runtime_error);
+        EXPECT_EQ(packets, 4);
+    }
+}
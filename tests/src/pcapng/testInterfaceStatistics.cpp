@@ -0,0 +1,95 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <vector>
+
+namespace {
+
+std::vector<mmpr::InterfaceStatistics> readWithCallback(const std::string& filepath) {
+    mmpr::MMPcapNgReader reader(filepath);
+    std::vector<mmpr::InterfaceStatistics> statistics;
+    reader.setInterfaceStatisticsCallback(
+        [&](const mmpr::InterfaceStatistics& record) { statistics.push_back(record); });
+    reader.open();
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+    }
+    reader.close();
+    return statistics;
+}
+
+void expectEqual(const mmpr::InterfaceStatistics& lhs,
+                 const mmpr::InterfaceStatistics& rhs) {
+    EXPECT_EQ(lhs.section, rhs.section);
+    EXPECT_EQ(lhs.interfaceId, rhs.interfaceId);
+    EXPECT_EQ(lhs.timestamp, rhs.timestamp);
+    EXPECT_EQ(lhs.startTime, rhs.startTime);
+    EXPECT_EQ(lhs.endTime, rhs.endTime);
+    EXPECT_EQ(lhs.received, rhs.received);
+    EXPECT_EQ(lhs.interfaceDropped, rhs.interfaceDropped);
+    EXPECT_EQ(lhs.filterAccepted, rhs.filterAccepted);
+    EXPECT_EQ(lhs.osDropped, rhs.osDropped);
+    EXPECT_EQ(lhs.userDelivered, rhs.userDelivered);
+}
+
+} // namespace
+
+TEST(InterfaceStatistics, Counters) {
+    auto statistics = readWithCallback("tracefiles/pcapng-example.pcapng");
+    ASSERT_EQ(statistics.size(), 1);
+    const auto& record = statistics[0];
+    EXPECT_EQ(record.section, 0);
+    EXPECT_EQ(record.interfaceId, 0);
+    EXPECT_EQ(record.received, 59);
+    EXPECT_EQ(record.interfaceDropped, 0);
+    EXPECT_FALSE(record.filterAccepted);
+    EXPECT_FALSE(record.osDropped);
+    EXPECT_FALSE(record.userDelivered);
+    ASSERT_TRUE(record.startTime);
+    ASSERT_TRUE(record.endTime);
+    EXPECT_LE(*record.startTime, *record.endTime);
+    EXPECT_LE(*record.endTime, record.timestamp);
+
+    // the big-endian trace holds the same block
+    auto bigEndian = readWithCallback("tracefiles/big-endian.pcapng");
+    ASSERT_EQ(bigEndian.size(), 1);
+    expectEqual(bigEndian[0], record);
+}
+
+TEST(InterfaceStatistics, ScanMatchesCallback) {
+    auto statistics = readWithCallback("tracefiles/many_interfaces-1.pcapng");
+    ASSERT_EQ(statistics.size(), 11);
+    for (uint32_t i = 0; i < statistics.size(); ++i) {
+        EXPECT_EQ(statistics[i].interfaceId, i);
+    }
+    EXPECT_EQ(statistics[0].received, 124);
+    EXPECT_EQ(statistics[10].received, 4);
+
+    mmpr::MMPcapNgReader reader("tracefiles/many_interfaces-1.pcapng");
+    reader.open();
+    auto scanned = reader.readInterfaceStatistics();
+    // the scan does not move the reader
+    EXPECT_EQ(reader.getCurrentOffset(), 0);
+    reader.close();
+    ASSERT_EQ(scanned.size(), statistics.size());
+    for (size_t i = 0; i < scanned.size(); ++i) {
+        expectEqual(scanned[i], statistics[i]);
+    }
+}
+
+TEST(InterfaceStatistics, ReadBlock) {
+    mmpr::MMPcapNgReader reader("tracefiles/pcapng-example.pcapng");
+    size_t records{0};
+    reader.setInterfaceStatisticsCallback(
+        [&](const mmpr::InterfaceStatistics&) { ++records; });
+    reader.open();
+    size_t blocks{0};
+    while (!reader.isExhausted()) {
+        if (reader.readBlock() == MMPR_INTERFACE_STATISTICS_BLOCK) {
+            ++blocks;
+        }
+    }
+    reader.close();
+    EXPECT_EQ(blocks, 1);
+    EXPECT_EQ(records, 1);
+}
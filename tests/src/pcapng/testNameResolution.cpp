@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <arpa/inet.h>
+
+namespace {
+
+using mmpr::NameResolutionTable;
+
+struct Addresses {
+    uint8_t hostA[4];
+    uint8_t gateway[4];
+    uint8_t hostB[16];
+    uint8_t nic[6]{0x00, 0x11, 0x22, 0x33, 0x44, 0x55};
+    uint8_t nic64[8]{0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77};
+
+    Addresses() {
+        inet_pton(AF_INET, "10.0.0.1", hostA);
+        inet_pton(AF_INET, "192.168.1.1", gateway);
+        inet_pton(AF_INET6, "2001:db8::1", hostB);
+    }
+};
+
+} // namespace
+
+// name-resolution.pcapng: 5 packets, NRB (10.0.0.1, 2001:db8::1, EUI-48, EUI-64),
+// 10 packets, NRB (192.168.1.1, 10.0.0.1 renamed), 5 packets
+TEST(NameResolution, BuiltWhileReading) {
+    Addresses addresses;
+    mmpr::MMPcapNgReader reader("tracefiles/name-resolution.pcapng");
+    reader.open();
+
+    // nothing passed yet
+    ASSERT_TRUE(reader.resolveName(NameResolutionTable::IPV4, addresses.hostA).empty());
+
+    mmpr::Packet packet;
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(reader.readNextPacket(packet));
+    }
+    ASSERT_EQ(reader.resolveName(NameResolutionTable::IPV4, addresses.hostA), "host-a");
+    ASSERT_EQ(reader.resolveName(NameResolutionTable::IPV6, addresses.hostB), "host-b");
+    ASSERT_EQ(reader.resolveName(NameResolutionTable::EUI48, addresses.nic), "nic");
+    ASSERT_EQ(reader.resolveName(NameResolutionTable::EUI64, addresses.nic64), "nic-64");
+    ASSERT_TRUE(
+        reader.resolveName(NameResolutionTable::IPV4, addresses.gateway).empty());
+    // same bytes, different address type
+    ASSERT_TRUE(reader.resolveName(NameResolutionTable::EUI64, addresses.hostB).empty());
+
+    size_t packets{6};
+    while (reader.readNextPacket(packet)) {
+        ++packets;
+    }
+    ASSERT_EQ(packets, 20);
+    ASSERT_EQ(reader.resolveName(NameResolutionTable::IPV4, addresses.gateway),
+              "gateway");
+    ASSERT_EQ(reader.resolveName(NameResolutionTable::IPV4, addresses.hostA),
+              "host-a-renamed");
+    ASSERT_EQ(reader.getNameResolutionTable().size(), 5);
+    reader.close();
+}
+
+TEST(NameResolution, ScanAhead) {
+    Addresses addresses;
+    mmpr::MMPcapNgReader reader("tracefiles/name-resolution.pcapng");
+    for (int i = 0; i < 2; ++i) {
+        // reopening forgets the names of the previous mapping
+        reader.open();
+        reader.scanNameResolutionBlocks();
+        ASSERT_EQ(reader.getCurrentOffset(), 0);
+        ASSERT_EQ(reader.resolveName(NameResolutionTable::IPV4, addresses.gateway),
+                  "gateway");
+
+        // blocks recorded by the scan are not recorded again while reading
+        size_t packets{0};
+        mmpr::Packet packet;
+        while (reader.readNextPacket(packet)) {
+            ++packets;
+        }
+        ASSERT_EQ(packets, 20);
+        ASSERT_EQ(reader.getNameResolutionTable().size(), 5);
+        ASSERT_EQ(reader.resolveName(NameResolutionTable::IPV4, addresses.hostA),
+                  "host-a-renamed");
+        reader.close();
+    }
+}
+
+TEST(NameResolution, TableGrows) {
+    NameResolutionTable table;
+    const char* names = "abcdefghijklmnopqrstuvwxyz";
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t address = htonl(i);
+        table.insert(NameResolutionTable::IPV4, reinterpret_cast<uint8_t*>(&address),
+                     std::string_view(&names[i % 26], 1));
+    }
+    ASSERT_EQ(table.size(), 1000);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        uint32_t address = htonl(i);
+        ASSERT_EQ(table.lookup(NameResolutionTable::IPV4,
+                               reinterpret_cast<uint8_t*>(&address)),
+                  std::string_view(&names[i % 26], 1));
+    }
+    uint32_t missing = htonl(1000);
+    ASSERT_TRUE(
+        table.lookup(NameResolutionTable::IPV4, reinterpret_cast<uint8_t*>(&missing))
+            .empty());
+}
@@ -0,0 +1,83 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/PacketDispatcher.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <cstring>
+#include <mutex>
+
+// epb-options.pcapng holds the first 20 packets of example.pcap, 16 in a little-endian
+// and 4 in a big-endian section. Every packet i with i % 4 != 3 has the options
+// flags = (inbound for even i, outbound for odd i) | FCS length 4, Toeplitz hash
+// 0x9E3779B9 * (i + 1), dropcount i, packetid 1000 + i and queue i % 4. Packet 0 also
+// has a comment.
+namespace {
+
+uint32_t expectedHash(uint32_t i) {
+    return 0x9E3779B9 * (i + 1);
+}
+
+} // namespace
+
+TEST(PacketOptions, DecodeEnhancedPacketBlockOptions) {
+    mmpr::MMPcapReader pcapReader("tracefiles/example.pcap");
+    mmpr::MMPcapNgReader reader("tracefiles/epb-options.pcapng");
+    pcapReader.open();
+    reader.open();
+
+    uint32_t i = 0;
+    mmpr::Packet expected;
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+        ASSERT_TRUE(pcapReader.readNextPacket(expected));
+        ASSERT_EQ(packet.captureLength, expected.captureLength);
+        ASSERT_EQ(memcmp(packet.data, expected.data, packet.captureLength), 0);
+        ASSERT_EQ(packet.timestamp / 1000, expected.timestamp / 1000);
+
+        mmpr::PacketOptions options;
+        if (i % 4 == 3) {
+            ASSERT_EQ(packet.optionsBlock, nullptr) << "packet " << i;
+            ASSERT_FALSE(mmpr::PcapNgReader::readPacketOptions(packet, options));
+        } else {
+            ASSERT_TRUE(mmpr::PcapNgReader::readPacketOptions(packet, options))
+                << "packet " << i;
+            ASSERT_EQ(options.direction(), i % 2 == 0 ? mmpr::PacketOptions::INBOUND
+                                                      : mmpr::PacketOptions::OUTBOUND);
+            ASSERT_EQ(*options.flags >> 5 & 0xF, 4);
+            ASSERT_EQ(options.hashAlgorithm, 5);
+            ASSERT_EQ(options.hashLength, 4);
+            ASSERT_EQ(options.hash32(), expectedHash(i));
+            ASSERT_EQ(options.dropCount, i);
+            ASSERT_EQ(options.packetId, 1000 + i);
+            ASSERT_EQ(options.queue, i % 4);
+        }
+        ++i;
+    }
+    ASSERT_EQ(i, 20);
+
+    pcapReader.close();
+    reader.close();
+}
+
+TEST(PacketOptions, DispatchByCaptureHash) {
+    mmpr::MMPcapNgReader reader("tracefiles/epb-options.pcapng");
+    reader.open();
+
+    mmpr::PacketDispatcher::Config config;
+    config.workers = 4;
+    config.useCaptureHash = true;
+    mmpr::PacketDispatcher dispatcher(reader, config);
+
+    std::mutex mutex;
+    size_t packets{0};
+    dispatcher.run([&](size_t worker, const mmpr::Packet& packet) {
+        mmpr::PacketOptions options;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (mmpr::PcapNgReader::readPacketOptions(packet, options)) {
+            EXPECT_EQ(worker, mmpr::PacketDispatcher::selectWorker(options.hash32(), 4));
+        }
+        ++packets;
+    });
+    EXPECT_EQ(packets, 20);
+    reader.close();
+}
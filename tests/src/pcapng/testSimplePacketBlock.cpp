@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/forEachPacket.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <algorithm>
+#include <cstring>
+
+// simple-packet-blocks.pcapng holds the first 64 packets of example.pcap as Simple
+// Packet Blocks of an interface with snaplen 96, packet 10 is cut to 40 bytes
+TEST(SimplePacketBlock, CaptureLengthFromSnapLengthAndBlockLength) {
+    mmpr::MMPcapReader pcapReader("tracefiles/example.pcap");
+    mmpr::MMPcapNgReader reader("tracefiles/simple-packet-blocks.pcapng");
+    pcapReader.open();
+    reader.open();
+
+    size_t packets{0};
+    mmpr::Packet expected;
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+        ASSERT_TRUE(pcapReader.readNextPacket(expected));
+        const uint32_t captureLength =
+            packets == 10 ? 40 : std::min<uint32_t>(expected.captureLength, 96);
+        ASSERT_EQ(packet.captureLength, captureLength) << "packet " << packets;
+        ASSERT_EQ(packet.length, expected.length);
+        ASSERT_EQ(memcmp(packet.data, expected.data, captureLength), 0);
+        ASSERT_EQ(packet.interfaceIndex, 0);
+        ASSERT_EQ(packet.timestamp, 0);
+        ++packets;
+    }
+    ASSERT_EQ(packets, 64);
+    ASSERT_EQ(reader.getInterfaceDescriptor(0).snapLength, 96);
+
+    pcapReader.close();
+    reader.close();
+}
+
+TEST(SimplePacketBlock, ForEachPacketAndReadBlock) {
+    mmpr::MMPcapNgReader reader("tracefiles/simple-packet-blocks.pcapng");
+    reader.open();
+    uint64_t bytes{0};
+    size_t packets = mmpr::forEachPacket(
+        reader, [&bytes](const mmpr::Packet& packet) { bytes += packet.captureLength; });
+    ASSERT_EQ(packets, 64);
+    reader.close();
+
+    reader.open();
+    size_t simplePacketBlocks{0};
+    while (!reader.isExhausted()) {
+        if (reader.readBlock() == MMPR_SIMPLE_PACKET_BLOCK) {
+            ++simplePacketBlocks;
+        }
+    }
+    ASSERT_EQ(simplePacketBlocks, 64);
+    reader.close();
+}
+
+TEST(SimplePacketBlock, NoOptionsOfPreviousPacket) {
+    // the packet is reused after an Enhanced Packet Block of another byte order
+    mmpr::MMPcapNgReader epbReader("tracefiles/big-endian.pcapng");
+    epbReader.open();
+    mmpr::Packet packet;
+    ASSERT_TRUE(epbReader.readNextPacket(packet));
+    packet.optionsBlock = packet.data;
+    ASSERT_TRUE(packet.optionsSwapped);
+    epbReader.close();
+
+    mmpr::MMPcapNgReader reader("tracefiles/simple-packet-blocks.pcapng");
+    reader.open();
+    ASSERT_TRUE(reader.readNextPacket(packet));
+    ASSERT_EQ(packet.optionsBlock, nullptr);
+    ASSERT_FALSE(packet.optionsSwapped);
+    reader.close();
+}
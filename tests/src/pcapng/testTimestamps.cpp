@@ -0,0 +1,148 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+uint64_t referenceNanoseconds(uint8_t tsresol, uint64_t timestamp) {
+    const uint8_t exponent = tsresol & 0x7F;
+    __uint128_t numerator = (__uint128_t)timestamp * 1000000000ULL;
+    __uint128_t denominator = 1;
+    for (uint8_t i = 0; i < exponent; ++i) {
+        denominator *= (tsresol & 0x80) ? 2 : 10;
+    }
+    return (uint64_t)(numerator / denominator);
+}
+
+void append32(std::vector<uint8_t>& buffer, uint32_t value) {
+    buffer.insert(buffer.end(), (uint8_t*)&value, (uint8_t*)&value + 4);
+}
+
+void appendIDB(std::vector<uint8_t>& buffer, uint8_t tsresol, int64_t tsoffset) {
+    append32(buffer, MMPR_INTERFACE_DESCRIPTION_BLOCK);
+    append32(buffer, 44);
+    append32(buffer, 1 /* Ethernet */);
+    append32(buffer, 65535);
+    append32(buffer, MMPR_BLOCK_OPTION_IDB_TSRESOL | 1 << 16);
+    append32(buffer, tsresol);
+    append32(buffer, MMPR_BLOCK_OPTION_IDB_TSOFFSET | 8 << 16);
+    buffer.insert(buffer.end(), (uint8_t*)&tsoffset, (uint8_t*)&tsoffset + 8);
+    append32(buffer, 0);
+    append32(buffer, 44);
+}
+
+void appendEPB(std::vector<uint8_t>& buffer, uint32_t interfaceId, uint64_t timestamp) {
+    append32(buffer, MMPR_ENHANCED_PACKET_BLOCK);
+    append32(buffer, 36);
+    append32(buffer, interfaceId);
+    append32(buffer, (uint32_t)(timestamp >> 32));
+    append32(buffer, (uint32_t)timestamp);
+    append32(buffer, 4);
+    append32(buffer, 4);
+    append32(buffer, 0xDEADBEEF);
+    append32(buffer, 36);
+}
+
+} // namespace
+
+TEST(Timestamps, ConverterIsExact) {
+    const std::vector<uint64_t> timestamps{0,
+                                           1,
+                                           999,
+                                           1000000,
+                                           1657440000123456ULL,
+                                           1657440000123456789ULL,
+                                           0xFFFFFFFFFFFFFFFFULL / 1000000000ULL};
+    for (uint8_t tsresol : {0, 3, 6, 9}) {
+        mmpr::TimestampConverter converter(tsresol, 0);
+        for (uint64_t timestamp : timestamps) {
+            ASSERT_EQ(converter.toNanoseconds(timestamp),
+                      referenceNanoseconds(tsresol, timestamp))
+                << "tsresol: " << (int)tsresol << ", timestamp: " << timestamp;
+        }
+    }
+
+    const std::vector<uint64_t> wideTimestamps{0,
+                                               1,
+                                               12345,
+                                               1657440000123456789ULL,
+                                               0x8000000000000001ULL,
+                                               0xFFFFFFFFFFFFFFFFULL};
+    for (uint8_t tsresol : {10, 12, 15, 18, 28, 0x80, 0x80 | 10, 0x80 | 20, 0x80 | 32,
+                            0x80 | 64}) {
+        mmpr::TimestampConverter converter(tsresol, 0);
+        for (uint64_t timestamp : wideTimestamps) {
+            ASSERT_EQ(converter.toNanoseconds(timestamp),
+                      referenceNanoseconds(tsresol, timestamp))
+                << "tsresol: " << (int)tsresol << ", timestamp: " << timestamp;
+        }
+    }
+
+    mmpr::TimestampConverter withOffset(6, -2);
+    ASSERT_EQ(withOffset.toNanoseconds(3000001), 1000001000ULL);
+}
+
+TEST(Timestamps, PerInterfaceResolution) {
+    std::vector<uint8_t> trace;
+    // Section Header Block without options
+    append32(trace, MMPR_SECTION_HEADER_BLOCK);
+    append32(trace, 28);
+    append32(trace, 0x1A2B3C4D);
+    append32(trace, 1);
+    append32(trace, 0xFFFFFFFF);
+    append32(trace, 0xFFFFFFFF);
+    append32(trace, 28);
+    appendIDB(trace, 6, 0);
+    appendIDB(trace, 9, 100);
+    appendIDB(trace, 0x80 | 10, 0);
+    appendEPB(trace, 0, 1657440000123456ULL);
+    appendEPB(trace, 1, 1657440000123456789ULL);
+    appendEPB(trace, 2, 1024ULL * 1657440000ULL + 512);
+
+    std::string filepath = "mmpr_test_timestamps.pcapng";
+    std::ofstream(filepath, std::ios::binary)
+        .write(reinterpret_cast<const char*>(trace.data()), trace.size());
+
+    mmpr::MMPcapNgReader reader{filepath};
+    reader.open();
+    std::vector<mmpr::Packet> packets;
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+        packets.push_back(packet);
+    }
+    reader.close();
+    std::remove(filepath.c_str());
+
+    ASSERT_EQ(packets.size(), 3);
+    ASSERT_EQ(reader.getInterfaceDescriptors().size(), 3);
+    ASSERT_EQ(reader.getInterfaceDescriptor(1).tsresol, 9);
+    ASSERT_EQ(reader.getInterfaceDescriptor(1).tsoffset, 100);
+
+    ASSERT_EQ(packets[0].timestamp, 1657440000123456000ULL);
+    ASSERT_EQ(packets[0].timestampSeconds, 1657440000);
+    ASSERT_EQ(packets[0].timestampMicroseconds, 123456);
+
+    ASSERT_EQ(packets[1].timestamp, 1657440100123456789ULL);
+    ASSERT_EQ(packets[1].timestampSeconds, 1657440100);
+    ASSERT_EQ(packets[1].timestampMicroseconds, 123456);
+
+    ASSERT_EQ(packets[2].timestamp, 1657440000500000000ULL);
+    ASSERT_EQ(packets[2].timestampSeconds, 1657440000);
+    ASSERT_EQ(packets[2].timestampMicroseconds, 500000);
+}
+
+TEST(Timestamps, PcapNanoseconds) {
+    mmpr::MMPcapReader reader{"tracefiles/example.pcap"};
+    reader.open();
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+        ASSERT_EQ(packet.timestamp, (uint64_t)packet.timestampSeconds * 1000000000 +
+                                        (uint64_t)packet.timestampMicroseconds * 1000);
+    }
+    reader.close();
+}
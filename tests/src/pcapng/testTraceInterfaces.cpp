@@ -135,4 +135,29 @@ TEST(TraceInterfaces, ReadPacket) {
     }
 
     reader.close();
-}
\ No newline at end of file
+}
+TEST(TraceInterfaces, MetadataAfterClose) {
+    std::vector<std::string> files{"tracefiles/many_interfaces-1.pcapng"};
+#ifdef MMPR_USE_ZSTD
+    files.emplace_back("tracefiles/pcapng-example.pcapng.zst");
+#endif
+    for (const auto& file : files) {
+        auto fileReader = mmpr::FileReader::getReader(file);
+        auto* reader = dynamic_cast<mmpr::PcapNgReader*>(fileReader.get());
+        ASSERT_NE(reader, nullptr) << file;
+        reader->open();
+        mmpr::Packet packet;
+        while (!reader->isExhausted()) {
+            reader->readNextPacket(packet);
+        }
+        ASSERT_FALSE(reader->getTraceInterfaces().empty()) << file;
+        reader->close();
+
+        // the views pointed into the mapping, nothing of it is left after close()
+        EXPECT_TRUE(reader->getTraceInterfaces().empty()) << file;
+        EXPECT_EQ(reader->getComment(), "") << file;
+        EXPECT_EQ(reader->getOS(), "") << file;
+        EXPECT_EQ(reader->getHardware(), "") << file;
+        EXPECT_EQ(reader->getUserApplication(), "") << file;
+    }
+}
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+
+#include "CorruptedTrace.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+
+const mmpr::ValidationLevel LEVELS[]{mmpr::ValidationLevel::NONE,
+                                     mmpr::ValidationLevel::CHEAP,
+                                     mmpr::ValidationLevel::FULL};
+
+size_t countPackets(const std::string& filepath, mmpr::ValidationLevel level) {
+    mmpr::MMPcapNgReader reader(filepath);
+    reader.setValidationLevel(level);
+    reader.open();
+    size_t packets{0};
+    mmpr::Packet packet;
+    try {
+        while (reader.readNextPacket(packet)) {
+            ++packets;
+        }
+    } catch (...) {
+        reader.close();
+        throw;
+    }
+    reader.close();
+    return packets;
+}
+
+} // namespace
+
+TEST(Validation, ValidTracesAtEveryLevel) {
+    const std::pair<std::string, size_t> traces[]{
+        {"tracefiles/pcapng-example.pcapng", 159},
+        {"tracefiles/big-endian.pcapng", 159},
+        {"tracefiles/many_interfaces-1.pcapng", 64},
+        {"tracefiles/simple-packet-blocks.pcapng", 64},
+        {"tracefiles/epb-options.pcapng", 20}};
+    for (const auto& [filepath, packets] : traces) {
+        for (auto level : LEVELS) {
+            EXPECT_EQ(countPackets(filepath, level), packets) << filepath;
+        }
+    }
+}
+
+TEST(Validation, ZeroBlockTotalLengthAtEveryLevel) {
+    mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+    trace.write32(trace.findEnhancedPacketBlock(false) + 4, 0);
+    const auto& filepath = trace.save();
+    for (auto level : LEVELS) {
+        EXPECT_THROW(countPackets(filepath, level), std::runtime_error);
+    }
+}
+
+TEST(Validation, CheapLengthChecks) {
+    {
+        // truncated in the middle of the last block
+        mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+        const auto size = std::filesystem::file_size("tracefiles/pcapng-example.pcapng");
+        trace.truncate(size - 16);
+        EXPECT_THROW(countPackets(trace.save(), mmpr::ValidationLevel::CHEAP),
+                     std::runtime_error);
+    }
+    {
+        // trailing block total length does not match
+        mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+        const size_t offset = trace.findEnhancedPacketBlock(false);
+        trace.write32(offset + trace.read32(offset + 4) - 4, 4);
+        EXPECT_THROW(countPackets(trace.save(), mmpr::ValidationLevel::CHEAP),
+                     std::runtime_error);
+    }
+    {
+        // captured length beyond the block
+        mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+        const size_t offset = trace.findEnhancedPacketBlock(false);
+        trace.write32(offset + 20, 4096);
+        EXPECT_THROW(countPackets(trace.save(), mmpr::ValidationLevel::CHEAP),
+                     std::runtime_error);
+    }
+}
+
+TEST(Validation, FullOptionChecks) {
+    // option length beyond the block, only found by the option checks
+    mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+    const size_t offset = trace.findEnhancedPacketBlock(true);
+    const uint32_t captureLength = trace.read32(offset + 20);
+    trace.write16(offset + 28 + captureLength + (4 - captureLength % 4) % 4 + 2, 1024);
+    const auto& filepath = trace.save();
+    EXPECT_EQ(countPackets(filepath, mmpr::ValidationLevel::CHEAP), 159);
+    EXPECT_THROW(countPackets(filepath, mmpr::ValidationLevel::FULL), std::runtime_error);
+}
@@ -2,7 +2,12 @@
 
 #include "gtest/gtest.h"
 
+#include "mmpr/ZstdDecompressionPool.h"
+#include "mmpr/ZstdDecompressor.h"
 #include "mmpr/pcapng/ZstdPcapNgReader.h"
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 
 TEST(ZstdPcapNgReader, ConstructorSimple) {
     {
@@ -31,4 +36,60 @@ TEST(ZstdPcapNgReader, FaultyConstructor) {
     EXPECT_THROW(mmpr::ZstdPcapNgReader{""}, std::runtime_error);
 }
 
+TEST(ZstdPcapNgReader, SharedDecompressionPool) {
+    auto pool = std::make_shared<mmpr::ZstdDecompressionPool>();
+    const std::string files[2]{"tracefiles/pcapng-example.pcapng.zst",
+                               "tracefiles/pcapng-example.pcapng.zstd"};
+
+    for (int i = 0; i < 10; ++i) {
+        auto reader = mmpr::FileReader::getReader(files[i % 2], pool);
+        reader->open();
+        size_t packets{0};
+        mmpr::Packet packet;
+        while (reader->readNextPacket(packet)) {
+            ++packets;
+        }
+        reader->close();
+        ASSERT_EQ(packets, 159);
+    }
+
+    // after the first file, contexts and buffers are reused
+    auto stats = pool->getStats();
+    ASSERT_EQ(stats.decompressions, 10);
+    ASSERT_EQ(stats.contextAllocations, 1);
+    ASSERT_EQ(stats.bufferAllocations, 2);
+
+    // readers that are open at the same time get separate buffers
+    mmpr::ZstdPcapNgReader first(files[0], pool);
+    mmpr::ZstdPcapNgReader second(files[1], pool);
+    first.open();
+    second.open();
+    mmpr::Packet firstPacket;
+    mmpr::Packet secondPacket;
+    ASSERT_TRUE(first.readNextPacket(firstPacket));
+    ASSERT_TRUE(second.readNextPacket(secondPacket));
+    ASSERT_NE(firstPacket.data, secondPacket.data);
+    ASSERT_EQ(memcmp(firstPacket.data, secondPacket.data, firstPacket.captureLength), 0);
+    first.close();
+    second.close();
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+TEST(ZstdPcapNgReader, DeprecatedDecompressor) {
+    mmpr::ZstdDecompressionPool pool;
+    size_t expectedSize;
+    const uint8_t* expected =
+        pool.decompress("tracefiles/pcapng-example.pcapng.zst", expectedSize);
+
+    size_t size;
+    void* data = mmpr::ZstdDecompressor::decompressFileInMemory(
+        "tracefiles/pcapng-example.pcapng.zst", size);
+    ASSERT_EQ(size, expectedSize);
+    EXPECT_EQ(memcmp(data, expected, size), 0);
+    free(data);
+    pool.release(expected);
+}
+#pragma GCC diagnostic pop
+
 #endif
\ No newline at end of file
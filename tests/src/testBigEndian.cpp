@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/mmpr.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace {
+
+/**
+ * The big-endian trace files are byte-swapped copies of little-endian trace files, so
+ * both readers have to produce exactly the same packets.
+ */
+void compareTraces(const std::string& bigEndianFile,
+                   const std::string& littleEndianFile,
+                   size_t expectedPackets) {
+    auto bigEndianReader = mmpr::FileReader::getReader(bigEndianFile);
+    auto littleEndianReader = mmpr::FileReader::getReader(littleEndianFile);
+    bigEndianReader->open();
+    littleEndianReader->open();
+
+    mmpr::Packet bePacket;
+    mmpr::Packet lePacket;
+    size_t packets{0};
+    while (bigEndianReader->readNextPacket(bePacket)) {
+        ASSERT_TRUE(littleEndianReader->readNextPacket(lePacket)) << "packet " << packets;
+        ASSERT_EQ(bePacket.timestamp, lePacket.timestamp) << "packet " << packets;
+        ASSERT_EQ(bePacket.timestampSeconds, lePacket.timestampSeconds);
+        ASSERT_EQ(bePacket.timestampMicroseconds, lePacket.timestampMicroseconds);
+        ASSERT_EQ(bePacket.captureLength, lePacket.captureLength);
+        ASSERT_EQ(bePacket.length, lePacket.length);
+        ASSERT_EQ(bePacket.interfaceIndex, lePacket.interfaceIndex);
+        ASSERT_EQ(memcmp(bePacket.data, lePacket.data, bePacket.captureLength), 0)
+            << "packet " << packets;
+        ++packets;
+    }
+    ASSERT_EQ(packets, expectedPackets);
+    ASSERT_EQ(bigEndianReader->getDataLinkType(), littleEndianReader->getDataLinkType());
+
+    auto beInterfaces = bigEndianReader->getTraceInterfaces();
+    auto leInterfaces = littleEndianReader->getTraceInterfaces();
+    ASSERT_EQ(beInterfaces.size(), leInterfaces.size());
+    for (size_t i = 0; i < beInterfaces.size(); ++i) {
+        ASSERT_EQ(beInterfaces[i].name, leInterfaces[i].name);
+        ASSERT_EQ(beInterfaces[i].description, leInterfaces[i].description);
+        ASSERT_EQ(beInterfaces[i].filter, leInterfaces[i].filter);
+        ASSERT_EQ(beInterfaces[i].os, leInterfaces[i].os);
+    }
+
+    bigEndianReader->close();
+    littleEndianReader->close();
+}
+
+} // namespace
+
+TEST(BigEndian, Pcap) {
+    compareTraces("tracefiles/big-endian.pcap", "tracefiles/linux-cooked-unsw-nb15.pcap",
+                  100);
+}
+
+TEST(BigEndian, ModifiedPcap) {
+    compareTraces("tracefiles/big-endian-modified.pcap", "tracefiles/fritzbox-ip.pcap",
+                  5);
+}
+
+TEST(BigEndian, PcapNg) {
+    compareTraces("tracefiles/big-endian.pcapng", "tracefiles/pcapng-example.pcapng",
+                  159);
+}
+
+TEST(BigEndian, PcapNgReadBlock) {
+    std::vector<uint32_t> blockTypes[2];
+    const std::string files[2]{"tracefiles/big-endian.pcapng",
+                               "tracefiles/pcapng-example.pcapng"};
+    for (size_t i = 0; i < 2; ++i) {
+        mmpr::MMPcapNgReader reader(files[i]);
+        reader.open();
+        while (!reader.isExhausted()) {
+            blockTypes[i].push_back(reader.readBlock());
+        }
+        reader.close();
+    }
+    ASSERT_EQ(blockTypes[0], blockTypes[1]);
+}
@@ -0,0 +1,133 @@
+#ifdef MMPR_USE_ZSTD
+
+#include "gtest/gtest.h"
+
+#include "mmpr/DecompressedTraceCache.h"
+#include "mmpr/mmpr.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include "mmpr/pcapng/ZstdPcapNgReader.h"
+#include <fcntl.h>
+#include <filesystem>
+#include <memory>
+#include <unistd.h>
+
+namespace {
+
+size_t countPackets(mmpr::FileReader& reader) {
+    reader.open();
+    size_t packets{0};
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+        ++packets;
+    }
+    reader.close();
+    return packets;
+}
+
+} // namespace
+
+TEST(DecompressedTraceCache, MemoryHitsAndEviction) {
+    const std::string files[2]{"tracefiles/pcapng-example.pcapng.zst",
+                               "tracefiles/pcapng-example.pcapng.zstd"};
+    mmpr::DecompressedTraceCache::Config config;
+    // room for a single decompressed trace
+    config.byteBudget = std::filesystem::file_size("tracefiles/pcapng-example.pcapng");
+    auto cache = std::make_shared<mmpr::DecompressedTraceCache>(config);
+
+    for (int i = 0; i < 2; ++i) {
+        auto reader = mmpr::FileReader::getCachedReader(files[0], cache);
+        ASSERT_NE(dynamic_cast<mmpr::MMPcapNgReader*>(reader.get()), nullptr);
+        ASSERT_EQ(reader->getFilepath(), files[0]);
+        ASSERT_EQ(countPackets(*reader), 159);
+    }
+    auto stats = cache->getStats();
+    ASSERT_EQ(stats.misses, 1);
+    ASSERT_EQ(stats.hits, 1);
+
+    // evicts the first trace, open readers keep their copy
+    auto first = mmpr::FileReader::getCachedReader(files[0], cache);
+    auto second = mmpr::FileReader::getCachedReader(files[1], cache);
+    ASSERT_EQ(countPackets(*first), 159);
+    ASSERT_EQ(countPackets(*second), 159);
+    stats = cache->getStats();
+    ASSERT_EQ(stats.misses, 2);
+    ASSERT_EQ(stats.evictions, 1);
+}
+
+TEST(DecompressedTraceCache, Uncacheable) {
+    mmpr::DecompressedTraceCache::Config config;
+    config.byteBudget = 1;
+    auto cache = std::make_shared<mmpr::DecompressedTraceCache>(config);
+
+    auto reader =
+        mmpr::FileReader::getCachedReader("tracefiles/pcapng-example.pcapng.zst", cache);
+    ASSERT_NE(dynamic_cast<mmpr::ZstdPcapNgReader*>(reader.get()), nullptr);
+    ASSERT_EQ(countPackets(*reader), 159);
+    ASSERT_EQ(cache->getStats().uncacheable, 1);
+
+    // uncompressed files are not cached
+    reader = mmpr::FileReader::getCachedReader("tracefiles/pcapng-example.pcapng", cache);
+    ASSERT_EQ(countPackets(*reader), 159);
+    ASSERT_EQ(cache->getStats().uncacheable, 1);
+}
+
+TEST(DecompressedTraceCache, WithoutCache) {
+    // nullptr is unambiguous, neither a pool nor a cache is used
+    auto reader =
+        mmpr::FileReader::getReader("tracefiles/pcapng-example.pcapng.zst", nullptr);
+    ASSERT_NE(dynamic_cast<mmpr::ZstdPcapNgReader*>(reader.get()), nullptr);
+    ASSERT_EQ(countPackets(*reader), 159);
+
+    reader = mmpr::FileReader::getCachedReader("tracefiles/pcapng-example.pcapng.zst",
+                                               nullptr);
+    ASSERT_NE(dynamic_cast<mmpr::ZstdPcapNgReader*>(reader.get()), nullptr);
+    ASSERT_EQ(countPackets(*reader), 159);
+}
+
+TEST(DecompressedTraceCache, SharedDirectory) {
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("mmpr-cache-test-" + std::to_string(getpid()));
+    mmpr::DecompressedTraceCache::Config config;
+    config.directory = directory.string();
+    {
+        // two caches on the same directory, as used by separate processes
+        auto writer = std::make_shared<mmpr::DecompressedTraceCache>(config);
+        auto reader = std::make_shared<mmpr::DecompressedTraceCache>(config);
+
+        const std::string filepath = "tracefiles/pcapng-example.pcapng.zst";
+        auto first = mmpr::FileReader::getCachedReader(filepath, writer);
+        ASSERT_EQ(countPackets(*first), 159);
+        auto second = mmpr::FileReader::getCachedReader(filepath, reader);
+        ASSERT_NE(dynamic_cast<mmpr::MMPcapNgReader*>(second.get()), nullptr);
+        ASSERT_EQ(countPackets(*second), 159);
+
+        ASSERT_EQ(writer->getStats().misses, 1);
+        ASSERT_EQ(reader->getStats().hits, 1);
+        ASSERT_EQ(reader->getStats().misses, 0);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+TEST(DecompressedTraceCache, ReadOnlyDescriptors) {
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("mmpr-cache-read-only-" + std::to_string(getpid()));
+    mmpr::DecompressedTraceCache::Config inMemory;
+    mmpr::DecompressedTraceCache::Config inDirectory;
+    inDirectory.directory = directory.string();
+    for (const auto& config : {inMemory, inDirectory}) {
+        mmpr::DecompressedTraceCache cache(config);
+        // a miss, then a hit
+        for (int i = 0; i < 2; ++i) {
+            int fd = cache.acquire("tracefiles/pcapng-example.pcapng.zst");
+            ASSERT_GE(fd, 0);
+            EXPECT_EQ(fcntl(fd, F_GETFL) & O_ACCMODE, O_RDONLY);
+            EXPECT_LT(write(fd, "x", 1), 0);
+            close(fd);
+        }
+        EXPECT_EQ(cache.getStats().misses, 1);
+        EXPECT_EQ(cache.getStats().hits, 1);
+    }
+    std::filesystem::remove_all(directory);
+}
+
+#endif
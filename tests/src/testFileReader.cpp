@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include "mmpr/mmpr.h"
+#include "mmpr/pcapng/PcapNgReader.h"
 #include <filesystem>
 
 TEST(FileReader, GetReader) {
@@ -30,4 +31,39 @@ TEST(FileReader, GetReader) {
         }
         ASSERT_GT(processedPackets, 0) << "file: " << file;
     }
-}
\ No newline at end of file
+}
+TEST(FileReader, DataLinkTypeOfPacket) {
+    for (const std::string file :
+         {"tracefiles/example.pcap", "tracefiles/fritzbox-ip.pcap",
+          "tracefiles/many_interfaces-1.pcapng", "tracefiles/pcapng-example.pcapng"}) {
+        auto reader = mmpr::FileReader::getReader(file);
+        reader->open();
+        auto* pcapNgReader = dynamic_cast<mmpr::PcapNgReader*>(reader.get());
+        mmpr::Packet packet;
+        while (reader->readNextPacket(packet)) {
+            if (pcapNgReader != nullptr) {
+                ASSERT_EQ(reader->getDataLinkType(packet),
+                          pcapNgReader->getInterfaceDescriptor(packet.interfaceIndex)
+                              .linkType)
+                    << file;
+            } else {
+                ASSERT_EQ(reader->getDataLinkType(packet), reader->getDataLinkType())
+                    << file;
+            }
+        }
+        reader->close();
+    }
+}
+TEST(FileReader, NoMappingAfterClose) {
+    for (const std::string file :
+         {"tracefiles/example.pcap", "tracefiles/big-endian-modified.pcap",
+          "tracefiles/pcapng-example.pcapng"}) {
+        auto reader = mmpr::FileReader::getReader(file);
+        reader->open();
+        ASSERT_NE(reader->getMappedMemory(), nullptr) << file;
+        ASSERT_GE(reader->getMappedFileDescriptor(), 0) << file;
+        reader->close();
+        ASSERT_EQ(reader->getMappedMemory(), nullptr) << file;
+        ASSERT_EQ(reader->getMappedFileDescriptor(), -1) << file;
+    }
+}
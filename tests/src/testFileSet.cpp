@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/FileSet.h"
+#include "mmpr/mmpr.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+namespace {
+
+size_t countPackets(mmpr::FileReader& reader) {
+    reader.open();
+    size_t packets{0};
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+        ++packets;
+    }
+    reader.close();
+    return packets;
+}
+
+} // namespace
+
+TEST(FileSet, ListsAndReadsDirectory) {
+    mmpr::FileSet files("tracefiles");
+
+    std::vector<std::string> expected;
+    for (const auto& file : std::filesystem::directory_iterator("tracefiles")) {
+        expected.push_back(file.path().filename().string());
+    }
+    std::sort(expected.begin(), expected.end());
+    ASSERT_EQ(files.getNames(), expected);
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        const std::string path = files.getPath(i);
+        ASSERT_EQ(path, "tracefiles/" + files.getNames()[i]);
+#ifndef MMPR_USE_ZSTD
+        if (path.find(".zst") != std::string::npos) {
+            continue;
+        }
+#endif
+        auto reader = files.getReader(i);
+        ASSERT_EQ(reader->getFilepath(), path);
+        auto byPath = mmpr::FileReader::getReader(path);
+        ASSERT_EQ(countPackets(*reader), countPackets(*byPath)) << path;
+        // a reader of an opened file can be opened again
+        ASSERT_EQ(countPackets(*reader), countPackets(*byPath)) << path;
+    }
+}
+
+TEST(FileSet, SkipsDirectoriesAndRejectsUnknownFormats) {
+    auto directory = std::filesystem::temp_directory_path() /
+                     ("mmpr-fileset-test-" + std::to_string(getpid()));
+    std::filesystem::create_directories(directory / "subdirectory");
+    std::ofstream(directory / "notes.txt") << "not a trace";
+    std::filesystem::copy_file("tracefiles/example.pcap", directory / "example.pcap");
+    {
+        mmpr::FileSet files(directory.string());
+        ASSERT_EQ(files.getNames(),
+                  (std::vector<std::string>{"example.pcap", "notes.txt"}));
+        ASSERT_EQ(countPackets(*files.getReader(0)), 4631);
+        ASSERT_THROW(files.getReader(1), std::runtime_error);
+        ASSERT_THROW(files.getReader(2), std::out_of_range);
+    }
+    std::filesystem::remove_all(directory);
+
+    ASSERT_THROW(mmpr::FileSet("missing-directory"), std::runtime_error);
+}
@@ -0,0 +1,65 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/forEachPacket.h"
+#include "mmpr/mmpr.h"
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+TEST(ForEachPacket, MatchesReadNextPacket) {
+    for (auto& p : std::filesystem::directory_iterator("tracefiles/")) {
+        std::string file = p.path().string();
+#ifndef MMPR_USE_ZSTD
+        if (file.find(".zst") != std::string::npos) {
+            continue;
+        }
+#endif
+        std::vector<mmpr::Packet> expected;
+        auto expectedReader = mmpr::FileReader::getReader(file);
+        expectedReader->open();
+        mmpr::Packet packet;
+        while (expectedReader->readNextPacket(packet)) {
+            expected.push_back(packet);
+        }
+
+        std::vector<mmpr::Packet> actual;
+        auto reader = mmpr::FileReader::getReader(file);
+        reader->open();
+        size_t count = mmpr::forEachPacket(
+            *reader, [&](const mmpr::Packet& packet) { actual.push_back(packet); });
+
+        ASSERT_EQ(count, expected.size()) << "file: " << file;
+        ASSERT_EQ(actual.size(), expected.size()) << "file: " << file;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_EQ(actual[i].timestamp, expected[i].timestamp) << "file: " << file;
+            ASSERT_EQ(actual[i].captureLength, expected[i].captureLength);
+            ASSERT_EQ(actual[i].length, expected[i].length);
+            ASSERT_EQ(actual[i].interfaceIndex, expected[i].interfaceIndex);
+            ASSERT_EQ(
+                memcmp(actual[i].data, expected[i].data, expected[i].captureLength), 0);
+        }
+        reader->close();
+        expectedReader->close();
+    }
+}
+
+TEST(ForEachPacket, EarlyExit) {
+    auto reader = mmpr::FileReader::getReader("tracefiles/pcapng-example.pcapng");
+    reader->open();
+    size_t calls{0};
+    size_t count = mmpr::forEachPacket(*reader, [&](const mmpr::Packet&) {
+        ++calls;
+        return calls < 10;
+    });
+    ASSERT_EQ(count, 10);
+    ASSERT_EQ(calls, 10);
+
+    // the reader continues after the last packet handed out
+    mmpr::Packet packet;
+    size_t remaining{0};
+    while (reader->readNextPacket(packet)) {
+        ++remaining;
+    }
+    reader->close();
+    ASSERT_EQ(10 + remaining, 159);
+}
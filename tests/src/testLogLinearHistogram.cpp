@@ -0,0 +1,114 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/LogLinearHistogram.h"
+#include "mmpr/PacketHistograms.h"
+#include <random>
+
+using mmpr::LogLinearHistogram;
+
+TEST(LogLinearHistogram, BucketBounds) {
+    // buckets are contiguous and cover the whole 64-bit range
+    EXPECT_EQ(LogLinearHistogram::bucketLowerBound(0), 0u);
+    for (size_t i = 1; i < LogLinearHistogram::BUCKETS; ++i) {
+        ASSERT_EQ(LogLinearHistogram::bucketLowerBound(i),
+                  LogLinearHistogram::bucketUpperBound(i - 1) + 1)
+            << "bucket " << i;
+    }
+    EXPECT_EQ(LogLinearHistogram::bucketUpperBound(LogLinearHistogram::BUCKETS - 1),
+              UINT64_MAX);
+
+    std::mt19937_64 random(42);
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t value = random() >> (random() % 64);
+        const size_t index = LogLinearHistogram::bucketIndex(value);
+        ASSERT_LT(index, LogLinearHistogram::BUCKETS);
+        ASSERT_LE(LogLinearHistogram::bucketLowerBound(index), value);
+        ASSERT_GE(LogLinearHistogram::bucketUpperBound(index), value);
+        // relative width of at most 1/16th
+        const uint64_t width = LogLinearHistogram::bucketUpperBound(index) -
+                               LogLinearHistogram::bucketLowerBound(index);
+        ASSERT_LE(width, LogLinearHistogram::bucketLowerBound(index) / 16);
+    }
+}
+
+TEST(LogLinearHistogram, Quantiles) {
+    LogLinearHistogram histogram;
+    EXPECT_EQ(histogram.valueAtQuantile(0.5), 0u);
+
+    for (uint64_t value = 1; value <= 10000; ++value) {
+        histogram.record(value);
+    }
+    EXPECT_EQ(histogram.getCount(), 10000u);
+    EXPECT_EQ(histogram.getMin(), 1u);
+    EXPECT_EQ(histogram.getMax(), 10000u);
+    EXPECT_DOUBLE_EQ(histogram.getMean(), 5000.5);
+    EXPECT_EQ(histogram.valueAtQuantile(0), 1u);
+    EXPECT_EQ(histogram.valueAtQuantile(1), 10000u);
+    for (double quantile : {0.5, 0.9, 0.99, 0.999}) {
+        const double value = histogram.valueAtQuantile(quantile);
+        EXPECT_GE(value, quantile * 10000) << quantile;
+        EXPECT_LE(value, quantile * 10000 * 1.0625) << quantile;
+    }
+
+    // small values are exact
+    LogLinearHistogram small;
+    for (uint64_t value : {3, 3, 7, 20, 31}) {
+        small.record(value);
+    }
+    EXPECT_EQ(small.valueAtQuantile(0.4), 3u);
+    EXPECT_EQ(small.valueAtQuantile(0.6), 7u);
+    EXPECT_EQ(small.valueAtQuantile(0.8), 20u);
+}
+
+TEST(LogLinearHistogram, MergeEqualsRecordingEverything) {
+    std::mt19937_64 random(7);
+    LogLinearHistogram all;
+    LogLinearHistogram parts[3];
+    for (int i = 0; i < 30000; ++i) {
+        const uint64_t value = random() % 1000000;
+        all.record(value);
+        parts[i % 3].record(value);
+    }
+    LogLinearHistogram merged;
+    for (const auto& part : parts) {
+        merged.merge(part);
+    }
+    EXPECT_EQ(merged, all);
+    EXPECT_EQ(merged.valueAtQuantile(0.99), all.valueAtQuantile(0.99));
+}
+
+TEST(PacketHistograms, InterfacesAndInterArrivalTimes) {
+    mmpr::PacketHistograms histograms;
+    mmpr::Packet packet;
+    packet.captureLength = 60;
+    packet.length = 1500;
+    for (uint64_t timestamp : {1000, 1100, 1300, 1250}) {
+        packet.timestamp = timestamp;
+        histograms.record(packet);
+    }
+    packet.interfaceIndex = 2;
+    packet.timestamp = 5000;
+    histograms.record(packet);
+
+    ASSERT_EQ(histograms.getInterfaces().size(), 3u);
+    const auto& first = histograms.getInterfaces()[0];
+    EXPECT_EQ(first.length.getCount(), 4u);
+    EXPECT_EQ(first.captureLength.getMax(), 60u);
+    // 100, 200 and 0 for the packet before its predecessor
+    EXPECT_EQ(first.interArrival.getCount(), 3u);
+    EXPECT_EQ(first.interArrival.getSum(), 300u);
+    EXPECT_EQ(first.interArrival.getMin(), 0u);
+    EXPECT_EQ(histograms.getInterfaces()[1].length.getCount(), 0u);
+    EXPECT_EQ(histograms.getInterfaces()[2].interArrival.getCount(), 0u);
+
+    // the first packet of the next trace has no predecessor
+    histograms.startTrace();
+    packet.timestamp = 10;
+    histograms.record(packet);
+    EXPECT_EQ(histograms.getInterfaces()[2].interArrival.getCount(), 0u);
+
+    mmpr::PacketHistograms merged;
+    merged.merge(histograms);
+    merged.merge(mmpr::PacketHistograms());
+    EXPECT_EQ(merged, histograms);
+}
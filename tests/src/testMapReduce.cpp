@@ -0,0 +1,305 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/MapReduceJob.h"
+#include "mmpr/PacketDispatcher.h"
+#include "mmpr/TraceSummary.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+mmpr::TraceSummary summarize(const std::string& filepath) {
+    return mmpr::MapReduceJob::map({filepath, 0, UINT64_MAX});
+}
+
+std::filesystem::path jobDirectory(const std::string& name) {
+    return std::filesystem::temp_directory_path() /
+           ("mmpr-map-reduce-" + name + "-" + std::to_string(getpid()));
+}
+
+} // namespace
+
+TEST(TraceSummary, FlowsWithCollidingHashes) {
+    // Ethernet + IPv4 + UDP from 10.x.y.z:1000 to 192.168.0.1:53
+    const auto udpPacket = [](uint32_t source) {
+        std::vector<uint8_t> data(42);
+        data[12] = 0x08;
+        data[14] = 0x45;
+        data[23] = 17;
+        data[26] = 10;
+        data[27] = (uint8_t)(source >> 16);
+        data[28] = (uint8_t)(source >> 8);
+        data[29] = (uint8_t)source;
+        const uint8_t destination[4]{192, 168, 0, 1};
+        memcpy(&data[30], destination, 4);
+        data[34] = 0x03;
+        data[35] = 0xE8;
+        data[37] = 53;
+        return data;
+    };
+    const auto packetOf = [](const std::vector<uint8_t>& data) {
+        mmpr::Packet packet;
+        packet.data = data.data();
+        packet.captureLength = packet.length = (uint32_t)data.size();
+        return packet;
+    };
+
+    // by the birthday bound, a few hundred thousand flows share a 32-bit hash
+    std::unordered_map<uint32_t, uint32_t> sources;
+    std::vector<uint8_t> first;
+    std::vector<uint8_t> second;
+    for (uint32_t source = 0; source < (1 << 24) && first.empty(); ++source) {
+        const std::vector<uint8_t> data = udpPacket(source);
+        const uint32_t hash = mmpr::PacketDispatcher::flowHash(packetOf(data), 1);
+        auto [it, inserted] = sources.emplace(hash, source);
+        if (!inserted) {
+            first = udpPacket(it->second);
+            second = data;
+        }
+    }
+    ASSERT_FALSE(first.empty());
+
+    mmpr::TraceSummary summary;
+    summary.add(packetOf(first), 1);
+    summary.add(packetOf(second), 1);
+    summary.add(packetOf(second), 1);
+    ASSERT_EQ(summary.flows.size(), 2u);
+    mmpr::FlowKey key;
+    ASSERT_TRUE(mmpr::PacketDispatcher::flowKey(packetOf(second), 1, key));
+    EXPECT_EQ(summary.flows.at(key).packets, 2u);
+    EXPECT_EQ(mmpr::TraceSummary::deserialize(summary.serialize()), summary);
+}
+
+TEST(TraceSummary, SerializationRoundTrip) {
+    const mmpr::TraceSummary summary = summarize("tracefiles/example.pcap");
+    ASSERT_EQ(summary.packets, 4631u);
+    ASSERT_GT(summary.flows.size(), 1u);
+
+    const std::string data = summary.serialize();
+    EXPECT_EQ(mmpr::TraceSummary::deserialize(data), summary);
+    // varints and 4 byte IPv4 addresses, far below the 45 bytes of fixed-size flows
+    EXPECT_LT(data.size(), summary.flows.size() * 24);
+
+    EXPECT_EQ(mmpr::TraceSummary::deserialize(mmpr::TraceSummary().serialize()),
+              mmpr::TraceSummary());
+    EXPECT_THROW(mmpr::TraceSummary::deserialize(data.substr(0, data.size() - 1)),
+                 std::runtime_error);
+    EXPECT_THROW(mmpr::TraceSummary::deserialize("not a summary"), std::runtime_error);
+}
+
+TEST(TraceSummary, MergeIsAssociativeAndCommutative) {
+    const mmpr::TraceSummary a = summarize("tracefiles/example.pcap");
+    const mmpr::TraceSummary b = summarize("tracefiles/pcapng-example.pcapng");
+    const mmpr::TraceSummary c = summarize("tracefiles/many_interfaces-1.pcapng");
+
+    mmpr::TraceSummary left = a;
+    left.merge(b);
+    left.merge(c);
+    mmpr::TraceSummary right = b;
+    right.merge(c);
+    mmpr::TraceSummary grouped = a;
+    grouped.merge(right);
+    mmpr::TraceSummary reversed = c;
+    reversed.merge(b);
+    reversed.merge(a);
+
+    EXPECT_EQ(left, grouped);
+    EXPECT_EQ(left, reversed);
+    EXPECT_EQ(left.packets, a.packets + b.packets + c.packets);
+    EXPECT_EQ(left.firstTimestamp,
+              std::min({a.firstTimestamp, b.firstTimestamp, c.firstTimestamp}));
+}
+
+TEST(MapReduce, PcapRangesReadEveryRecordOnce) {
+    const std::string filepath = "tracefiles/example.pcap";
+    const mmpr::TraceSummary whole = summarize(filepath);
+    const uint64_t fileSize = std::filesystem::file_size(filepath);
+
+    for (uint64_t splitSize : {1000ull, 4096ull, 65536ull, 1000000ull}) {
+        mmpr::TraceSummary merged;
+        mmpr::MapReduceJob::ReadExtent previous;
+        for (uint64_t begin = 0; begin < fileSize; begin += splitSize) {
+            const uint64_t end = begin + splitSize < fileSize ? begin + splitSize
+                                                              : UINT64_MAX;
+            mmpr::MapReduceJob::ReadExtent extent;
+            merged.merge(mmpr::MapReduceJob::map({filepath, begin, end}, &extent));
+            if (begin == 0) {
+                EXPECT_EQ(extent.first, 24u);
+            } else {
+                EXPECT_EQ(extent.first, previous.end) << "range at " << begin;
+            }
+            previous = extent;
+        }
+        EXPECT_EQ(previous.end, fileSize);
+        EXPECT_EQ(merged, whole) << "split size " << splitSize;
+    }
+
+    EXPECT_THROW(mmpr::MapReduceJob::map({"tracefiles/pcapng-example.pcapng", 0, 4096}),
+                 std::runtime_error);
+}
+
+TEST(MapReduce, ReduceRemapsRangesThatDoNotMeet) {
+    // a record whose packet data holds a chain of plausible records, which a range that
+    // begins inside of it takes for the next records
+    const auto filepath = jobDirectory("false-chain").string() + ".pcap";
+    {
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        const auto write32 = [&file](uint32_t value) {
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        };
+        const auto writeRecordHeader = [&write32](uint32_t length) {
+            write32(1600000000);
+            write32(0);
+            write32(length);
+            write32(length);
+        };
+        const std::string pattern(2000, '\xAB');
+        write32(0xA1B2C3D4);
+        write32(0x00040002);
+        write32(0);
+        write32(0);
+        write32(262144);
+        write32(1);
+        for (int i = 0; i < 3; ++i) {
+            writeRecordHeader(100);
+            file.write(pattern.data(), 100);
+        }
+        // at offset 372, the false chain starts at 488
+        writeRecordHeader(2000);
+        file.write(std::string(100, '\0').data(), 100);
+        for (int i = 0; i < 10; ++i) {
+            writeRecordHeader(50);
+            file.write(std::string(50, '\0').data(), 50);
+        }
+        file.write(std::string(2000 - 100 - 10 * 66, '\0').data(), 2000 - 100 - 10 * 66);
+        for (int i = 0; i < 20; ++i) {
+            writeRecordHeader(100);
+            file.write(pattern.data(), 100);
+        }
+    }
+    const mmpr::TraceSummary whole = summarize(filepath);
+    ASSERT_EQ(whole.packets, 24u);
+
+    const auto directory = jobDirectory("remap");
+    mmpr::MapReduceJob job(directory.string());
+    job.plan({filepath}, 400);
+    ASSERT_GT(job.getItems().size(), 3u);
+
+    // merging the summaries without verification counts the false records
+    mmpr::TraceSummary unverified;
+    for (const auto& item : job.getItems()) {
+        unverified.merge(mmpr::MapReduceJob::map(item));
+    }
+    EXPECT_FALSE(unverified == whole);
+
+    EXPECT_EQ(job.work(), job.getItems().size());
+    EXPECT_EQ(job.reduce(), whole);
+    EXPECT_EQ(job.getRemappedItems(), 1u);
+    // the replaced summaries meet
+    EXPECT_EQ(job.reduce(), whole);
+    EXPECT_EQ(job.getRemappedItems(), 0u);
+
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove(filepath);
+}
+
+TEST(MapReduce, WorkerProcesses) {
+    const std::vector<std::string> files{"tracefiles/example.pcap",
+                                         "tracefiles/pcapng-example.pcapng",
+                                         "tracefiles/many_interfaces-1.pcapng"};
+    mmpr::TraceSummary expected;
+    for (const auto& file : files) {
+        expected.merge(summarize(file));
+    }
+
+    const auto directory = jobDirectory("workers");
+    mmpr::MapReduceJob job(directory.string());
+    job.plan(files, 100000);
+    // example.pcap is split, the PcapNG files are not
+    const size_t items = job.getItems().size();
+    ASSERT_GT(items, files.size());
+    job.runWorkers(4);
+    EXPECT_EQ(job.reduce(), expected);
+
+    // a second job object on the same directory, as on another host
+    mmpr::MapReduceJob merger(directory.string());
+    EXPECT_EQ(merger.getItems().size(), items);
+    EXPECT_EQ(merger.reduce(), expected);
+    // everything is claimed already
+    EXPECT_EQ(merger.work(), 0u);
+
+    // a new plan discards the previous results
+    job.plan(files, 0);
+    EXPECT_EQ(job.getItems().size(), files.size());
+    EXPECT_THROW(job.reduce(), std::runtime_error);
+    EXPECT_EQ(job.work(), files.size());
+    EXPECT_EQ(job.reduce(), expected);
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(MapReduce, FailingWorker) {
+    const auto directory = jobDirectory("failing");
+    const auto missing = directory.string() + "-missing.pcap";
+    std::filesystem::copy_file("tracefiles/example.pcap", missing,
+                               std::filesystem::copy_options::overwrite_existing);
+
+    mmpr::MapReduceJob job(directory.string());
+    job.plan({missing}, 0);
+    std::filesystem::remove(missing);
+    EXPECT_THROW(job.runWorkers(2), std::runtime_error);
+    EXPECT_THROW(job.reduce(), std::runtime_error);
+
+    // the failed worker released its claim, the item is mapped once the file is back
+    std::filesystem::copy_file("tracefiles/example.pcap", missing);
+    EXPECT_EQ(job.work(), 1u);
+    EXPECT_EQ(job.reduce(), summarize(missing));
+
+    std::filesystem::remove(missing);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(MapReduce, StaleClaims) {
+    const std::vector<std::string> files{"tracefiles/example.pcap",
+                                         "tracefiles/pcapng-example.pcapng"};
+    const auto directory = jobDirectory("stale");
+    mmpr::MapReduceJob job(directory.string());
+    job.plan(files, 0);
+
+    // a worker on this host that exited without a summary, e.g. after a SIGKILL
+    const pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+        _exit(0);
+    }
+    ASSERT_EQ(waitpid(pid, nullptr, 0), pid);
+    char host[256] = {};
+    ASSERT_EQ(gethostname(host, sizeof(host) - 1), 0);
+    std::ofstream(directory / "item-000000.claim") << host << ' ' << pid << '\n';
+    // a worker on another host
+    std::ofstream(directory / "item-000001.claim") << "elsewhere 1\n";
+
+    EXPECT_EQ(job.work(), 1u);
+    EXPECT_THROW(job.reduce(), std::runtime_error);
+
+    // claims older than the timeout are taken over
+    std::filesystem::last_write_time(directory / "item-000001.claim",
+                                     std::filesystem::file_time_type::clock::now() -
+                                         std::chrono::hours(2));
+    job.setClaimTimeout(3600);
+    EXPECT_EQ(job.work(), 1u);
+    EXPECT_EQ(job.work(), 0u);
+    mmpr::TraceSummary expected = summarize(files[0]);
+    expected.merge(summarize(files[1]));
+    EXPECT_EQ(job.reduce(), expected);
+
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,139 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/PacketDispatcher.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+
+TEST(PacketDispatcher, SymmetricFlowHash) {
+    // Ethernet + IPv4 + TCP, 10.0.0.1:1234 -> 10.0.0.2:80
+    uint8_t forward[54]{};
+    forward[12] = 0x08;
+    forward[13] = 0x00;
+    forward[14] = 0x45;
+    forward[23] = 6;
+    const uint8_t source[4]{10, 0, 0, 1};
+    const uint8_t destination[4]{10, 0, 0, 2};
+    memcpy(&forward[26], source, 4);
+    memcpy(&forward[30], destination, 4);
+    forward[34] = 0x04;
+    forward[35] = 0xD2;
+    forward[36] = 0x00;
+    forward[37] = 0x50;
+
+    // same flow in the reverse direction
+    uint8_t reverse[54];
+    memcpy(reverse, forward, sizeof(forward));
+    memcpy(&reverse[26], destination, 4);
+    memcpy(&reverse[30], source, 4);
+    reverse[34] = 0x00;
+    reverse[35] = 0x50;
+    reverse[36] = 0x04;
+    reverse[37] = 0xD2;
+
+    // different source port
+    uint8_t other[54];
+    memcpy(other, forward, sizeof(forward));
+    other[35] = 0xD3;
+
+    mmpr::Packet packet;
+    packet.captureLength = sizeof(forward);
+    packet.data = forward;
+    auto forwardHash = mmpr::PacketDispatcher::flowHash(packet, 1);
+    packet.data = reverse;
+    auto reverseHash = mmpr::PacketDispatcher::flowHash(packet, 1);
+    packet.data = other;
+    auto otherHash = mmpr::PacketDispatcher::flowHash(packet, 1);
+
+    ASSERT_EQ(forwardHash, reverseHash);
+    ASSERT_NE(forwardHash, otherHash);
+
+    mmpr::FlowKey forwardKey;
+    mmpr::FlowKey reverseKey;
+    mmpr::FlowKey otherKey;
+    packet.data = forward;
+    ASSERT_TRUE(mmpr::PacketDispatcher::flowKey(packet, 1, forwardKey));
+    packet.data = reverse;
+    ASSERT_TRUE(mmpr::PacketDispatcher::flowKey(packet, 1, reverseKey));
+    packet.data = other;
+    ASSERT_TRUE(mmpr::PacketDispatcher::flowKey(packet, 1, otherKey));
+    ASSERT_EQ(forwardKey, reverseKey);
+    ASSERT_FALSE(forwardKey == otherKey);
+    EXPECT_EQ(forwardKey.lowAddress[15], 1);
+    EXPECT_EQ(forwardKey.lowPort, 1234);
+    EXPECT_EQ(forwardKey.highPort, 80);
+    EXPECT_EQ(forwardKey.protocol, 6);
+
+    // truncated packets must not be read beyond their capture length
+    packet.data = forward;
+    packet.captureLength = 20;
+    ASSERT_EQ(mmpr::PacketDispatcher::flowHash(packet, 1), 0);
+    mmpr::FlowKey truncatedKey;
+    ASSERT_FALSE(mmpr::PacketDispatcher::flowKey(packet, 1, truncatedKey));
+}
+
+TEST(PacketDispatcher, AllPacketsDispatched) {
+    uint64_t expectedPackets{0};
+    uint64_t expectedBytes{0};
+    {
+        mmpr::MMPcapReader reader{"tracefiles/example.pcap"};
+        reader.open();
+        mmpr::Packet packet;
+        while (reader.readNextPacket(packet)) {
+            ++expectedPackets;
+            expectedBytes += packet.captureLength;
+        }
+        reader.close();
+    }
+
+    for (size_t workers : {1, 3, 8}) {
+        mmpr::MMPcapReader reader{"tracefiles/example.pcap"};
+        reader.open();
+
+        mmpr::PacketDispatcher::Config config;
+        config.workers = workers;
+        config.batchSize = 16;
+        config.batchesPerWorker = 4;
+        mmpr::PacketDispatcher dispatcher(reader, config);
+
+        std::atomic<uint64_t> packets{0};
+        std::atomic<uint64_t> bytes{0};
+        std::mutex mutex;
+        std::map<uint32_t, size_t> flowToWorker;
+        bool flowAffinity = true;
+        dispatcher.run([&](size_t worker, const mmpr::Packet& packet) {
+            ++packets;
+            bytes += packet.captureLength;
+            auto hash = mmpr::PacketDispatcher::flowHash(packet, 1);
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = flowToWorker.emplace(hash, worker).first;
+            flowAffinity &= it->second == worker;
+        });
+
+        ASSERT_EQ(packets, expectedPackets) << "workers: " << workers;
+        ASSERT_EQ(bytes, expectedBytes) << "workers: " << workers;
+        ASSERT_TRUE(flowAffinity) << "workers: " << workers;
+        ASSERT_TRUE(reader.isExhausted());
+        reader.close();
+    }
+}
+
+TEST(PacketDispatcher, WorkerExceptionIsRethrown) {
+    mmpr::MMPcapReader reader{"tracefiles/example.pcap"};
+    reader.open();
+
+    mmpr::PacketDispatcher::Config config;
+    config.workers = 2;
+    config.batchSize = 8;
+    config.batchesPerWorker = 2;
+    mmpr::PacketDispatcher dispatcher(reader, config);
+
+    EXPECT_THROW(dispatcher.run([](size_t, const mmpr::Packet&) {
+        throw std::runtime_error("worker failure");
+    }),
+                 std::runtime_error);
+    reader.close();
+}
@@ -0,0 +1,161 @@
+#include "gtest/gtest.h"
+
+#include "CorruptedTrace.h"
+#include "mmpr/mmpr.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+std::vector<uint64_t> readTimestamps(mmpr::FileReader& reader) {
+    std::vector<uint64_t> timestamps;
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet)) {
+        timestamps.push_back(packet.timestamp);
+    }
+    return timestamps;
+}
+
+} // namespace
+
+TEST(PacketRange, ConcreteReaders) {
+    mmpr::MMPcapReader pcapReader("tracefiles/example.pcap");
+    pcapReader.open();
+    auto expected = readTimestamps(pcapReader);
+    pcapReader.close();
+
+    pcapReader.open();
+    std::vector<uint64_t> timestamps;
+    for (const mmpr::Packet& packet : pcapReader.packets()) {
+        timestamps.push_back(packet.timestamp);
+    }
+    pcapReader.close();
+    ASSERT_EQ(timestamps, expected);
+
+    mmpr::MMPcapNgReader pcapNgReader("tracefiles/big-endian.pcapng");
+    pcapNgReader.open();
+    expected = readTimestamps(pcapNgReader);
+    pcapNgReader.close();
+
+    pcapNgReader.open();
+    timestamps.clear();
+    for (const mmpr::Packet& packet : pcapNgReader.packets()) {
+        timestamps.push_back(packet.timestamp);
+    }
+    pcapNgReader.close();
+    ASSERT_EQ(timestamps, expected);
+}
+
+TEST(PacketRange, FileReaderAndResume) {
+    auto reader = mmpr::FileReader::getReader("tracefiles/pcapng-example.pcapng");
+    reader->open();
+    auto expected = readTimestamps(*reader);
+    reader->close();
+
+    reader->open();
+    std::vector<uint64_t> timestamps;
+    for (const mmpr::Packet& packet : reader->packets()) {
+        timestamps.push_back(packet.timestamp);
+        if (timestamps.size() == 10) {
+            break;
+        }
+    }
+    // the range is single pass, a new loop continues after the 10th packet
+    for (const mmpr::Packet& packet : reader->packets()) {
+        timestamps.push_back(packet.timestamp);
+    }
+    reader->close();
+    ASSERT_EQ(timestamps, expected);
+}
+
+// the following tests are only compiled into mmpr_test_cxx20
+
+#if defined(__cpp_lib_ranges)
+static_assert(std::ranges::view<mmpr::PacketRange<mmpr::MMPcapReader>>);
+static_assert(std::ranges::input_range<mmpr::PacketRange<mmpr::FileReader>>);
+
+TEST(PacketRange, ComposesWithViews) {
+    mmpr::MMPcapReader reader("tracefiles/example.pcap");
+    reader.open();
+    std::vector<uint64_t> expected;
+    mmpr::Packet packet;
+    while (reader.readNextPacket(packet) && expected.size() < 20) {
+        if (packet.length > 1000) {
+            expected.push_back(packet.timestamp);
+        }
+    }
+    reader.close();
+    ASSERT_EQ(expected.size(), 20u);
+
+    reader.open();
+    auto isLarge = [](const mmpr::Packet& packet) { return packet.length > 1000; };
+    auto timestampOf = [](const mmpr::Packet& packet) { return packet.timestamp; };
+    auto timestamps = reader.packets() | std::views::filter(isLarge) |
+                      std::views::transform(timestampOf) | std::views::take(20);
+    std::vector<uint64_t> result;
+    for (uint64_t timestamp : timestamps) {
+        result.push_back(timestamp);
+    }
+    reader.close();
+    ASSERT_EQ(result, expected);
+}
+#endif
+
+#ifdef MMPR_HAS_COROUTINES
+TEST(PacketGenerator, YieldsRemainingPackets) {
+    mmpr::MMPcapReader pcapReader("tracefiles/example.pcap");
+    pcapReader.open();
+    auto expected = readTimestamps(pcapReader);
+    pcapReader.close();
+
+    pcapReader.open();
+    std::vector<uint64_t> timestamps;
+    for (const mmpr::Packet& packet : mmpr::generatePackets(pcapReader)) {
+        timestamps.push_back(packet.timestamp);
+    }
+    pcapReader.close();
+    ASSERT_EQ(timestamps, expected);
+
+    auto reader = mmpr::FileReader::getReader("tracefiles/pcapng-example.pcapng");
+    reader->open();
+    expected = readTimestamps(*reader);
+    reader->close();
+
+    reader->open();
+    timestamps.clear();
+    {
+        // destroying a suspended generator stops reading
+        mmpr::PacketGenerator generator = mmpr::generatePackets(*reader);
+        for (const mmpr::Packet& packet : generator) {
+            timestamps.push_back(packet.timestamp);
+            if (timestamps.size() == 10) {
+                break;
+            }
+        }
+    }
+    for (const mmpr::Packet& packet : mmpr::generatePackets(*reader)) {
+        timestamps.push_back(packet.timestamp);
+    }
+    reader->close();
+    ASSERT_EQ(timestamps, expected);
+}
+
+TEST(PacketGenerator, RethrowsParserErrors) {
+    mmpr::CorruptedTrace trace("tracefiles/example.pcap");
+    trace.truncate(trace.size() - 10);
+    mmpr::MMPcapReader reader(trace.save());
+    reader.open();
+    size_t packets{0};
+    auto countPackets = [&] {
+        for (const mmpr::Packet& packet : mmpr::generatePackets(reader)) {
+            MMPR_UNUSED(packet);
+            ++packets;
+        }
+    };
+    EXPECT_THROW(countPackets(), std::runtime_error);
+    EXPECT_EQ(packets, 4630u);
+    reader.close();
+}
+#endif
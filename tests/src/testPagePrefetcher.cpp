@@ -0,0 +1,167 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/PagePrefetcher.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include <chrono>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+size_t roundUpToPage(size_t value) {
+    const size_t pageSize = mmpr::FileReader::getPageSize();
+    return (value + pageSize - 1) / pageSize * pageSize;
+}
+
+/**
+ * Waits up to 10 s until bytes are prefetched and stops the prefetcher.
+ */
+void waitForPrefetch(mmpr::PagePrefetcher& prefetcher, size_t bytes) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (prefetcher.getStats().bytesPrefetched < bytes &&
+           std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    prefetcher.stop();
+}
+
+/**
+ * Writes the file back and drops its pages from the page cache, as far as the kernel
+ * allows. Pages still mapped by a reader stay.
+ */
+void evictFromPageCache(const std::string& filepath) {
+    int fd = open(filepath.c_str(), O_RDONLY);
+    ASSERT_GE(fd, 0);
+    fsync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+size_t missingPages(const mmpr::FileReader& reader) {
+    const size_t pageSize = mmpr::FileReader::getPageSize();
+    const size_t pages = roundUpToPage(reader.getFileSize()) / pageSize;
+    std::vector<unsigned char> residency(pages);
+    if (mincore((void*)reader.getMappedMemory(), reader.getFileSize(),
+                residency.data()) != 0) {
+        return 0;
+    }
+    size_t missing = 0;
+    for (unsigned char page : residency) {
+        missing += (page & 1) == 0;
+    }
+    return missing;
+}
+
+} // namespace
+
+TEST(PagePrefetcher, PrefetchesWholeFile) {
+    for (auto method : {mmpr::PagePrefetcher::POPULATE_READ,
+                        mmpr::PagePrefetcher::WILLNEED, mmpr::PagePrefetcher::READAHEAD}) {
+        mmpr::MMPcapReader reader("tracefiles/example.pcap");
+        reader.open();
+
+        mmpr::PagePrefetcher::Config config;
+        config.window = reader.getFileSize();
+        config.chunkSize = 64 * 1024;
+        config.method = method;
+        mmpr::PagePrefetcher prefetcher(reader, config);
+
+        // the parser does not move, the whole file fits into the window
+        const size_t expected = roundUpToPage(reader.getFileSize());
+        waitForPrefetch(prefetcher, expected);
+        ASSERT_EQ(prefetcher.getStats().bytesPrefetched, expected) << "method " << method;
+
+        reader.close();
+    }
+}
+
+TEST(PagePrefetcher, CountsFaultsAvoided) {
+    // a copy no other test has mapped
+    const std::string filepath =
+        (std::filesystem::temp_directory_path() /
+         ("mmpr-prefetch-" + std::to_string(getpid()) + ".pcap"))
+            .string();
+    std::filesystem::copy_file("tracefiles/example.pcap", filepath,
+                               std::filesystem::copy_options::overwrite_existing);
+    evictFromPageCache(filepath);
+    mmpr::MMPcapReader reader(filepath);
+    reader.open();
+    const size_t missing = missingPages(reader);
+
+    mmpr::PagePrefetcher::Config config;
+    config.window = reader.getFileSize();
+    config.chunkSize = mmpr::FileReader::getPageSize();
+    mmpr::PagePrefetcher prefetcher(reader, config);
+    const size_t expected = roundUpToPage(reader.getFileSize());
+    waitForPrefetch(prefetcher, expected);
+    reader.close();
+
+    // nothing to avoid once the file is resident
+    reader.open();
+    mmpr::PagePrefetcher resident(reader, config);
+    waitForPrefetch(resident, expected);
+    reader.close();
+    std::filesystem::remove(filepath);
+    EXPECT_EQ(resident.getStats().faultsAvoided, 0u);
+
+    // the kernel may read ahead of the prefetcher, pages it loaded are not counted
+    EXPECT_LE(prefetcher.getStats().faultsAvoided, missing);
+    if (missing == 0) {
+        GTEST_SKIP() << "the trace could not be evicted from the page cache";
+    }
+    EXPECT_GT(prefetcher.getStats().faultsAvoided, 0u);
+}
+
+TEST(PagePrefetcher, ReadaheadUsesMappedFile) {
+    // the path of a reader created from a descriptor does not have to name its file
+    int fd = open("tracefiles/example.pcap", O_RDONLY);
+    ASSERT_GE(fd, 0);
+    auto reader = mmpr::FileReader::getReader(fd, "missing-file.pcap");
+    reader->open();
+    ASSERT_GE(reader->getMappedFileDescriptor(), 0);
+
+    mmpr::PagePrefetcher::Config config;
+    config.window = reader->getFileSize();
+    config.method = mmpr::PagePrefetcher::READAHEAD;
+    mmpr::PagePrefetcher prefetcher(*reader, config);
+    const size_t expected = roundUpToPage(reader->getFileSize());
+    waitForPrefetch(prefetcher, expected);
+    EXPECT_EQ(prefetcher.getStats().bytesPrefetched, expected);
+    reader->close();
+}
+
+TEST(PagePrefetcher, FollowsParser) {
+    mmpr::MMPcapReader reader("tracefiles/example.pcap");
+    reader.open();
+
+    mmpr::PagePrefetcher::Config config;
+    config.window = 256 * 1024;
+    config.chunkSize = 16 * 1024;
+    mmpr::PagePrefetcher prefetcher(reader, config);
+
+    mmpr::Packet packet;
+    size_t packets{0};
+    while (reader.readNextPacket(packet)) {
+        prefetcher.advance(reader.getCurrentOffset());
+        ++packets;
+    }
+    prefetcher.stop();
+    reader.close();
+
+    ASSERT_GT(packets, 0);
+    // never more than the file, regardless of how far the helper thread got
+    ASSERT_LE(prefetcher.getStats().bytesPrefetched, roundUpToPage(reader.getFileSize()));
+}
+
+#ifdef MMPR_USE_ZSTD
+TEST(PagePrefetcher, RequiresMappedReader) {
+    auto reader = mmpr::FileReader::getReader("tracefiles/pcapng-example.pcapng.zst");
+    reader->open();
+    ASSERT_THROW(mmpr::PagePrefetcher prefetcher(*reader), std::runtime_error);
+    reader->close();
+}
+#endif
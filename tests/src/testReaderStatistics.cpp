@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/mmpr.h"
+#include "mmpr/forEachPacket.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+
+namespace {
+
+mmpr::ReaderStatistics readAll(mmpr::FileReader& reader) {
+    mmpr::Packet packet;
+    while (!reader.isExhausted()) {
+        reader.readNextPacket(packet);
+    }
+    mmpr::ReaderStatistics statistics = reader.getStatistics();
+    reader.close();
+    return statistics;
+}
+
+} // namespace
+
+TEST(ReaderStatistics, DisabledByDefault) {
+    auto reader = mmpr::FileReader::getReader("tracefiles/pcapng-example.pcapng");
+    reader->open();
+    const mmpr::ReaderStatistics statistics = readAll(*reader);
+    EXPECT_EQ(statistics.packets, 0);
+    EXPECT_TRUE(statistics.blocks.empty());
+}
+
+TEST(ReaderStatistics, Pcap) {
+    auto reader = mmpr::FileReader::getReader("tracefiles/example.pcap");
+    reader->setStatisticsEnabled(true);
+    reader->open();
+    const mmpr::ReaderStatistics statistics = readAll(*reader);
+    EXPECT_EQ(statistics.packets, 4631);
+    EXPECT_GT(statistics.capturedBytes, 0);
+    EXPECT_GE(statistics.bytes, statistics.capturedBytes);
+    EXPECT_TRUE(statistics.blocks.empty());
+    EXPECT_EQ(statistics.skippedBytes, 0);
+    EXPECT_GT(statistics.parsingNanoseconds, 0);
+    EXPECT_EQ(statistics.mappedBytes, reader->getFileSize());
+    EXPECT_LE(statistics.residentBytes, statistics.mappedBytes);
+}
+
+TEST(ReaderStatistics, PcapNGBlocks) {
+    auto reader = mmpr::FileReader::getReader("tracefiles/many_interfaces-1.pcapng");
+    reader->setStatisticsEnabled(true);
+    reader->open();
+    const mmpr::ReaderStatistics statistics = readAll(*reader);
+    EXPECT_EQ(statistics.packets, 64);
+    EXPECT_EQ(statistics.blocks.at(MMPR_SECTION_HEADER_BLOCK), 1);
+    EXPECT_EQ(statistics.blocks.at(MMPR_ENHANCED_PACKET_BLOCK), 64);
+    EXPECT_GT(statistics.blocks.at(MMPR_INTERFACE_DESCRIPTION_BLOCK), 1);
+}
+
+TEST(ReaderStatistics, PcapNGSections) {
+    // 16 packets in a little-endian and 4 in a big-endian section
+    mmpr::MMPcapNgReader reader("tracefiles/epb-options.pcapng");
+    reader.setStatisticsEnabled(true);
+    reader.open();
+    size_t packets = 0;
+    mmpr::forEachPacket(reader, [&](const mmpr::Packet&) { ++packets; });
+    const mmpr::ReaderStatistics statistics = reader.getStatistics();
+    reader.close();
+    EXPECT_EQ(packets, 20);
+    EXPECT_EQ(statistics.packets, 20);
+    EXPECT_EQ(statistics.blocks.at(MMPR_SECTION_HEADER_BLOCK), 2);
+    EXPECT_EQ(statistics.blocks.at(MMPR_ENHANCED_PACKET_BLOCK), 20);
+}
+
+TEST(ReaderStatistics, ResetOnOpen) {
+    auto reader = mmpr::FileReader::getReader("tracefiles/simple-packet-blocks.pcapng");
+    reader->setStatisticsEnabled(true);
+    reader->open();
+    readAll(*reader);
+    reader->open();
+    const mmpr::ReaderStatistics statistics = readAll(*reader);
+    EXPECT_EQ(statistics.packets, 64);
+    EXPECT_EQ(statistics.blocks.at(MMPR_SIMPLE_PACKET_BLOCK), 64);
+}
+
+TEST(ReaderStatistics, Json) {
+    mmpr::ReaderStatistics statistics;
+    statistics.packets = 2;
+    statistics.blocks[MMPR_ENHANCED_PACKET_BLOCK] = 2;
+    statistics.blocks[0x12345678] = 1;
+    const std::string json = statistics.toJson();
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_EQ(json.back(), '}');
+    EXPECT_NE(json.find("\"packets\":2"), std::string::npos);
+    EXPECT_NE(json.find("\"blocks\":{\"enhanced_packet\":2,\"0x12345678\":1}"),
+              std::string::npos);
+    EXPECT_NE(json.find("\"resident_bytes\":0"), std::string::npos);
+}
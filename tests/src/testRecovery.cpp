@@ -0,0 +1,142 @@
+#include "gtest/gtest.h"
+
+#include "CorruptedTrace.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include "mmpr/pcapng/MMPcapNgReader.h"
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+template <typename Reader>
+size_t countPackets(Reader& reader) {
+    reader.setRecovery(true);
+    reader.open();
+    size_t packets{0};
+    mmpr::Packet packet;
+    while (!reader.isExhausted()) {
+        if (reader.readNextPacket(packet)) {
+            ++packets;
+        }
+    }
+    reader.close();
+    return packets;
+}
+
+} // namespace
+
+TEST(Recovery, ValidTracesSkipNothing) {
+    mmpr::MMPcapReader pcapReader("tracefiles/example.pcap");
+    EXPECT_EQ(countPackets(pcapReader), 4631);
+    EXPECT_TRUE(pcapReader.getSkippedRanges().empty());
+
+    mmpr::MMPcapNgReader pcapngReader("tracefiles/pcapng-example.pcapng");
+    EXPECT_EQ(countPackets(pcapngReader), 159);
+    EXPECT_TRUE(pcapngReader.getSkippedRanges().empty());
+}
+
+TEST(Recovery, PcapZeroedRegion) {
+    mmpr::CorruptedTrace trace("tracefiles/example.pcap");
+    const size_t start = trace.size() / 2;
+    trace.zero(start, 4096);
+
+    mmpr::MMPcapReader reader(trace.save());
+    const size_t packets = countPackets(reader);
+    EXPECT_GT(packets, 4000);
+    EXPECT_LT(packets, 4631);
+    const auto& skipped = reader.getSkippedRanges();
+    ASSERT_EQ(skipped.size(), 1);
+    // the region starts within a packet, the first damaged record header follows it
+    EXPECT_GT(skipped[0].offset, start - 2000);
+    EXPECT_LT(skipped[0].offset, start + 4096);
+    EXPECT_GE(skipped[0].offset + skipped[0].length, start + 4096);
+    EXPECT_EQ(skipped[0].reason, "implausible packet record");
+}
+
+TEST(Recovery, PcapTruncatedRecord) {
+    mmpr::CorruptedTrace trace("tracefiles/example.pcap");
+    trace.truncate(trace.size() - 10);
+
+    mmpr::MMPcapReader reader(trace.save());
+    EXPECT_EQ(countPackets(reader), 4630);
+    const auto& skipped = reader.getSkippedRanges();
+    ASSERT_EQ(skipped.size(), 1);
+    EXPECT_EQ(skipped[0].offset + skipped[0].length, trace.size());
+}
+
+TEST(Recovery, PcapNgZeroedRegion) {
+    mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+    const size_t start = trace.size() / 2;
+    trace.zero(start, 1024);
+
+    {
+        // without recovery, the corruption is an error
+        mmpr::MMPcapNgReader reader(trace.save());
+        reader.open();
+        mmpr::Packet packet;
+        EXPECT_THROW(
+            while (!reader.isExhausted()) { reader.readNextPacket(packet); },
+            std::runtime_error);
+        reader.close();
+    }
+
+    mmpr::MMPcapNgReader reader(trace.save());
+    const size_t packets = countPackets(reader);
+    EXPECT_GT(packets, 100);
+    EXPECT_LT(packets, 159);
+    const auto& skipped = reader.getSkippedRanges();
+    ASSERT_EQ(skipped.size(), 1);
+    EXPECT_LE(skipped[0].offset, start);
+    EXPECT_GE(skipped[0].offset + skipped[0].length, start + 1024);
+    EXPECT_FALSE(skipped[0].reason.empty());
+}
+
+TEST(Recovery, PcapNgWithoutValidation) {
+    mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+    trace.zero(trace.size() / 2, 1024);
+
+    mmpr::MMPcapNgReader cheap(trace.save());
+    const size_t packets = countPackets(cheap);
+
+    // recovery validates blocks also if validation is turned off
+    mmpr::MMPcapNgReader reader(trace.save());
+    reader.setValidationLevel(mmpr::ValidationLevel::NONE);
+    EXPECT_EQ(countPackets(reader), packets);
+    EXPECT_EQ(reader.getValidationLevel(), mmpr::ValidationLevel::NONE);
+    ASSERT_EQ(reader.getSkippedRanges().size(), 1);
+    EXPECT_EQ(reader.getSkippedRanges()[0].offset, cheap.getSkippedRanges()[0].offset);
+    EXPECT_EQ(reader.getSkippedRanges()[0].length, cheap.getSkippedRanges()[0].length);
+}
+
+TEST(Recovery, PcapZeroCaptureLength) {
+    // records without captured bytes, e.g. of a snapshot length of 0, are valid
+    const std::string filepath = (std::filesystem::temp_directory_path() /
+                                  ("mmpr-zero-capture-" + std::to_string(getpid()) +
+                                   ".pcap"))
+                                     .string();
+    {
+        const uint32_t words[]{0xA1B2C3D4, 0x00040002, 0, 0, 0, 1,
+                               // timestamp, captured and original length
+                               1600000000, 0, 0, 60, 1600000000, 1, 4, 4, 0xDEADBEEF};
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(words), sizeof(words));
+    }
+
+    mmpr::MMPcapReader reader(filepath);
+    EXPECT_EQ(countPackets(reader), 2);
+    EXPECT_TRUE(reader.getSkippedRanges().empty());
+    std::filesystem::remove(filepath);
+}
+
+TEST(Recovery, PcapNgTruncatedBlock) {
+    mmpr::CorruptedTrace trace("tracefiles/pcapng-example.pcapng");
+    trace.truncate(trace.size() - 10);
+
+    mmpr::MMPcapNgReader reader(trace.save());
+    countPackets(reader);
+    const auto& skipped = reader.getSkippedRanges();
+    ASSERT_EQ(skipped.size(), 1);
+    EXPECT_EQ(skipped[0].offset + skipped[0].length, trace.size());
+}
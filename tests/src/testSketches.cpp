@@ -0,0 +1,187 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/CountMinSketch.h"
+#include "mmpr/HeavyHitters.h"
+#include "mmpr/HyperLogLog.h"
+#include "mmpr/PacketDispatcher.h"
+#include "mmpr/TrafficSketches.h"
+#include "mmpr/pcap/MMPcapReader.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+
+namespace {
+
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+mmpr::HeavyHitters::Key keyOf(uint64_t value) {
+    mmpr::HeavyHitters::Key key{};
+    for (int i = 0; i < 8; ++i) {
+        key[15 - i] = (uint8_t)(value >> (8 * i));
+    }
+    return key;
+}
+
+} // namespace
+
+TEST(HyperLogLog, Estimates) {
+    mmpr::HyperLogLog empty;
+    EXPECT_EQ(empty.estimate(), 0);
+
+    for (uint64_t cardinality : {10ull, 1000ull, 100000ull, 2000000ull}) {
+        mmpr::HyperLogLog sketch;
+        for (uint64_t i = 0; i < cardinality; ++i) {
+            sketch.add(mix64(i));
+            // duplicates do not count
+            sketch.add(mix64(i / 2));
+        }
+        // 4 standard errors of 0.8%
+        EXPECT_NEAR(sketch.estimate(), cardinality, cardinality * 0.033) << cardinality;
+    }
+}
+
+TEST(HyperLogLog, MergeEqualsAddingEverything) {
+    mmpr::HyperLogLog all;
+    mmpr::HyperLogLog first;
+    mmpr::HyperLogLog second;
+    for (uint64_t i = 0; i < 50000; ++i) {
+        all.add(mix64(i));
+        (i < 30000 ? first : second).add(mix64(i));
+    }
+    mmpr::HyperLogLog merged = second;
+    merged.merge(first);
+    EXPECT_EQ(merged, all);
+    EXPECT_NEAR(merged.estimate(), 50000, 50000 * 0.033);
+}
+
+TEST(CountMinSketch, NeverUndercounts) {
+    EXPECT_THROW(mmpr::CountMinSketch(1000), std::invalid_argument);
+
+    mmpr::CountMinSketch sketch(1024);
+    std::mt19937_64 random(3);
+    std::map<uint64_t, uint64_t> counts;
+    uint64_t total = 0;
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t key = random() % 5000;
+        const uint64_t weight = 1 + random() % 1500;
+        counts[key] += weight;
+        total += weight;
+        const uint64_t estimate = sketch.add(mix64(key), weight);
+        EXPECT_EQ(estimate, sketch.estimate(mix64(key)));
+    }
+    for (const auto& [key, count] : counts) {
+        const uint64_t estimate = sketch.estimate(mix64(key));
+        ASSERT_GE(estimate, count);
+        // e / width of the total with high probability
+        EXPECT_LE(estimate - count, total * std::exp(1.0) / 1024);
+    }
+
+    mmpr::CountMinSketch other(1024);
+    other.add(mix64(1), 10);
+    const uint64_t before = sketch.estimate(mix64(1));
+    sketch.merge(other);
+    EXPECT_EQ(sketch.estimate(mix64(1)), before + 10);
+    EXPECT_THROW(sketch.merge(mmpr::CountMinSketch(2048)), std::invalid_argument);
+}
+
+TEST(HeavyHitters, FindsTopKeysOfSkewedStream) {
+    // Zipf-like stream, key k has weight proportional to 1 / (k + 1)
+    std::vector<uint64_t> stream;
+    for (uint64_t key = 0; key < 20000; ++key) {
+        for (uint64_t n = 0; n < 20000 / (key + 1); ++n) {
+            stream.push_back(key);
+        }
+    }
+    std::shuffle(stream.begin(), stream.end(), std::mt19937_64(11));
+
+    mmpr::HeavyHitters all(32);
+    mmpr::HeavyHitters parts[2] = {mmpr::HeavyHitters(32), mmpr::HeavyHitters(32)};
+    for (size_t i = 0; i < stream.size(); ++i) {
+        all.add(keyOf(stream[i]), mix64(stream[i]), 1);
+        parts[i % 2].add(keyOf(stream[i]), mix64(stream[i]), 1);
+    }
+
+    for (const mmpr::HeavyHitters* heavyHitters : {&all, &parts[0]}) {
+        ASSERT_EQ(heavyHitters->top().size(), 32u);
+    }
+    mmpr::HeavyHitters merged = parts[0];
+    merged.merge(parts[1]);
+    mmpr::HeavyHitters reversed = parts[1];
+    reversed.merge(parts[0]);
+
+    for (const mmpr::HeavyHitters* heavyHitters : {&all, &merged}) {
+        const auto top = heavyHitters->top();
+        // the five heaviest keys in order, with counts at or slightly above the truth
+        for (uint64_t key = 0; key < 5; ++key) {
+            EXPECT_EQ(top[key].key, keyOf(key));
+            EXPECT_GE(top[key].count, 20000 / (key + 1));
+            EXPECT_LE(top[key].count, 20000 / (key + 1) + stream.size() / 500);
+        }
+    }
+    const auto mergedTop = merged.top();
+    const auto reversedTop = reversed.top();
+    ASSERT_EQ(mergedTop.size(), reversedTop.size());
+    for (size_t i = 0; i < mergedTop.size(); ++i) {
+        EXPECT_EQ(mergedTop[i].key, reversedTop[i].key);
+        EXPECT_EQ(mergedTop[i].count, reversedTop[i].count);
+    }
+
+    EXPECT_THROW(all.merge(mmpr::HeavyHitters(16)), std::invalid_argument);
+    EXPECT_THROW(mmpr::HeavyHitters(0), std::invalid_argument);
+}
+
+TEST(TrafficSketches, SourcesOfTrace) {
+    mmpr::MMPcapReader reader("tracefiles/example.pcap");
+    reader.open();
+    mmpr::TrafficSketches sketches(16);
+    std::map<std::string, uint64_t> bytes;
+    std::set<uint32_t> flows;
+    mmpr::Packet packet;
+    while (!reader.isExhausted()) {
+        if (reader.readNextPacket(packet)) {
+            sketches.record(packet, reader.getDataLinkType());
+            mmpr::HeavyHitters::Key source;
+            if (mmpr::PacketDispatcher::sourceAddress(packet, reader.getDataLinkType(),
+                                                      source)) {
+                bytes[mmpr::TrafficSketches::formatAddress(source)] += packet.length;
+                flows.insert(mmpr::PacketDispatcher::flowHash(packet,
+                                                              reader.getDataLinkType()));
+            }
+        }
+    }
+    reader.close();
+    ASSERT_FALSE(bytes.empty());
+
+    EXPECT_NEAR(sketches.getDistinctSources().estimate(), bytes.size(),
+                bytes.size() * 0.05 + 1);
+    EXPECT_NEAR(sketches.getDistinctFlows().estimate(), flows.size(),
+                flows.size() * 0.05 + 1);
+
+    // the largest source by bytes, with exact counts on such a small trace
+    auto largest = bytes.begin();
+    for (auto it = bytes.begin(); it != bytes.end(); ++it) {
+        largest = it->second > largest->second ? it : largest;
+    }
+    const auto top = sketches.getSourcesByBytes().top();
+    ASSERT_FALSE(top.empty());
+    EXPECT_EQ(mmpr::TrafficSketches::formatAddress(top[0].key), largest->first);
+    EXPECT_EQ(top[0].count, largest->second);
+
+    mmpr::HeavyHitters::Key v6{};
+    v6[0] = 0x20;
+    v6[1] = 0x01;
+    v6[2] = 0x0d;
+    v6[3] = 0xb8;
+    v6[15] = 1;
+    EXPECT_EQ(mmpr::TrafficSketches::formatAddress(v6), "2001:db8::1");
+}
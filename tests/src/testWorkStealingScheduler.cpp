@@ -0,0 +1,97 @@
+#include "gtest/gtest.h"
+
+#include "mmpr/WorkStealingScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(WorkStealingScheduler, RunsEveryTaskOnce) {
+    std::vector<uint64_t> weights;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        weights.push_back(i % 17);
+    }
+    std::vector<std::atomic<int>> runs(weights.size());
+
+    mmpr::WorkStealingScheduler scheduler(4);
+    scheduler.run(weights, [&](size_t task, size_t thread) {
+        ASSERT_LT(thread, 4u);
+        ++runs[task];
+    });
+    for (const auto& count : runs) {
+        EXPECT_EQ(count, 1);
+    }
+
+    // the scheduler can be reused
+    scheduler.run(weights, [&](size_t task, size_t) { ++runs[task]; });
+    for (const auto& count : runs) {
+        EXPECT_EQ(count, 2);
+    }
+}
+
+TEST(WorkStealingScheduler, HeaviestTasksFirst) {
+    const std::vector<uint64_t> weights{5, 100, 1, 50, 50};
+    std::vector<size_t> order;
+
+    mmpr::WorkStealingScheduler scheduler(1);
+    scheduler.run(weights, [&](size_t task, size_t) { order.push_back(task); });
+
+    // ties keep the input order
+    EXPECT_EQ(order, (std::vector<size_t>{1, 3, 4, 0, 2}));
+    EXPECT_EQ(scheduler.getStolenTasks(), std::vector<uint64_t>{0});
+}
+
+TEST(WorkStealingScheduler, IdleThreadsSteal) {
+    // thread 0 blocks on its first task until the other thread ran all remaining tasks,
+    // half of which were dealt to thread 0
+    const std::vector<uint64_t> weights(9, 1);
+    std::atomic<size_t> finished{0};
+    std::mutex mutex;
+    std::vector<size_t> tasksOfThread(2, 0);
+
+    mmpr::WorkStealingScheduler scheduler(2);
+    scheduler.run(weights, [&](size_t task, size_t thread) {
+        if (task == 0) {
+            while (finished < weights.size() - 1) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        ++tasksOfThread[thread];
+        ++finished;
+    });
+
+    EXPECT_EQ(tasksOfThread[0], 1u);
+    EXPECT_EQ(tasksOfThread[1], 8u);
+    EXPECT_EQ(scheduler.getStolenTasks()[1], 4u);
+}
+
+TEST(WorkStealingScheduler, MoreThreadsThanTasks) {
+    std::atomic<int> runs{0};
+    mmpr::WorkStealingScheduler scheduler(8);
+    scheduler.run({3, 2}, [&](size_t, size_t) { ++runs; });
+    EXPECT_EQ(runs, 2);
+
+    scheduler.run({}, [&](size_t, size_t) { ++runs; });
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(WorkStealingScheduler, RethrowsTaskException) {
+    const std::vector<uint64_t> weights(100, 1);
+    std::atomic<int> runs{0};
+
+    mmpr::WorkStealingScheduler scheduler(4);
+    EXPECT_THROW(scheduler.run(weights,
+                               [&](size_t task, size_t) {
+                                   ++runs;
+                                   if (task == 10) {
+                                       throw std::runtime_error("failed");
+                                   }
+                               }),
+                 std::runtime_error);
+    EXPECT_LE(runs, 100);
+
+    EXPECT_THROW(mmpr::WorkStealingScheduler(0), std::invalid_argument);
+}